@@ -0,0 +1,626 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hash table workload benchmark.
+//
+// Each workload is a set of distinct keys and a sequence of lookups of those
+// keys that follows a Zipfian distribution. The lookups are replayed through a
+// hash table that is hashed in one of several ways: with a SimdHwyHash_Hash64
+// call per lookup, with the batch hashing functions, with a simdhwyhash hasher
+// for std::unordered_map, and with std::hash, which is the non-keyed baseline
+// that the keyed hashes are compared against.
+
+namespace simdhwyhash {
+namespace bench {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static constexpr size_t kDefaultNumKeys = 1000000;
+static constexpr size_t kDefaultNumLookups = 4000000;
+static constexpr double kDefaultZipfExponent = 0.99;
+
+// Number of lookups that are hashed together in the batch mode
+static constexpr size_t kBatchSize = 64;
+
+// Number of hash calls that are timed one by one to find the percentiles of
+// the hash latency
+static constexpr size_t kNumLatencySamples = 100000;
+
+using Clock = std::chrono::steady_clock;
+
+static volatile uint64_t g_sink;
+
+static inline double ElapsedNanos(Clock::time_point start,
+                                  Clock::time_point end) {
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static inline uint64_t SimdHwyHashKey(std::string_view key) {
+  return SimdHwyHash_Hash64(key.data(), key.size(), kKey);
+}
+
+// Hashes the 8-byte little-endian encoding of key, which is what
+// SimdHwyHash_HashU64Keys64 hashes
+static inline uint64_t SimdHwyHashKey(uint64_t key) {
+  uint8_t bytes[8];
+  for (size_t i = 0; i < 8; i++) {
+    bytes[i] = static_cast<uint8_t>(key >> (i * 8));
+  }
+  return SimdHwyHash_Hash64(bytes, sizeof(bytes), kKey);
+}
+
+static void SimdHwyHashKeys(const std::string_view* keys, size_t num_keys,
+                            uint64_t* hashes) {
+  const void* ptrs[kBatchSize];
+  size_t byte_lens[kBatchSize];
+  for (size_t i = 0; i < num_keys; i++) {
+    ptrs[i] = keys[i].data();
+    byte_lens[i] = keys[i].size();
+  }
+  SimdHwyHash_Hash64Batch(ptrs, byte_lens, num_keys, kKey, hashes);
+}
+
+static void SimdHwyHashKeys(const uint64_t* keys, size_t num_keys,
+                            uint64_t* hashes) {
+  SimdHwyHash_HashU64Keys64(keys, num_keys, kKey, hashes);
+}
+
+// Hasher for the standard unordered containers that hashes keys with
+// simdhwyhash, in the way that an application would wrap simdhwyhash
+struct SimdHwyHasher {
+  size_t operator()(std::string_view key) const {
+    return static_cast<size_t>(SimdHwyHashKey(key));
+  }
+  size_t operator()(uint64_t key) const {
+    return static_cast<size_t>(SimdHwyHashKey(key));
+  }
+};
+
+// Open-addressing table of the indices of the keys, which is probed linearly
+// from the low bits of the hash of the key
+template <class KeyT>
+class FlatTable {
+ public:
+  static constexpr uint32_t kNotFound = 0xFFFFFFFFu;
+
+  explicit FlatTable(const std::vector<KeyT>& keys) : keys_(keys) {
+    size_t capacity = 16;
+    while (capacity < keys.size() * 2) {
+      capacity *= 2;
+    }
+    mask_ = capacity - 1;
+    slots_.assign(capacity, Slot{0, kNotFound});
+  }
+
+  void Insert(uint64_t hash, uint32_t key_index) {
+    for (size_t i = static_cast<size_t>(hash) & mask_;; i = (i + 1) & mask_) {
+      if (slots_[i].key_index == kNotFound) {
+        slots_[i] = Slot{hash, key_index};
+        return;
+      }
+    }
+  }
+
+  uint32_t Find(uint64_t hash, const KeyT& key) const {
+    for (size_t i = static_cast<size_t>(hash) & mask_;; i = (i + 1) & mask_) {
+      const Slot& slot = slots_[i];
+      if (slot.key_index == kNotFound ||
+          (slot.hash == hash && keys_[slot.key_index] == key)) {
+        return slot.key_index;
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    uint64_t hash;
+    uint32_t key_index;
+  };
+
+  const std::vector<KeyT>& keys_;
+  std::vector<Slot> slots_;
+  size_t mask_;
+};
+
+enum class Mode { kPerCall, kBatch, kHasher, kBaseline, kBaselineHasher };
+
+static constexpr Mode kModes[] = {Mode::kPerCall, Mode::kBatch, Mode::kHasher,
+                                  Mode::kBaseline, Mode::kBaselineHasher};
+
+static const char* ModeName(Mode mode) {
+  switch (mode) {
+    case Mode::kPerCall:
+      return "per-call";
+    case Mode::kBatch:
+      return "batch";
+    case Mode::kHasher:
+      return "hasher";
+    case Mode::kBaseline:
+      return "baseline";
+    case Mode::kBaselineHasher:
+      return "baseline-hasher";
+  }
+  return "";
+}
+
+// Counts the hardware cache misses of the calling thread with
+// perf_event_open, if the kernel and the CPU allow it
+struct CacheMissCounter {
+  int fd;
+};
+
+static CacheMissCounter OpenCacheMissCounter() {
+  CacheMissCounter counter{-1};
+#if defined(__linux__)
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  counter.fd =
+      static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  return counter;
+}
+
+static void CloseCacheMissCounter(CacheMissCounter* counter) {
+#if defined(__linux__)
+  if (counter->fd >= 0) {
+    close(counter->fd);
+  }
+#endif
+  counter->fd = -1;
+}
+
+static void StartCacheMissCounter(const CacheMissCounter& counter) {
+#if defined(__linux__)
+  if (counter.fd >= 0) {
+    ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)counter;
+#endif
+}
+
+// Returns false if the number of cache misses is not available
+static bool StopCacheMissCounter(const CacheMissCounter& counter,
+                                 uint64_t* num_misses) {
+#if defined(__linux__)
+  if (counter.fd >= 0) {
+    ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    return read(counter.fd, num_misses, sizeof(uint64_t)) ==
+           static_cast<ssize_t>(sizeof(uint64_t));
+  }
+#else
+  (void)counter;
+  (void)num_misses;
+#endif
+  return false;
+}
+
+struct WorkloadResult {
+  double lookups_per_sec;
+  double p50_latency_nanos;
+  double p99_latency_nanos;
+  bool have_cache_misses;
+  double cache_misses_per_lookup;
+  bool correct;
+};
+
+// Returns the p50 and p99 latencies, in nanoseconds per key, of num_calls
+// calls of func(call_index), each of which hashes keys_per_call keys
+template <class Func>
+static void MeasureLatency(size_t num_calls, size_t keys_per_call,
+                           const Func& func, double* p50, double* p99) {
+  // The time that it takes to read the clock is subtracted from each sample
+  double clock_overhead = 1e30;
+  for (size_t i = 0; i < 1000; i++) {
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = Clock::now();
+    clock_overhead = std::min(clock_overhead, ElapsedNanos(start, end));
+  }
+
+  if (num_calls == 0) {
+    *p50 = 0;
+    *p99 = 0;
+    return;
+  }
+
+  std::vector<double> samples(num_calls);
+  for (size_t i = 0; i < num_calls; i++) {
+    const Clock::time_point start = Clock::now();
+    func(i);
+    const Clock::time_point end = Clock::now();
+    samples[i] = std::max(ElapsedNanos(start, end) - clock_overhead, 0.0) /
+                 static_cast<double>(keys_per_call);
+  }
+
+  std::sort(samples.begin(), samples.end());
+  *p50 = samples[num_calls / 2];
+  *p99 = samples[num_calls * 99 / 100];
+}
+
+// Replays the lookups in steps of step lookups. lookup_fn(start, count) looks
+// up lookups [start, start + count) and returns the sum of the indices of the
+// keys that were found.
+template <class LookupFunc>
+static WorkloadResult ReplayLookups(const std::vector<uint32_t>& lookups,
+                                    uint64_t expected_sum, size_t step,
+                                    const LookupFunc& lookup_fn) {
+  WorkloadResult result = WorkloadResult();
+  CacheMissCounter counter = OpenCacheMissCounter();
+
+  uint64_t sum = 0;
+  uint64_t num_misses = 0;
+  StartCacheMissCounter(counter);
+  const Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < lookups.size(); i += step) {
+    sum += lookup_fn(i, std::min(step, lookups.size() - i));
+  }
+  const Clock::time_point end = Clock::now();
+  result.have_cache_misses = StopCacheMissCounter(counter, &num_misses);
+  CloseCacheMissCounter(&counter);
+
+  const double num_lookups = static_cast<double>(lookups.size());
+  result.lookups_per_sec = num_lookups * 1e9 / ElapsedNanos(start, end);
+  result.cache_misses_per_lookup =
+      static_cast<double>(num_misses) / num_lookups;
+  result.correct = (sum == expected_sum);
+  g_sink = sum;
+  return result;
+}
+
+// Hashes each lookup with a separate call of hash_key and probes a FlatTable
+template <class KeyT, class HashKey>
+static WorkloadResult RunPerCallMode(const std::vector<KeyT>& keys,
+                                     const std::vector<uint32_t>& lookups,
+                                     uint64_t expected_sum,
+                                     const HashKey& hash_key) {
+  FlatTable<KeyT> table(keys);
+  for (size_t i = 0; i < keys.size(); i++) {
+    table.Insert(static_cast<uint64_t>(hash_key(keys[i])),
+                 static_cast<uint32_t>(i));
+  }
+
+  WorkloadResult result =
+      ReplayLookups(lookups, expected_sum, 1, [&](size_t i, size_t) {
+        const KeyT& key = keys[lookups[i]];
+        return uint64_t{table.Find(static_cast<uint64_t>(hash_key(key)), key)};
+      });
+  MeasureLatency(
+      std::min(lookups.size(), kNumLatencySamples), 1,
+      [&](size_t i) {
+        g_sink = static_cast<uint64_t>(hash_key(keys[lookups[i]]));
+      },
+      &result.p50_latency_nanos, &result.p99_latency_nanos);
+  return result;
+}
+
+// Hashes the lookups in batches of kBatchSize with the batch hashing functions
+// and probes a FlatTable
+template <class KeyT>
+static WorkloadResult RunBatchMode(const std::vector<KeyT>& keys,
+                                   const std::vector<uint32_t>& lookups,
+                                   uint64_t expected_sum) {
+  FlatTable<KeyT> table(keys);
+  uint64_t hashes[kBatchSize];
+  for (size_t start = 0; start < keys.size(); start += kBatchSize) {
+    const size_t count = std::min(kBatchSize, keys.size() - start);
+    SimdHwyHashKeys(keys.data() + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      table.Insert(hashes[i], static_cast<uint32_t>(start + i));
+    }
+  }
+
+  // The keys of each batch of lookups are gathered first, as a caller would
+  // gather the keys of its pending lookups
+  KeyT batch_keys[kBatchSize];
+  WorkloadResult result = ReplayLookups(
+      lookups, expected_sum, kBatchSize, [&](size_t start, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+          batch_keys[i] = keys[lookups[start + i]];
+        }
+        SimdHwyHashKeys(batch_keys, count, hashes);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+          sum += table.Find(hashes[i], batch_keys[i]);
+        }
+        return sum;
+      });
+  MeasureLatency(
+      std::min(lookups.size(), kNumLatencySamples) / kBatchSize, kBatchSize,
+      [&](size_t call_index) {
+        for (size_t i = 0; i < kBatchSize; i++) {
+          batch_keys[i] = keys[lookups[call_index * kBatchSize + i]];
+        }
+        SimdHwyHashKeys(batch_keys, kBatchSize, hashes);
+        g_sink = hashes[0];
+      },
+      &result.p50_latency_nanos, &result.p99_latency_nanos);
+  return result;
+}
+
+// Looks up each key in a std::unordered_map that is hashed with Hasher
+template <class KeyT, class Hasher>
+static WorkloadResult RunMapMode(const std::vector<KeyT>& keys,
+                                 const std::vector<uint32_t>& lookups,
+                                 uint64_t expected_sum) {
+  std::unordered_map<KeyT, uint32_t, Hasher> map(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    map.emplace(keys[i], static_cast<uint32_t>(i));
+  }
+
+  WorkloadResult result =
+      ReplayLookups(lookups, expected_sum, 1, [&](size_t i, size_t) {
+        return uint64_t{map.find(keys[lookups[i]])->second};
+      });
+  const Hasher hasher{};
+  MeasureLatency(
+      std::min(lookups.size(), kNumLatencySamples), 1,
+      [&](size_t i) {
+        g_sink = static_cast<uint64_t>(hasher(keys[lookups[i]]));
+      },
+      &result.p50_latency_nanos, &result.p99_latency_nanos);
+  return result;
+}
+
+template <class KeyT>
+static WorkloadResult RunMode(Mode mode, const std::vector<KeyT>& keys,
+                              const std::vector<uint32_t>& lookups) {
+  const uint64_t expected_sum =
+      std::accumulate(lookups.begin(), lookups.end(), uint64_t{0});
+  switch (mode) {
+    case Mode::kPerCall:
+      return RunPerCallMode(keys, lookups, expected_sum, SimdHwyHasher());
+    case Mode::kBatch:
+      return RunBatchMode(keys, lookups, expected_sum);
+    case Mode::kHasher:
+      return RunMapMode<KeyT, SimdHwyHasher>(keys, lookups, expected_sum);
+    case Mode::kBaseline:
+      return RunPerCallMode(keys, lookups, expected_sum, std::hash<KeyT>());
+    case Mode::kBaselineHasher:
+      return RunMapMode<KeyT, std::hash<KeyT>>(keys, lookups, expected_sum);
+  }
+  return WorkloadResult();
+}
+
+// Returns num_lookups indices of keys, where the popularity of the key of
+// rank r (counting from 1) is proportional to 1 / r^exponent. The ranks are
+// assigned to the keys in a random order, so that the popular keys are not
+// next to each other in memory.
+static std::vector<uint32_t> ZipfianLookups(size_t num_keys,
+                                            size_t num_lookups,
+                                            double exponent,
+                                            std::mt19937_64& rng) {
+  std::vector<double> cdf(num_keys);
+  double total = 0;
+  for (size_t i = 0; i < num_keys; i++) {
+    total += 1.0 / pow(static_cast<double>(i + 1), exponent);
+    cdf[i] = total;
+  }
+
+  std::vector<uint32_t> rank_to_key(num_keys);
+  std::iota(rank_to_key.begin(), rank_to_key.end(), uint32_t{0});
+  std::shuffle(rank_to_key.begin(), rank_to_key.end(), rng);
+
+  std::uniform_real_distribution<double> dist(0.0, total);
+  std::vector<uint32_t> lookups(num_lookups);
+  for (size_t i = 0; i < num_lookups; i++) {
+    const size_t rank = static_cast<size_t>(
+        std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin());
+    lookups[i] = rank_to_key[std::min(rank, num_keys - 1)];
+  }
+  return lookups;
+}
+
+// Identifiers such as user names and symbol names, of 4 to 24 bytes
+static std::string RandomShortString(std::mt19937_64& rng) {
+  static constexpr char kChars[] = "abcdefghijklmnopqrstuvwxyz0123456789_";
+  const size_t len = 4 + static_cast<size_t>(rng() % 21);
+  std::string str(len, ' ');
+  for (size_t i = 0; i < len; i++) {
+    str[i] = kChars[rng() % (sizeof(kChars) - 1)];
+  }
+  return str;
+}
+
+// Version 4 UUIDs in their 36-character text form
+static std::string RandomUuid(std::mt19937_64& rng) {
+  const uint64_t hi = rng();
+  const uint64_t lo = rng();
+  char buf[37];
+  snprintf(buf, sizeof(buf), "%08x-%04x-4%03x-%04x-%012llx",
+           static_cast<unsigned>(hi >> 32),
+           static_cast<unsigned>((hi >> 16) & 0xFFFFu),
+           static_cast<unsigned>(hi & 0xFFFu),
+           static_cast<unsigned>(0x8000u | ((lo >> 48) & 0x3FFFu)),
+           static_cast<unsigned long long>(lo & 0xFFFFFFFFFFFFull));
+  return std::string(buf, 36);
+}
+
+// Paths of a web service, such as "/api/v2/users/81723/orders?page=3"
+static std::string RandomUrlPath(std::mt19937_64& rng) {
+  static constexpr const char* kSegments[] = {
+      "api",      "v1",      "v2",       "users",  "orders", "items",
+      "search",   "static",  "images",   "thumbs", "cart",   "checkout",
+      "products", "reviews", "accounts", "settings"};
+  static constexpr size_t kNumSegments =
+      sizeof(kSegments) / sizeof(kSegments[0]);
+
+  std::string path;
+  const size_t num_segments = 2 + static_cast<size_t>(rng() % 5);
+  for (size_t i = 0; i < num_segments; i++) {
+    path += '/';
+    if (i >= 2 && rng() % 3 == 0) {
+      path += std::to_string(rng() % 1000000);
+    } else {
+      path += kSegments[rng() % kNumSegments];
+    }
+  }
+  if (rng() % 4 == 0) {
+    path += "?page=" + std::to_string(rng() % 100);
+  }
+  return path;
+}
+
+// Returns num_keys distinct strings that are generated by make_string
+template <class MakeString>
+static std::vector<std::string> DistinctStrings(size_t num_keys,
+                                                std::mt19937_64& rng,
+                                                const MakeString& make_string) {
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> strings;
+  strings.reserve(num_keys);
+  while (strings.size() < num_keys) {
+    std::string str = make_string(rng);
+    if (seen.insert(str).second) {
+      strings.push_back(std::move(str));
+    }
+  }
+  return strings;
+}
+
+template <class KeyT>
+static bool RunWorkload(const char* workload_name,
+                        const std::vector<KeyT>& keys, size_t num_lookups,
+                        double zipf_exponent, std::mt19937_64& rng) {
+  const std::vector<uint32_t> lookups =
+      ZipfianLookups(keys.size(), num_lookups, zipf_exponent, rng);
+
+  bool all_correct = true;
+  for (const Mode mode : kModes) {
+    const WorkloadResult result = RunMode(mode, keys, lookups);
+    all_correct = all_correct && result.correct;
+
+    char misses[32];
+    if (result.have_cache_misses) {
+      snprintf(misses, sizeof(misses), "%.3f",
+               result.cache_misses_per_lookup);
+    } else {
+      snprintf(misses, sizeof(misses), "n/a");
+    }
+    printf("%-14s %-16s %12.0f %9.1f %9.1f %14s%s\n", workload_name,
+           ModeName(mode), result.lookups_per_sec, result.p50_latency_nanos,
+           result.p99_latency_nanos, misses,
+           result.correct ? "" : "  (WRONG RESULTS)");
+    fflush(stdout);
+  }
+  return all_correct;
+}
+
+static std::vector<std::string_view> StringViews(
+    const std::vector<std::string>& strings) {
+  return std::vector<std::string_view>(strings.begin(), strings.end());
+}
+
+static int RunBenchmarks(size_t num_keys, size_t num_lookups,
+                         double zipf_exponent) {
+  std::mt19937_64 rng(0x53484842454E4348ull);
+
+  printf("%zu keys, %zu lookups, Zipf exponent %.2f\n\n", num_keys,
+         num_lookups, zipf_exponent);
+  printf("%-14s %-16s %12s %9s %9s %14s\n", "workload", "mode", "lookups/s",
+         "p50 ns", "p99 ns", "misses/lookup");
+
+  bool all_correct = true;
+
+  const std::vector<std::string> short_strings =
+      DistinctStrings(num_keys, rng, RandomShortString);
+  all_correct = RunWorkload("short-strings", StringViews(short_strings),
+                            num_lookups, zipf_exponent, rng) &&
+                all_correct;
+
+  const std::vector<std::string> uuids =
+      DistinctStrings(num_keys, rng, RandomUuid);
+  all_correct = RunWorkload("uuids", StringViews(uuids), num_lookups,
+                            zipf_exponent, rng) &&
+                all_correct;
+
+  const std::vector<std::string> url_paths =
+      DistinctStrings(num_keys, rng, RandomUrlPath);
+  all_correct = RunWorkload("url-paths", StringViews(url_paths), num_lookups,
+                            zipf_exponent, rng) &&
+                all_correct;
+
+  // Integer IDs are allocated sequentially, as database row IDs are
+  std::vector<uint64_t> integer_ids(num_keys);
+  std::iota(integer_ids.begin(), integer_ids.end(), uint64_t{1000000});
+  all_correct = RunWorkload("integer-ids", integer_ids, num_lookups,
+                            zipf_exponent, rng) &&
+                all_correct;
+
+  return all_correct ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  if (argc > 4) {
+    fprintf(stderr, "Usage: %s [num_keys [num_lookups [zipf_exponent]]]\n",
+            argv[0]);
+    return 2;
+  }
+
+  const size_t num_keys =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10)
+                 : simdhwyhash::bench::kDefaultNumKeys;
+  const size_t num_lookups =
+      (argc > 2) ? strtoull(argv[2], nullptr, 10)
+                 : simdhwyhash::bench::kDefaultNumLookups;
+  const double zipf_exponent =
+      (argc > 3) ? strtod(argv[3], nullptr)
+                 : simdhwyhash::bench::kDefaultZipfExponent;
+  if (num_keys == 0 || num_keys >= 0xFFFFFFFFu || num_lookups == 0 ||
+      !(zipf_exponent >= 0)) {
+    fprintf(stderr, "Invalid arguments\n");
+    return 2;
+  }
+
+  return simdhwyhash::bench::RunBenchmarks(num_keys, num_lookups,
+                                           zipf_exponent);
+}
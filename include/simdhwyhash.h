@@ -52,6 +52,15 @@
 
 #endif  // !defined(SIMDHWYHASH_SHARED_DEFINE)
 
+/* The header-only build defines the entry points as static inline functions
+   in each translation unit, as the kernels that they call directly have
+   internal linkage */
+#if defined(SIMDHWYHASH_HEADER_ONLY) && defined(__cplusplus)
+#define SIMDHWYHASH_CORE_API static inline
+#else
+#define SIMDHWYHASH_CORE_API SIMDHWYHASH_DLLEXPORT
+#endif /* defined(SIMDHWYHASH_HEADER_ONLY) && defined(__cplusplus) */
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -63,33 +72,167 @@ typedef struct {
   uint64_t mul1[4];
 } SimdHwyHashState;
 
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Reset(
+SIMDHWYHASH_CORE_API void SimdHwyHash_Reset(
     SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
     const uint64_t* SIMDHWYHASH_RESTRICT key);
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Update(
+SIMDHWYHASH_CORE_API void SimdHwyHash_Update(
     SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
     const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
 
-SIMDHWYHASH_DLLEXPORT uint64_t
+SIMDHWYHASH_CORE_API uint64_t
 SimdHwyHash_Finalize64(SimdHwyHashState* SIMDHWYHASH_RESTRICT state);
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Finalize128(
+SIMDHWYHASH_CORE_API void SimdHwyHash_Finalize128(
     SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
     uint64_t* SIMDHWYHASH_RESTRICT hash);
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Finalize256(
+SIMDHWYHASH_CORE_API void SimdHwyHash_Finalize256(
     SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
     uint64_t* SIMDHWYHASH_RESTRICT hash);
+SIMDHWYHASH_CORE_API void SimdHwyHash_FinalizeXof(
+    SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+    uint64_t* SIMDHWYHASH_RESTRICT out, size_t num_words);
 
-SIMDHWYHASH_DLLEXPORT uint64_t
+SIMDHWYHASH_CORE_API uint64_t
 SimdHwyHash_Hash64(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
                    const uint64_t* SIMDHWYHASH_RESTRICT key);
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Hash128(
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash128(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hash);
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash256(
     const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
     const uint64_t* SIMDHWYHASH_RESTRICT key,
     uint64_t* SIMDHWYHASH_RESTRICT hash);
-SIMDHWYHASH_DLLEXPORT void SimdHwyHash_Hash256(
+
+#define SIMDHWYHASH_INPUT_PADDING 32
+
+SIMDHWYHASH_CORE_API uint64_t
+SimdHwyHash_Hash64Padded(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+                         const uint64_t* SIMDHWYHASH_RESTRICT key);
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash128Padded(
     const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
     const uint64_t* SIMDHWYHASH_RESTRICT key,
     uint64_t* SIMDHWYHASH_RESTRICT hash);
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash256Padded(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hash);
+
+#define SIMDHWYHASH_COPY_NON_TEMPORAL 1u
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_CopyAndUpdate(
+    SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+    void* SIMDHWYHASH_RESTRICT dst, const void* SIMDHWYHASH_RESTRICT src,
+    size_t byte_len, unsigned flags);
+
+SIMDHWYHASH_CORE_API uint64_t SimdHwyHash_CopyAndHash64(
+    void* SIMDHWYHASH_RESTRICT dst, const void* SIMDHWYHASH_RESTRICT src,
+    size_t byte_len, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    unsigned flags);
+SIMDHWYHASH_CORE_API void SimdHwyHash_CopyAndHash128(
+    void* SIMDHWYHASH_RESTRICT dst, const void* SIMDHWYHASH_RESTRICT src,
+    size_t byte_len, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    unsigned flags, uint64_t* SIMDHWYHASH_RESTRICT hash);
+SIMDHWYHASH_CORE_API void SimdHwyHash_CopyAndHash256(
+    void* SIMDHWYHASH_RESTRICT dst, const void* SIMDHWYHASH_RESTRICT src,
+    size_t byte_len, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    unsigned flags, uint64_t* SIMDHWYHASH_RESTRICT hash);
+
+SIMDHWYHASH_CORE_API int SimdHwyHash_Autotune(const char* cache_path);
+SIMDHWYHASH_CORE_API void SimdHwyHash_AutotuneReset(void);
+SIMDHWYHASH_CORE_API int64_t SimdHwyHash_AutotunedTarget(size_t byte_len);
+
+#define SIMDHWYHASH_EXPORTED_STATE_MAX_SIZE 183
+
+SIMDHWYHASH_CORE_API size_t SimdHwyHash_ExportState(
+    const SimdHwyHashState* SIMDHWYHASH_RESTRICT state, uint64_t processed_len,
+    const void* SIMDHWYHASH_RESTRICT tail, size_t tail_len,
+    void* SIMDHWYHASH_RESTRICT blob, size_t blob_capacity);
+SIMDHWYHASH_CORE_API size_t SimdHwyHash_ImportState(
+    SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+    uint64_t* SIMDHWYHASH_RESTRICT processed_len,
+    void* SIMDHWYHASH_RESTRICT tail, size_t* SIMDHWYHASH_RESTRICT tail_len,
+    const void* SIMDHWYHASH_RESTRICT blob, size_t blob_len);
+
+typedef struct {
+  uint64_t* words;
+  size_t capacity;
+} SimdHwyHashStatePool;
+
+SIMDHWYHASH_CORE_API int SimdHwyHash_StatePoolInit(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool, size_t capacity);
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolFree(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolGet(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool, size_t index,
+    SimdHwyHashState* SIMDHWYHASH_RESTRICT state);
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolSet(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool, size_t index,
+    const SimdHwyHashState* SIMDHWYHASH_RESTRICT state);
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolReset(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool, size_t index,
+    const uint64_t* SIMDHWYHASH_RESTRICT key);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolUpdateMany(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_streams);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolFinalizeMany64(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolFinalizeMany128(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+SIMDHWYHASH_CORE_API void SimdHwyHash_StatePoolFinalizeMany256(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash64Batch(
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+SIMDHWYHASH_CORE_API void SimdHwyHash_Hash128Batch(
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+SIMDHWYHASH_CORE_API void SimdHwyHash_HashU64Keys64(
+    const uint64_t* SIMDHWYHASH_RESTRICT keys, size_t num_keys,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_HashMultiKey64(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t (*SIMDHWYHASH_RESTRICT keys)[4], size_t num_keys,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+
+#define SIMDHWYHASH_RECORDS_CSV 1u
+
+SIMDHWYHASH_CORE_API size_t SimdHwyHash_HashRecords64(
+    const void* SIMDHWYHASH_RESTRICT buf, size_t byte_len, uint8_t delimiter,
+    unsigned flags, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes,
+    size_t (*SIMDHWYHASH_RESTRICT offsets)[2], size_t max_records);
+
+SIMDHWYHASH_CORE_API void SimdHwyHash_RandomFill(
+    const uint64_t* SIMDHWYHASH_RESTRICT key, uint64_t nonce,
+    void* SIMDHWYHASH_RESTRICT out, size_t byte_len);
+SIMDHWYHASH_CORE_API void SimdHwyHash_RandomFillAt(
+    const uint64_t* SIMDHWYHASH_RESTRICT key, uint64_t nonce, uint64_t offset,
+    void* SIMDHWYHASH_RESTRICT out, size_t byte_len);
+
+SIMDHWYHASH_CORE_API size_t SimdHwyHash_VerifyBatch128(
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    const uint64_t (*SIMDHWYHASH_RESTRICT tags)[2],
+    uint8_t* SIMDHWYHASH_RESTRICT ok_bitmap);
 
 #ifdef __cplusplus
 }
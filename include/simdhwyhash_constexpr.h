@@ -0,0 +1,275 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMDHWYHASH_CONSTEXPR_H_
+#define SIMDHWYHASH_CONSTEXPR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <string_view>
+
+namespace simdhwyhash {
+
+struct ConstHwyHashState {
+  uint64_t v0[4];
+  uint64_t v1[4];
+  uint64_t mul0[4];
+  uint64_t mul1[4];
+};
+
+namespace const_hwy_hash_internal {
+
+inline constexpr uint64_t kMul0[4] = {0xdbe6d5d5fe4cce2fU, 0xa4093822299f31d0U,
+                                      0x13198a2e03707344U,
+                                      0x243f6a8885a308d3U};
+inline constexpr uint64_t kMul1[4] = {0x3bd39e10cb0ef593U, 0xc0acf169b5f18a8cU,
+                                      0xbe5466cf34e90c6cU,
+                                      0x452821e638d01377U};
+
+constexpr uint64_t Rotate64By32(uint64_t v) { return (v >> 32) | (v << 32); }
+
+constexpr uint32_t Rotate32Left(uint32_t v, unsigned count) {
+  return (v << count) | (v >> ((32u - count) & 31u));
+}
+
+constexpr uint64_t ZipperMerge0(uint64_t v1, uint64_t v0) {
+  return (((v0 & 0xff000000U) | (v1 & 0xff00000000U)) >> 24) |
+         (((v0 & 0xff0000000000U) | (v1 & 0xff000000000000U)) >> 16) |
+         (v0 & 0xff0000U) | ((v0 & 0xff00U) << 32) |
+         ((v1 & 0xff00000000000000U) >> 8) | (v0 << 56);
+}
+
+constexpr uint64_t ZipperMerge1(uint64_t v1, uint64_t v0) {
+  return (((v1 & 0xff000000U) | (v0 & 0xff00000000U)) >> 24) |
+         (v1 & 0xff0000U) | ((v1 & 0xff0000000000U) >> 16) |
+         ((v1 & 0xff00U) << 24) | ((v0 & 0xff000000000000U) >> 8) |
+         ((v1 & 0xffU) << 48) | (v0 & 0xff00000000000000U);
+}
+
+constexpr void UpdatePacket(ConstHwyHashState& state,
+                            const uint64_t (&packet)[4]) {
+  for (size_t i = 0; i < 4; i++) {
+    state.v1[i] += state.mul0[i] + packet[i];
+    state.mul0[i] ^=
+        (state.v1[i] & uint64_t{0xffffffffU}) * (state.v0[i] >> 32);
+    state.v0[i] += state.mul1[i];
+    state.mul1[i] ^=
+        (state.v0[i] & uint64_t{0xffffffffU}) * (state.v1[i] >> 32);
+  }
+
+  state.v0[0] += ZipperMerge0(state.v1[1], state.v1[0]);
+  state.v0[1] += ZipperMerge1(state.v1[1], state.v1[0]);
+  state.v0[2] += ZipperMerge0(state.v1[3], state.v1[2]);
+  state.v0[3] += ZipperMerge1(state.v1[3], state.v1[2]);
+  state.v1[0] += ZipperMerge0(state.v0[1], state.v0[0]);
+  state.v1[1] += ZipperMerge1(state.v0[1], state.v0[0]);
+  state.v1[2] += ZipperMerge0(state.v0[3], state.v0[2]);
+  state.v1[3] += ZipperMerge1(state.v0[3], state.v0[2]);
+}
+
+constexpr void PermuteAndUpdate(ConstHwyHashState& state) {
+  const uint64_t packet[4] = {
+      Rotate64By32(state.v0[2]), Rotate64By32(state.v0[3]),
+      Rotate64By32(state.v0[0]), Rotate64By32(state.v0[1])};
+  UpdatePacket(state, packet);
+}
+
+template <class T>
+constexpr uint8_t ByteAt(const T* ptr, size_t idx) {
+  return static_cast<uint8_t>(ptr[idx]);
+}
+
+// Loads the 32-byte packet at ptr, with each word in little-endian order
+template <class T>
+constexpr void LoadPacket(const T* ptr, uint64_t (&packet)[4]) {
+  for (size_t i = 0; i < 4; i++) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 8; j++) {
+      word |= static_cast<uint64_t>(ByteAt(ptr, i * 8 + j)) << (j * 8);
+    }
+    packet[i] = word;
+  }
+}
+
+template <class T>
+constexpr void Update(ConstHwyHashState& state, const T* ptr,
+                      size_t byte_len) {
+  static_assert(sizeof(T) == 1, "T must be a byte type");
+
+  uint64_t packet[4] = {};
+  size_t offset = 0;
+  for (; byte_len - offset >= 32; offset += 32) {
+    LoadPacket(ptr + offset, packet);
+    UpdatePacket(state, packet);
+  }
+
+  const unsigned remainder_len = static_cast<unsigned>(byte_len - offset);
+  if (remainder_len == 0) {
+    return;
+  }
+
+  for (size_t i = 0; i < 4; i++) {
+    state.v0[i] += (static_cast<uint64_t>(remainder_len) << 32) + remainder_len;
+    const uint32_t v1_lo = Rotate32Left(static_cast<uint32_t>(state.v1[i]),
+                                        remainder_len);
+    const uint32_t v1_hi = Rotate32Left(
+        static_cast<uint32_t>(state.v1[i] >> 32), remainder_len);
+    state.v1[i] = (static_cast<uint64_t>(v1_hi) << 32) | v1_lo;
+  }
+
+  // Lay out the final partial packet in the same way as
+  // CopyRemainderPacketBytes
+  const T* remainder = ptr + offset;
+  const unsigned u32_load_byte_len = remainder_len & (~3u);
+  uint8_t packet_bytes[32] = {};
+  for (unsigned i = 0; i < u32_load_byte_len; i++) {
+    packet_bytes[i] = ByteAt(remainder, i);
+  }
+  if (remainder_len >= 16) {
+    for (unsigned i = 0; i < 4; i++) {
+      packet_bytes[28 + i] = ByteAt(remainder, remainder_len - 4 + i);
+    }
+  } else {
+    const unsigned trailing3_len = remainder_len & 3u;
+    if (trailing3_len != 0) {
+      packet_bytes[16] = ByteAt(remainder, u32_load_byte_len);
+      packet_bytes[17] =
+          ByteAt(remainder, u32_load_byte_len + (trailing3_len >> 1));
+      packet_bytes[18] =
+          ByteAt(remainder, u32_load_byte_len + trailing3_len - 1);
+    }
+  }
+
+  LoadPacket(packet_bytes, packet);
+  UpdatePacket(state, packet);
+}
+
+constexpr void ModularReduction(uint64_t a3_unmasked, uint64_t a2, uint64_t a1,
+                                uint64_t a0, uint64_t& hash_lo,
+                                uint64_t& hash_hi) {
+  const uint64_t a3 = a3_unmasked & 0x3FFFFFFFFFFFFFFFU;
+  hash_hi = a1 ^ ((a3 << 1) | (a2 >> 63)) ^ ((a3 << 2) | (a2 >> 62));
+  hash_lo = a0 ^ (a2 << 1) ^ (a2 << 2);
+}
+
+}  // namespace const_hwy_hash_internal
+
+constexpr ConstHwyHashState ConstHwyHashReset(const uint64_t* key) {
+  using namespace const_hwy_hash_internal;
+
+  ConstHwyHashState state = {};
+  for (size_t i = 0; i < 4; i++) {
+    state.mul0[i] = kMul0[i];
+    state.mul1[i] = kMul1[i];
+    state.v0[i] = key[i] ^ kMul0[i];
+    state.v1[i] = Rotate64By32(key[i]) ^ kMul1[i];
+  }
+  return state;
+}
+
+constexpr void ConstHwyHashUpdate(ConstHwyHashState& state, const char* ptr,
+                                  size_t byte_len) {
+  const_hwy_hash_internal::Update(state, ptr, byte_len);
+}
+
+constexpr void ConstHwyHashUpdate(ConstHwyHashState& state,
+                                  const uint8_t* ptr, size_t byte_len) {
+  const_hwy_hash_internal::Update(state, ptr, byte_len);
+}
+
+constexpr uint64_t ConstHwyHashFinalize64(ConstHwyHashState state) {
+  for (int i = 0; i < 4; i++) {
+    const_hwy_hash_internal::PermuteAndUpdate(state);
+  }
+  return state.v0[0] + state.v1[0] + state.mul0[0] + state.mul1[0];
+}
+
+constexpr std::array<uint64_t, 2> ConstHwyHashFinalize128(
+    ConstHwyHashState state) {
+  for (int i = 0; i < 6; i++) {
+    const_hwy_hash_internal::PermuteAndUpdate(state);
+  }
+
+  std::array<uint64_t, 2> hash = {};
+  hash[0] = state.v0[0] + state.mul0[0] + state.v1[2] + state.mul1[2];
+  hash[1] = state.v0[1] + state.mul0[1] + state.v1[3] + state.mul1[3];
+  return hash;
+}
+
+constexpr std::array<uint64_t, 4> ConstHwyHashFinalize256(
+    ConstHwyHashState state) {
+  for (int i = 0; i < 10; i++) {
+    const_hwy_hash_internal::PermuteAndUpdate(state);
+  }
+
+  std::array<uint64_t, 4> hash = {};
+  const_hwy_hash_internal::ModularReduction(
+      state.v1[1] + state.mul1[1], state.v1[0] + state.mul1[0],
+      state.v0[1] + state.mul0[1], state.v0[0] + state.mul0[0], hash[0],
+      hash[1]);
+  const_hwy_hash_internal::ModularReduction(
+      state.v1[3] + state.mul1[3], state.v1[2] + state.mul1[2],
+      state.v0[3] + state.mul0[3], state.v0[2] + state.mul0[2], hash[2],
+      hash[3]);
+  return hash;
+}
+
+constexpr uint64_t ConstHash64(const uint8_t* ptr, size_t byte_len,
+                               const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, ptr, byte_len);
+  return ConstHwyHashFinalize64(state);
+}
+
+constexpr uint64_t ConstHash64(std::string_view str, const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, str.data(), str.size());
+  return ConstHwyHashFinalize64(state);
+}
+
+constexpr std::array<uint64_t, 2> ConstHash128(const uint8_t* ptr,
+                                               size_t byte_len,
+                                               const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, ptr, byte_len);
+  return ConstHwyHashFinalize128(state);
+}
+
+constexpr std::array<uint64_t, 2> ConstHash128(std::string_view str,
+                                               const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, str.data(), str.size());
+  return ConstHwyHashFinalize128(state);
+}
+
+constexpr std::array<uint64_t, 4> ConstHash256(const uint8_t* ptr,
+                                               size_t byte_len,
+                                               const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, ptr, byte_len);
+  return ConstHwyHashFinalize256(state);
+}
+
+constexpr std::array<uint64_t, 4> ConstHash256(std::string_view str,
+                                               const uint64_t* key) {
+  ConstHwyHashState state = ConstHwyHashReset(key);
+  ConstHwyHashUpdate(state, str.data(), str.size());
+  return ConstHwyHashFinalize256(state);
+}
+
+}  // namespace simdhwyhash
+
+#endif  // SIMDHWYHASH_CONSTEXPR_H_
@@ -0,0 +1,51 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_DEDUP_H_
+#define SIMDHWYHASH_DEDUP_H_
+
+#include "simdhwyhash.h"
+#include "simdhwyhash_parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct SimdHwyHashDedup SimdHwyHashDedup;
+
+typedef void (*SimdHwyHashDedupFunc)(void* context,
+                                     const uint64_t* record_ids,
+                                     const uint64_t* first_record_ids,
+                                     size_t num_records);
+
+SIMDHWYHASH_DLLEXPORT SimdHwyHashDedup* SimdHwyHash_DedupCreate(
+    const char* spill_dir, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    size_t memory_budget, SimdHwyHashThreadPool* pool);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_DedupDestroy(SimdHwyHashDedup* dedup);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_DedupAdd(
+    SimdHwyHashDedup* SIMDHWYHASH_RESTRICT dedup,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_records);
+SIMDHWYHASH_DLLEXPORT uint64_t
+SimdHwyHash_DedupNumRecords(const SimdHwyHashDedup* dedup);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_DedupFinish(SimdHwyHashDedup* dedup,
+                                                  SimdHwyHashDedupFunc func,
+                                                  void* context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_DEDUP_H_ */
@@ -0,0 +1,33 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_HEADER_ONLY_H_
+#define SIMDHWYHASH_HEADER_ONLY_H_
+
+#ifndef __cplusplus
+#error "The header-only build of simdhwyhash requires C++17"
+#endif /* __cplusplus */
+
+#if defined(SIMDHWYHASH_H_) && !defined(SIMDHWYHASH_HEADER_ONLY)
+#error "simdhwyhash.h was included without SIMDHWYHASH_HEADER_ONLY defined"
+#endif /* defined(SIMDHWYHASH_H_) && !defined(SIMDHWYHASH_HEADER_ONLY) */
+
+#ifndef SIMDHWYHASH_HEADER_ONLY
+#define SIMDHWYHASH_HEADER_ONLY 1
+#endif /* SIMDHWYHASH_HEADER_ONLY */
+
+#include "simdhwyhash.h"
+#include "simdhwyhash.cc"
+
+#endif /* SIMDHWYHASH_HEADER_ONLY_H_ */
@@ -0,0 +1,61 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_HLL_H_
+#define SIMDHWYHASH_HLL_H_
+
+#include "simdhwyhash.h"
+
+#define SIMDHWYHASH_HLL_MIN_PRECISION 4
+#define SIMDHWYHASH_HLL_MAX_PRECISION 18
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct {
+  uint64_t key[4];
+  uint8_t* registers;
+  uint32_t* sparse_entries;
+  size_t num_sparse_entries;
+  size_t sparse_capacity;
+  unsigned precision;
+} SimdHwyHashHll;
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_HllInit(
+    SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+    const uint64_t* SIMDHWYHASH_RESTRICT key, unsigned precision);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_HllFree(
+    SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_HllAdd(
+    SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_HllAddBatch(
+    SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_keys);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_HllMerge(
+    SimdHwyHashHll* SIMDHWYHASH_RESTRICT dst,
+    const SimdHwyHashHll* SIMDHWYHASH_RESTRICT src);
+
+SIMDHWYHASH_DLLEXPORT double SimdHwyHash_HllEstimate(
+    const SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_HLL_H_ */
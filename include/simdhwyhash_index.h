@@ -0,0 +1,48 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_INDEX_H_
+#define SIMDHWYHASH_INDEX_H_
+
+#include "simdhwyhash.h"
+
+#define SIMDHWYHASH_INDEX_READ_ONLY 1u
+#define SIMDHWYHASH_INDEX_DURABLE 2u
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct SimdHwyHashIndex SimdHwyHashIndex;
+
+SIMDHWYHASH_DLLEXPORT SimdHwyHashIndex* SimdHwyHash_IndexOpen(const char* path,
+                                                              unsigned flags);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_IndexClose(SimdHwyHashIndex* index);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_IndexInsert(
+    SimdHwyHashIndex* SIMDHWYHASH_RESTRICT index,
+    const uint64_t* SIMDHWYHASH_RESTRICT hash, uint64_t location);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_IndexFind(
+    const SimdHwyHashIndex* SIMDHWYHASH_RESTRICT index,
+    const uint64_t* SIMDHWYHASH_RESTRICT hash,
+    uint64_t* SIMDHWYHASH_RESTRICT location);
+SIMDHWYHASH_DLLEXPORT uint64_t
+SimdHwyHash_IndexCount(const SimdHwyHashIndex* index);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_IndexSync(SimdHwyHashIndex* index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_INDEX_H_ */
@@ -0,0 +1,84 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_INTERNER_H_
+#define SIMDHWYHASH_INTERNER_H_
+
+#include "simdhwyhash.h"
+
+#define SIMDHWYHASH_INTERNER_INVALID_ID 0xFFFFFFFFu
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct SimdHwyHashInterner SimdHwyHashInterner;
+
+SIMDHWYHASH_DLLEXPORT SimdHwyHashInterner* SimdHwyHash_InternerCreate(
+    const uint64_t* SIMDHWYHASH_RESTRICT key, size_t expected_num_strings);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_InternerDestroy(
+    SimdHwyHashInterner* interner);
+
+SIMDHWYHASH_DLLEXPORT uint32_t
+SimdHwyHash_Intern(SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+                   const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_InternBatch(
+    SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_strings,
+    uint32_t* SIMDHWYHASH_RESTRICT ids);
+
+SIMDHWYHASH_DLLEXPORT uint32_t SimdHwyHash_InternerFind(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
+SIMDHWYHASH_DLLEXPORT const void* SimdHwyHash_InternerGet(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner, uint32_t id,
+    size_t* SIMDHWYHASH_RESTRICT byte_len);
+SIMDHWYHASH_DLLEXPORT size_t
+SimdHwyHash_InternerCount(const SimdHwyHashInterner* interner);
+
+SIMDHWYHASH_DLLEXPORT size_t
+SimdHwyHash_InternerSnapshotSize(const SimdHwyHashInterner* interner);
+SIMDHWYHASH_DLLEXPORT size_t SimdHwyHash_InternerWriteSnapshot(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+    void* SIMDHWYHASH_RESTRICT buf, size_t buf_capacity);
+
+typedef struct {
+  const uint8_t* data;
+  size_t size;
+  uint64_t key[4];
+  uint64_t num_strings;
+  uint64_t index_capacity;
+  uint64_t num_string_bytes;
+  const uint8_t* hashes;
+  const uint8_t* offsets;
+  const uint8_t* index;
+  const uint8_t* string_bytes;
+} SimdHwyHashInternerSnapshot;
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_InternerSnapshotLoad(
+    SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    const void* SIMDHWYHASH_RESTRICT data, size_t size);
+SIMDHWYHASH_DLLEXPORT uint32_t SimdHwyHash_InternerSnapshotFind(
+    const SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
+SIMDHWYHASH_DLLEXPORT const void* SimdHwyHash_InternerSnapshotGet(
+    const SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    uint32_t id, size_t* SIMDHWYHASH_RESTRICT byte_len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_INTERNER_H_ */
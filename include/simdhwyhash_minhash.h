@@ -0,0 +1,53 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_MINHASH_H_
+#define SIMDHWYHASH_MINHASH_H_
+
+#include "simdhwyhash.h"
+
+#define SIMDHWYHASH_MINHASH_MAX_PERMS 1024
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct {
+  uint64_t key[4];
+  uint64_t* coeffs;
+  size_t num_perms;
+  size_t shingle_len;
+} SimdHwyHashMinHasher;
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_MinHashInit(
+    SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT hasher,
+    const uint64_t* SIMDHWYHASH_RESTRICT key, size_t num_perms,
+    size_t shingle_len);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_MinHashFree(
+    SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT hasher);
+
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_MinHashSignature(
+    const SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT hasher,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    uint32_t* SIMDHWYHASH_RESTRICT signature);
+
+SIMDHWYHASH_DLLEXPORT double SimdHwyHash_MinHashJaccard(
+    const uint32_t* SIMDHWYHASH_RESTRICT signature_a,
+    const uint32_t* SIMDHWYHASH_RESTRICT signature_b, size_t num_perms);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_MINHASH_H_ */
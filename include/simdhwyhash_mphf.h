@@ -0,0 +1,62 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_MPHF_H_
+#define SIMDHWYHASH_MPHF_H_
+
+#include "simdhwyhash.h"
+#include "simdhwyhash_parallel.h"
+
+#define SIMDHWYHASH_MPHF_MAX_LEVELS 40
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct {
+  const uint8_t* data;
+  size_t size;
+  uint8_t* owned_data;
+  uint64_t key[4];
+  uint64_t num_keys;
+  uint64_t num_levels;
+  uint64_t num_bit_words;
+  uint64_t num_fallback_keys;
+  const uint8_t* level_offsets;
+  const uint8_t* bits;
+  const uint8_t* block_ranks;
+  const uint8_t* fallback_hashes;
+} SimdHwyHashMphf;
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_MphfBuild(
+    SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_keys,
+    const uint64_t* SIMDHWYHASH_RESTRICT key, double gamma,
+    SimdHwyHashThreadPool* pool);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_MphfLoad(
+    SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+    const void* SIMDHWYHASH_RESTRICT data, size_t size);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_MphfFree(
+    SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf);
+
+SIMDHWYHASH_DLLEXPORT uint64_t
+SimdHwyHash_MphfLookup(const SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+                       const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_MPHF_H_ */
@@ -0,0 +1,55 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_PARALLEL_H_
+#define SIMDHWYHASH_PARALLEL_H_
+
+#include "simdhwyhash.h"
+
+#define SIMDHWYHASH_THREAD_POOL_PIN_THREADS 1u
+#define SIMDHWYHASH_THREAD_POOL_NUMA_LOCAL 2u
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct SimdHwyHashThreadPool SimdHwyHashThreadPool;
+
+typedef void (*SimdHwyHashTaskFunc)(void* context, size_t task_index);
+
+SIMDHWYHASH_DLLEXPORT SimdHwyHashThreadPool* SimdHwyHash_ThreadPoolCreate(
+    size_t num_threads, unsigned flags);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_ThreadPoolDestroy(
+    SimdHwyHashThreadPool* pool);
+SIMDHWYHASH_DLLEXPORT size_t
+SimdHwyHash_ThreadPoolNumThreads(const SimdHwyHashThreadPool* pool);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_ThreadPoolRun(
+    SimdHwyHashThreadPool* pool, size_t num_tasks, SimdHwyHashTaskFunc func,
+    void* context);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_ParallelHash64Batch(
+    SimdHwyHashThreadPool* pool, const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_ParallelHashU64Keys64(
+    SimdHwyHashThreadPool* pool, const uint64_t* SIMDHWYHASH_RESTRICT keys,
+    size_t num_keys, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_PARALLEL_H_ */
@@ -0,0 +1,42 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_PARTITION_H_
+#define SIMDHWYHASH_PARTITION_H_
+
+#include "simdhwyhash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Returns zero without writing to partition_ids or histogram if
+   num_partitions is zero */
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_Partition(
+    const uint64_t* SIMDHWYHASH_RESTRICT keys, size_t num_keys,
+    const uint64_t* SIMDHWYHASH_RESTRICT key, uint32_t num_partitions,
+    uint32_t* SIMDHWYHASH_RESTRICT partition_ids,
+    size_t* SIMDHWYHASH_RESTRICT histogram);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_PartitionScatter(
+    const uint64_t* SIMDHWYHASH_RESTRICT values, size_t num_values,
+    const uint32_t* SIMDHWYHASH_RESTRICT partition_ids,
+    const size_t* SIMDHWYHASH_RESTRICT histogram, uint32_t num_partitions,
+    uint64_t* SIMDHWYHASH_RESTRICT out);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_PARTITION_H_ */
@@ -0,0 +1,42 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_QUEUE_H_
+#define SIMDHWYHASH_QUEUE_H_
+
+#include "simdhwyhash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct SimdHwyHashQueue SimdHwyHashQueue;
+
+typedef void (*SimdHwyHashQueueCallback)(void* user_data, uint64_t hash);
+
+SIMDHWYHASH_DLLEXPORT SimdHwyHashQueue* SimdHwyHash_QueueCreate(
+    size_t num_workers, size_t ring_capacity, size_t max_batch_size,
+    uint64_t max_latency_ns);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_QueueDestroy(SimdHwyHashQueue* queue);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_Submit(
+    SimdHwyHashQueue* queue, const void* ptr, size_t byte_len,
+    const uint64_t* key, SimdHwyHashQueueCallback callback, void* user_data);
+SIMDHWYHASH_DLLEXPORT void SimdHwyHash_QueueFlush(SimdHwyHashQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_QUEUE_H_ */
@@ -0,0 +1,48 @@
+/* Copyright 2024 John Platts. All Rights Reserved.                         */
+/*                                                                          */
+/* Licensed under the Apache License, Version 2.0 (the "License");          */
+/* you may not use this file except in compliance with the License.         */
+/* You may obtain a copy of the License at                                  */
+/*                                                                          */
+/*     http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                          */
+/* Unless required by applicable law or agreed to in writing, software      */
+/* distributed under the License is distributed on an "AS IS" BASIS,        */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. */
+/* See the License for the specific language governing permissions and      */
+/* limitations under the License.                                           */
+
+#ifndef SIMDHWYHASH_SHARDING_H_
+#define SIMDHWYHASH_SHARDING_H_
+
+#include "simdhwyhash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+SIMDHWYHASH_DLLEXPORT size_t SimdHwyHash_RendezvousSelect(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t (*SIMDHWYHASH_RESTRICT node_keys)[4], size_t num_nodes,
+    const double* SIMDHWYHASH_RESTRICT weights, size_t top_k,
+    size_t* SIMDHWYHASH_RESTRICT out);
+
+SIMDHWYHASH_DLLEXPORT uint32_t SimdHwyHash_JumpSelect(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t* SIMDHWYHASH_RESTRICT key, uint32_t num_buckets);
+
+SIMDHWYHASH_DLLEXPORT int SimdHwyHash_MaglevBuild(
+    const void* const* SIMDHWYHASH_RESTRICT node_ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT node_byte_lens, size_t num_nodes,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint32_t* SIMDHWYHASH_RESTRICT table, size_t table_size);
+SIMDHWYHASH_DLLEXPORT uint32_t SimdHwyHash_MaglevSelect(
+    const uint32_t* SIMDHWYHASH_RESTRICT table, size_t table_size,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t* SIMDHWYHASH_RESTRICT key);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SIMDHWYHASH_SHARDING_H_ */
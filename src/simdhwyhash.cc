@@ -14,14 +14,74 @@
 
 #include "simdhwyhash.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#if defined(SIMDHWYHASH_HEADER_ONLY)
+// The header-only build only compiles HWY_STATIC_TARGET, which is the best
+// target that is enabled by the compiler flags
+#include "hwy/cache_control.h"
+#include "hwy/highway.h"
+#else
 #undef HWY_TARGET_INCLUDE
 #define HWY_TARGET_INCLUDE "simdhwyhash.cc"
 #include "hwy/foreach_target.h"
+#include "hwy/cache_control.h"
 #include "hwy/highway.h"
+#endif  // defined(SIMDHWYHASH_HEADER_ONLY)
+
+#ifndef SIMDHWYHASH_LARGE_INPUT_THRESHOLD
+#define SIMDHWYHASH_LARGE_INPUT_THRESHOLD 262144
+#endif
+
+#ifndef SIMDHWYHASH_PREFETCH_DISTANCE
+#define SIMDHWYHASH_PREFETCH_DISTANCE 512
+#endif
 
 // simdhwyhash is a implementation of HighwayHash that uses the Google Highway
 // SIMD library
 
+#ifndef SIMDHWYHASH_TARGET_KERNELS_DEFINED
+#define SIMDHWYHASH_TARGET_KERNELS_DEFINED
+namespace simdhwyhash {
+namespace {
+
+// The kernels of one compiled target that are used by the one-shot hash
+// functions
+struct AutotunedKernels {
+  int64_t target;
+  uint64_t (*hash64)(const uint8_t* ptr, size_t byte_len, const uint64_t* key,
+                     bool padded);
+  void (*hash128)(const uint8_t* ptr, size_t byte_len, const uint64_t* key,
+                  bool padded, uint64_t* hash);
+  void (*hash256)(const uint8_t* ptr, size_t byte_len, const uint64_t* key,
+                  bool padded, uint64_t* hash);
+};
+
+#if !defined(SIMDHWYHASH_HEADER_ONLY)
+// g_target_kernels[i] holds the kernels of the target 1 << i if that target
+// was compiled. Each target fills in its own entry during static
+// initialization, which lets SimdHwyHash_Autotune call the kernels of any
+// target without changing the targets that dynamic dispatch chooses from.
+static AutotunedKernels g_target_kernels[64];
+
+struct TargetKernelsRegistration {
+  explicit TargetKernelsRegistration(const AutotunedKernels& kernels) {
+    g_target_kernels[hwy::Num0BitsBelowLS1Bit_Nonzero64(
+        static_cast<uint64_t>(kernels.target))] = kernels;
+  }
+};
+#endif  // !defined(SIMDHWYHASH_HEADER_ONLY)
+
+}  // namespace
+}  // namespace simdhwyhash
+#endif  // SIMDHWYHASH_TARGET_KERNELS_DEFINED
+
 namespace simdhwyhash {
 
 HWY_BEFORE_NAMESPACE();
@@ -33,6 +93,7 @@ using hwy::ZeroBytes;
 using hwy::HWY_NAMESPACE::Add;
 using hwy::HWY_NAMESPACE::And;
 using hwy::HWY_NAMESPACE::BroadcastBlock;
+using hwy::HWY_NAMESPACE::CappedTag;
 using hwy::HWY_NAMESPACE::DFromV;
 using hwy::HWY_NAMESPACE::FixedTag;
 using hwy::HWY_NAMESPACE::GetLane;
@@ -41,6 +102,7 @@ using hwy::HWY_NAMESPACE::IfThenElseZero;
 using hwy::HWY_NAMESPACE::InsertLane;
 using hwy::HWY_NAMESPACE::Load;
 using hwy::HWY_NAMESPACE::LoadU;
+using hwy::HWY_NAMESPACE::Mask;
 using hwy::HWY_NAMESPACE::Min;
 using hwy::HWY_NAMESPACE::Mul;
 #if HWY_TARGET != HWY_SCALAR
@@ -59,6 +121,7 @@ using hwy::HWY_NAMESPACE::ShiftLeftLanes;
 #endif
 using hwy::HWY_NAMESPACE::Store;
 using hwy::HWY_NAMESPACE::StoreU;
+using hwy::HWY_NAMESPACE::Stream;
 using hwy::HWY_NAMESPACE::TableLookupBytes;
 using hwy::HWY_NAMESPACE::TableLookupLanes;
 using hwy::HWY_NAMESPACE::TFromD;
@@ -310,8 +373,16 @@ static HWY_INLINE AtLeast2LaneU64Vec GetUpperAtLeast2LaneVec(VFrom v) {
 #endif  // HWY_HAVE_TUPLE
 #endif  // HWY_TARGET == HWY_SCALAR
 
-static HWY_INLINE AtLeast2LaneU64Vec
-LoadAtLeast2LanePacketVec(const uint8_t* packet) {
+// How the packets that are hashed by DoUpdateHwyHashState are copied to the
+// destination of SimdHwyHash_CopyAndUpdate
+enum class PacketCopyMode { kNone, kStore, kStream };
+
+// Loads a 16-byte packet (or a 32-byte packet if Lanes(HighwayHashDU64()) is
+// at least 4) and stores the loaded bytes to dst unless kCopyMode is
+// PacketCopyMode::kNone, so that the copy does not load the packet again
+template <PacketCopyMode kCopyMode>
+static HWY_INLINE AtLeast2LaneU64Vec LoadAndCopyAtLeast2LanePacketVec(
+    const uint8_t* HWY_RESTRICT packet, uint8_t* HWY_RESTRICT dst) {
   const HighwayHashDU64 du64;
   using VU64 = Vec<decltype(du64)>;
 
@@ -321,6 +392,10 @@ LoadAtLeast2LanePacketVec(const uint8_t* packet) {
 
   CopyBytes(packet, &lo, sizeof(uint64_t));
   CopyBytes(packet + sizeof(uint64_t), &hi, sizeof(uint64_t));
+  if (kCopyMode != PacketCopyMode::kNone) {
+    CopyBytes(&lo, dst, sizeof(uint64_t));
+    CopyBytes(&hi, dst + sizeof(uint64_t), sizeof(uint64_t));
+  }
 
   VU64 v_lo = Set(du64, lo);
   VU64 v_hi = Set(du64, hi);
@@ -333,7 +408,14 @@ LoadAtLeast2LanePacketVec(const uint8_t* packet) {
   return Create2(du64, v_lo, v_hi);
 #else
   const Repartition<uint8_t, decltype(du64)> du8;
-  VU64 vec = BitCast(du64, LoadU(du8, packet));
+  const auto bytes = LoadU(du8, packet);
+  if (kCopyMode == PacketCopyMode::kStream) {
+    Stream(bytes, du8, dst);
+  } else if (kCopyMode == PacketCopyMode::kStore) {
+    StoreU(bytes, du8, dst);
+  }
+
+  VU64 vec = BitCast(du64, bytes);
 
 #if HWY_IS_BIG_ENDIAN
   vec = ReverseLaneBytes(vec);
@@ -343,15 +425,33 @@ LoadAtLeast2LanePacketVec(const uint8_t* packet) {
 #endif
 }
 
-static HWY_INLINE AtLeast4LaneU64Vec LoadAtLeast4LanePacketVec(
-    const size_t lanes_per_u64_vec, const uint8_t* packet) {
-  const auto v_lo = LoadAtLeast2LanePacketVec(packet);
-  auto v_hi =
-      (lanes_per_u64_vec >= 4) ? v_lo : LoadAtLeast2LanePacketVec(packet + 16);
+static HWY_INLINE AtLeast2LaneU64Vec
+LoadAtLeast2LanePacketVec(const uint8_t* packet) {
+  return LoadAndCopyAtLeast2LanePacketVec<PacketCopyMode::kNone>(packet,
+                                                                 nullptr);
+}
+
+template <PacketCopyMode kCopyMode>
+static HWY_INLINE AtLeast4LaneU64Vec LoadAndCopyAtLeast4LanePacketVec(
+    const size_t lanes_per_u64_vec, const uint8_t* HWY_RESTRICT packet,
+    uint8_t* HWY_RESTRICT dst) {
+  const auto v_lo = LoadAndCopyAtLeast2LanePacketVec<kCopyMode>(packet, dst);
+  auto v_hi = (lanes_per_u64_vec >= 4)
+                  ? v_lo
+                  : LoadAndCopyAtLeast2LanePacketVec<kCopyMode>(
+                        packet + 16,
+                        (kCopyMode != PacketCopyMode::kNone) ? dst + 16
+                                                             : nullptr);
 
   return CombineToAtLeast4LaneVec(v_lo, v_hi);
 }
 
+static HWY_INLINE AtLeast4LaneU64Vec LoadAtLeast4LanePacketVec(
+    const size_t lanes_per_u64_vec, const uint8_t* packet) {
+  return LoadAndCopyAtLeast4LanePacketVec<PacketCopyMode::kNone>(
+      lanes_per_u64_vec, packet, nullptr);
+}
+
 static HWY_INLINE AtLeast2LaneU64Vec
 LoadAtLeast2LaneStateVec(const uint64_t* HWY_RESTRICT ptr) {
   const HighwayHashDU64 du64;
@@ -563,6 +663,33 @@ static HWY_INLINE V AtLeast4LaneU64VecRol32(V a, V b) {
   return CombineToAtLeast4LaneVec(result_lo, result_hi);
 }
 
+// Returns the even lane of the zipper merge of each (lane0, lane1) pair, where
+// lane0 and lane1 hold the even and odd 64-bit lanes of the pair
+template <class D>
+static HWY_INLINE Vec<D> ZipperMergeEvenLane(D d, Vec<D> lane0, Vec<D> lane1) {
+  return Or(Or3(ShiftRight<24>(OrAnd(And(lane0, Set(d, 0xff000000U)), lane1,
+                                     Set(d, 0xff00000000U))),
+                ShiftRight<16>(OrAnd(And(lane0, Set(d, 0xff0000000000U)),
+                                     lane1, Set(d, 0xff000000000000U))),
+                And(lane0, Set(d, 0xff0000U))),
+            Or3(ShiftLeft<32>(And(lane0, Set(d, 0xff00U))),
+                ShiftRight<8>(And(lane1, Set(d, 0xff00000000000000U))),
+                ShiftLeft<56>(lane0)));
+}
+
+// Returns the odd lane of the zipper merge of each (lane0, lane1) pair
+template <class D>
+static HWY_INLINE Vec<D> ZipperMergeOddLane(D d, Vec<D> lane0, Vec<D> lane1) {
+  return Or3(Or3(ShiftRight<24>(OrAnd(And(lane1, Set(d, 0xff000000U)), lane0,
+                                      Set(d, 0xff00000000U))),
+                 And(lane1, Set(d, 0xff0000U)),
+                 ShiftRight<16>(And(lane1, Set(d, 0xff0000000000U)))),
+             Or3(ShiftLeft<24>(And(lane1, Set(d, 0xff00U))),
+                 ShiftRight<8>(And(lane0, Set(d, 0xff000000000000U))),
+                 ShiftLeft<48>(And(lane1, Set(d, 0xffU)))),
+             And(lane0, Set(d, 0xff00000000000000U)));
+}
+
 static HWY_INLINE AtLeast2LaneU64Vec ZipperMerge(AtLeast2LaneU64Vec v) {
   const HighwayHashDU64 du64;
 
@@ -570,25 +697,8 @@ static HWY_INLINE AtLeast2LaneU64Vec ZipperMerge(AtLeast2LaneU64Vec v) {
   const auto v0 = Get2<0>(v);
   const auto v1 = Get2<1>(v);
 
-  const auto r0 =
-      Or(Or3(ShiftRight<24>(OrAnd(And(v0, Set(du64, 0xff000000U)), v1,
-                                  Set(du64, 0xff00000000U))),
-             ShiftRight<16>(OrAnd(And(v0, Set(du64, 0xff0000000000U)), v1,
-                                  Set(du64, 0xff000000000000U))),
-             And(v0, Set(du64, 0xff0000U))),
-         Or3(ShiftLeft<32>(And(v0, Set(du64, 0xff00U))),
-             ShiftRight<8>(And(v1, Set(du64, 0xff00000000000000U))),
-             ShiftLeft<56>(v0)));
-  const auto r1 = Or3(Or3(ShiftRight<24>(OrAnd(And(v1, Set(du64, 0xff000000U)),
-                                               v0, Set(du64, 0xff00000000U))),
-                          And(v1, Set(du64, 0xff0000U)),
-                          ShiftRight<16>(And(v1, Set(du64, 0xff0000000000U)))),
-                      Or3(ShiftLeft<24>(And(v1, Set(du64, 0xff00U))),
-                          ShiftRight<8>(And(v0, Set(du64, 0xff000000000000U))),
-                          ShiftLeft<48>(And(v1, Set(du64, 0xffU)))),
-                      And(v0, Set(du64, 0xff00000000000000U)));
-
-  return Create2(du64, r0, r1);
+  return Create2(du64, ZipperMergeEvenLane(du64, v0, v1),
+                 ZipperMergeOddLane(du64, v0, v1));
 #else  // HWY_TARGET != HWY_SCALAR
 
 #if HWY_IS_BIG_ENDIAN
@@ -637,13 +747,13 @@ static HWY_INLINE void DoHwyHashUpdate(V& v0, V& v1, V& mul0, V& mul1,
   mul1 = CombineToAtLeast4LaneVec(mul1_lo, mul1_hi);
 }
 
-static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
-    const size_t lanes_per_u64_vec, const uint8_t* HWY_RESTRICT ptr,
-    const unsigned remainder_len) {
+// Copies the remainder_len bytes at ptr into packet_bytes, laid out as
+// HighwayHash expects the final partial packet to be laid out
+static HWY_INLINE void CopyRemainderPacketBytes(
+    const uint8_t* HWY_RESTRICT ptr, const unsigned remainder_len,
+    uint8_t* HWY_RESTRICT packet_bytes) {
   const unsigned u32_load_byte_len = remainder_len & (~3u);
 
-#if HWY_TARGET == HWY_SCALAR
-  uint8_t packet_bytes[32];
   ZeroBytes(packet_bytes, 32);
   CopyBytes(ptr, packet_bytes, u32_load_byte_len);
 
@@ -661,9 +771,47 @@ static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
       packet_bytes[18] = ptr[u32_load_byte_len + trailing3_len - 1];
     }
   }
+}
+
+#if HWY_TARGET != HWY_SCALAR
+// Loads the first num_bytes bytes at ptr, and zeroes the remaining lanes. If
+// kPadded is true, a full vector is loaded from ptr and then masked, which
+// requires the full vector to be readable.
+template <bool kPadded, class D>
+static HWY_INLINE Vec<D> LoadRemainderBytes(D d,
+                                            const TFromD<D>* HWY_RESTRICT ptr,
+                                            size_t num_bytes) {
+  if (kPadded) {
+    return IfThenElseZero(FirstN(d, num_bytes), LoadU(d, ptr));
+  }
+  return LoadN(d, ptr, num_bytes);
+}
+
+// Returns byte byte_idx of the remainder bytes that were copied into u32
+static HWY_INLINE uint8_t GetRemainderByte(uint32_t u32, unsigned byte_idx) {
+#if HWY_IS_BIG_ENDIAN
+  return static_cast<uint8_t>(u32 >> (24u - byte_idx * 8u));
+#else
+  return static_cast<uint8_t>(u32 >> (byte_idx * 8u));
+#endif
+}
+#endif  // HWY_TARGET != HWY_SCALAR
 
+// Loads the final partial packet of remainder_len bytes at ptr. If kPadded is
+// true, at least 32 bytes past the end of the input must be readable, which
+// lets the packet be built from full loads that are masked in registers
+// instead of from LoadN and single-byte loads.
+template <bool kPadded>
+static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
+    const size_t lanes_per_u64_vec, const uint8_t* HWY_RESTRICT ptr,
+    const unsigned remainder_len) {
+#if HWY_TARGET == HWY_SCALAR
+  uint8_t packet_bytes[32];
+  CopyRemainderPacketBytes(ptr, remainder_len, packet_bytes);
   return LoadAtLeast4LanePacketVec(lanes_per_u64_vec, packet_bytes);
 #else  // HWY_TARGET == HWY_SCALAR
+  const unsigned u32_load_byte_len = remainder_len & (~3u);
+
   const HighwayHashDU64 du64;
   using VU64 = Vec<decltype(du64)>;
   const Repartition<uint8_t, decltype(du64)> du8;
@@ -673,15 +821,18 @@ static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
 
 #if HWY_MAX_BYTES >= 32 && (!HWY_HAVE_SCALABLE || HWY_TARGET == HWY_RVV)
   (void)lanes_per_u8_vec;
-  auto v_lo = BitCast(du32, LoadN(du8, ptr, u32_load_byte_len));
+  auto v_lo =
+      BitCast(du32, LoadRemainderBytes<kPadded>(du8, ptr, u32_load_byte_len));
 #else
   const size_t lo_u32_load_byte_len =
       HWY_MIN(u32_load_byte_len, lanes_per_u8_vec);
   const size_t hi_u32_load_byte_len = u32_load_byte_len - lo_u32_load_byte_len;
 
-  auto v_lo = BitCast(du32, LoadN(du8, ptr, lo_u32_load_byte_len));
-  auto v_hi = BitCast(
-      du32, LoadN(du8, ptr + lo_u32_load_byte_len, hi_u32_load_byte_len));
+  auto v_lo = BitCast(
+      du32, LoadRemainderBytes<kPadded>(du8, ptr, lo_u32_load_byte_len));
+  auto v_hi = BitCast(du32, LoadRemainderBytes<kPadded>(
+                                du8, ptr + lo_u32_load_byte_len,
+                                hi_u32_load_byte_len));
 #endif
 
   if (remainder_len >= 16) {
@@ -706,9 +857,22 @@ static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
   } else {
     unsigned trailing3_len = remainder_len & 3u;
     if (trailing3_len != 0) {
-      uint8_t packet_b16 = ptr[u32_load_byte_len];
-      uint8_t packet_b17 = ptr[u32_load_byte_len + (trailing3_len >> 1)];
-      uint8_t packet_b18 = ptr[u32_load_byte_len + trailing3_len - 1];
+      uint8_t packet_b16;
+      uint8_t packet_b17;
+      uint8_t packet_b18;
+      if (kPadded) {
+        // The 4 bytes at ptr + u32_load_byte_len are readable, so the trailing
+        // bytes are picked out of a single 4-byte load with shifts
+        uint32_t trailing_u32;
+        CopyBytes(ptr + u32_load_byte_len, &trailing_u32, sizeof(uint32_t));
+        packet_b16 = GetRemainderByte(trailing_u32, 0);
+        packet_b17 = GetRemainderByte(trailing_u32, trailing3_len >> 1);
+        packet_b18 = GetRemainderByte(trailing_u32, trailing3_len - 1);
+      } else {
+        packet_b16 = ptr[u32_load_byte_len];
+        packet_b17 = ptr[u32_load_byte_len + (trailing3_len >> 1)];
+        packet_b18 = ptr[u32_load_byte_len + trailing3_len - 1];
+      }
 
 #if HWY_IS_BIG_ENDIAN
       const uint32_t trailing_bytes =
@@ -758,15 +922,228 @@ static HWY_INLINE AtLeast4LaneU64Vec LoadRemainderPacket(
 #endif  // HWY_TARGET == HWY_SCALAR
 }
 
-static HWY_INLINE void UpdateHwyHashState(SimdHwyHashState* HWY_RESTRICT state,
-                                          const uint8_t* HWY_RESTRICT ptr,
-                                          size_t byte_len) {
+// Adds the remainder length to v0 and rotates each 32-bit half of v1 by the
+// remainder length, which is done before the final partial packet is hashed
+static HWY_INLINE void AddRemainderLen(AtLeast4LaneU64Vec& v0,
+                                       AtLeast4LaneU64Vec& v1,
+                                       const unsigned remainder_len) {
   const HighwayHashDU64 du64;
 #if HWY_TARGET != HWY_SCALAR
   const Repartition<uint32_t, decltype(du64)> du32;
+  const AtLeast2LaneU64Vec vu64_len_x2 =
+      BitCast(du64, Set(du32, static_cast<uint32_t>(remainder_len)));
+#else
+  const Vec<HighwayHashDU64> vu64_len_x1 =
+      Set(du64,
+          static_cast<uint64_t>((static_cast<uint64_t>(remainder_len) << 32) |
+                                remainder_len));
+  const AtLeast2LaneU64Vec vu64_len_x2 =
+      Create2(du64, vu64_len_x1, vu64_len_x1);
 #endif
+  const AtLeast4LaneU64Vec vu64_len_x4 =
+      CombineToAtLeast4LaneVec(vu64_len_x2, vu64_len_x2);
 
-  const size_t lanes_per_u64_vec = Lanes(du64);
+  v0 = AtLeast4LaneU64VecAdd(v0, vu64_len_x4);
+  v1 = AtLeast4LaneU64VecRol32(v1, vu64_len_x4);
+}
+
+static HWY_INLINE uint64_t LoadPacketWord(const uint8_t* HWY_RESTRICT ptr) {
+#if HWY_IS_BIG_ENDIAN
+  uint64_t word = 0;
+  for (size_t i = 0; i < sizeof(uint64_t); i++) {
+    word |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+  }
+  return word;
+#else
+  uint64_t word;
+  CopyBytes(ptr, &word, sizeof(uint64_t));
+  return word;
+#endif
+}
+
+static HWY_INLINE uint64_t LoadPacketU32(const uint8_t* HWY_RESTRICT ptr) {
+#if HWY_IS_BIG_ENDIAN
+  return static_cast<uint64_t>(ptr[0]) | (static_cast<uint64_t>(ptr[1]) << 8) |
+         (static_cast<uint64_t>(ptr[2]) << 16) |
+         (static_cast<uint64_t>(ptr[3]) << 24);
+#else
+  uint32_t word;
+  CopyBytes(ptr, &word, sizeof(uint32_t));
+  return word;
+#endif
+}
+
+// Returns the 32-bit word at ptr + offset if has_word is true, and zero
+// otherwise. The word at ptr is loaded instead if has_word is false, so that
+// no bytes past the end of the input are read and no branch is needed.
+static HWY_INLINE uint64_t LoadPacketU32If(bool has_word,
+                                           const uint8_t* HWY_RESTRICT ptr,
+                                           size_t offset) {
+  const uint64_t word = LoadPacketU32(ptr + (has_word ? offset : 0));
+  return has_word ? word : 0;
+}
+
+// Length classes of inputs of fewer than 64 bytes, each of which is hashed by
+// a dedicated kernel in the one-shot hash functions
+enum class ShortInputClass { kEmpty, k1To3, k4To15, k16To31, k32To63 };
+
+// Returns the length class of an input of byte_len bytes, which must be less
+// than 64
+static HWY_INLINE ShortInputClass GetShortInputClass(size_t byte_len) {
+  return static_cast<ShortInputClass>(
+      static_cast<int>(byte_len != 0) + static_cast<int>(byte_len >= 4) +
+      static_cast<int>(byte_len >= 16) + static_cast<int>(byte_len >= 32));
+}
+
+// Builds the words of the final partial packet of the remainder_len bytes at
+// ptr, where remainder_len is in the length class kClass, which must be k1To3,
+// k4To15, or k16To31. The words are the same as those of the packet that is
+// loaded by LoadRemainderPacket, but are built from 32-bit and 64-bit loads
+// that are known to be within the input.
+template <ShortInputClass kClass>
+static HWY_INLINE void LoadShortRemainderWords(const uint8_t* HWY_RESTRICT ptr,
+                                               const unsigned remainder_len,
+                                               uint64_t (&words)[4]) {
+  static_assert(kClass == ShortInputClass::k1To3 ||
+                    kClass == ShortInputClass::k4To15 ||
+                    kClass == ShortInputClass::k16To31,
+                "kClass must be the length class of a partial packet");
+
+  if constexpr (kClass == ShortInputClass::k16To31) {
+    // The whole 32-bit words of the remainder are followed by zeroes, and the
+    // last 4 bytes of the remainder are in the last 4 bytes of the packet
+    words[0] = LoadPacketWord(ptr);
+    words[1] = LoadPacketWord(ptr + 8);
+    words[2] = LoadPacketU32If(remainder_len >= 20, ptr, 16) |
+               (LoadPacketU32If(remainder_len >= 24, ptr, 20) << 32);
+    words[3] = LoadPacketU32If(remainder_len >= 28, ptr, 24) |
+               (LoadPacketU32(ptr + remainder_len - 4) << 32);
+    return;
+  }
+
+  // The whole 32-bit words of the remainder are followed by zeroes, and the
+  // 1 to 3 remaining bytes are in bytes 16 to 18 of the packet
+  const unsigned u32_load_byte_len = remainder_len & (~3u);
+  const unsigned trailing3_len = remainder_len & 3u;
+  uint64_t trailing_bytes = 0;
+  if (kClass == ShortInputClass::k1To3 || trailing3_len != 0) {
+    const uint8_t* HWY_RESTRICT tail = ptr + u32_load_byte_len;
+    trailing_bytes = static_cast<uint64_t>(tail[0]) |
+                     (static_cast<uint64_t>(tail[trailing3_len >> 1]) << 8) |
+                     (static_cast<uint64_t>(tail[trailing3_len - 1]) << 16);
+  }
+
+  if (kClass == ShortInputClass::k1To3) {
+    words[0] = 0;
+    words[1] = 0;
+  } else {
+    words[0] = LoadPacketU32(ptr) |
+               (LoadPacketU32If(remainder_len >= 8, ptr, 4) << 32);
+    words[1] = LoadPacketU32If(remainder_len >= 12, ptr, 8);
+  }
+  words[2] = trailing_bytes;
+  words[3] = 0;
+}
+
+template <ShortInputClass kClass>
+static HWY_INLINE AtLeast4LaneU64Vec LoadShortRemainderPacket(
+    const size_t lanes_per_u64_vec, const uint8_t* HWY_RESTRICT ptr,
+    const unsigned remainder_len) {
+  uint64_t words[4];
+  LoadShortRemainderWords<kClass>(ptr, remainder_len, words);
+  return LoadAtLeast4LaneStateVec(lanes_per_u64_vec, words);
+}
+
+// Updates state with the byte_len bytes at ptr, where byte_len is in the
+// length class kClass. An input of fewer than 64 bytes is at most one full
+// packet followed by one partial packet, so none of the loop, prefetching, and
+// LoadN and InsertLane logic of DoUpdateHwyHashState is needed.
+template <ShortInputClass kClass>
+static HWY_INLINE void UpdateShortInput(SimdHwyHashState* HWY_RESTRICT state,
+                                        const uint8_t* HWY_RESTRICT ptr,
+                                        size_t byte_len) {
+  static_assert(kClass != ShortInputClass::kEmpty,
+                "The state is not changed by an empty input");
+
+  const size_t lanes_per_u64_vec = Lanes(HighwayHashDU64());
+  AtLeast4LaneU64Vec v0 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->v0);
+  AtLeast4LaneU64Vec v1 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->v1);
+  AtLeast4LaneU64Vec mul0 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->mul0);
+  AtLeast4LaneU64Vec mul1 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->mul1);
+
+  const unsigned remainder_len = static_cast<unsigned>(byte_len & 31u);
+  if constexpr (kClass == ShortInputClass::k32To63) {
+    DoHwyHashUpdate(v0, v1, mul0, mul1,
+                    LoadAtLeast4LanePacketVec(lanes_per_u64_vec, ptr));
+    if (remainder_len != 0) {
+      AddRemainderLen(v0, v1, remainder_len);
+      const uint8_t* HWY_RESTRICT remainder = ptr + 32;
+      if (remainder_len >= 16) {
+        DoHwyHashUpdate(v0, v1, mul0, mul1,
+                        LoadShortRemainderPacket<ShortInputClass::k16To31>(
+                            lanes_per_u64_vec, remainder, remainder_len));
+      } else if (remainder_len >= 4) {
+        DoHwyHashUpdate(v0, v1, mul0, mul1,
+                        LoadShortRemainderPacket<ShortInputClass::k4To15>(
+                            lanes_per_u64_vec, remainder, remainder_len));
+      } else {
+        DoHwyHashUpdate(v0, v1, mul0, mul1,
+                        LoadShortRemainderPacket<ShortInputClass::k1To3>(
+                            lanes_per_u64_vec, remainder, remainder_len));
+      }
+    }
+  } else {
+    AddRemainderLen(v0, v1, remainder_len);
+    DoHwyHashUpdate(
+        v0, v1, mul0, mul1,
+        LoadShortRemainderPacket<kClass>(lanes_per_u64_vec, ptr,
+                                         remainder_len));
+  }
+
+  StoreAtLeast4LaneStateVec(lanes_per_u64_vec, v0, state->v0);
+  StoreAtLeast4LaneStateVec(lanes_per_u64_vec, v1, state->v1);
+  StoreAtLeast4LaneStateVec(lanes_per_u64_vec, mul0, state->mul0);
+  StoreAtLeast4LaneStateVec(lanes_per_u64_vec, mul1, state->mul1);
+}
+
+// Inputs of at least kLargeInputThreshold bytes are hashed with software
+// prefetches issued kPrefetchDistance bytes ahead of the packet being hashed
+static constexpr size_t kLargeInputThreshold =
+    static_cast<size_t>(SIMDHWYHASH_LARGE_INPUT_THRESHOLD);
+static constexpr size_t kPrefetchDistance =
+    static_cast<size_t>(SIMDHWYHASH_PREFETCH_DISTANCE);
+
+static_assert(kLargeInputThreshold >= kPrefetchDistance + 64,
+              "SIMDHWYHASH_LARGE_INPUT_THRESHOLD must be at least "
+              "SIMDHWYHASH_PREFETCH_DISTANCE + 64");
+
+// Prefetches the cache line at ptr with a hint that it will be accessed only
+// once, which keeps it from evicting other lines from the outer cache levels
+static HWY_INLINE void PrefetchNonTemporal(const uint8_t* ptr) {
+#if HWY_ARCH_X86 && !defined(HWY_DISABLE_CACHE_CONTROL)
+  _mm_prefetch(reinterpret_cast<const char*>(ptr), _MM_HINT_NTA);
+#elif HWY_COMPILER_GCC
+  __builtin_prefetch(ptr, 0, 0);
+#else
+  (void)ptr;
+#endif
+}
+
+// Updates state with the byte_len bytes at ptr. If kCopyMode is not
+// PacketCopyMode::kNone, the input is also copied to dst, with each full
+// packet stored from the vectors that it is hashed from.
+template <bool kPadded, PacketCopyMode kCopyMode = PacketCopyMode::kNone>
+static HWY_INLINE void DoUpdateHwyHashState(
+    SimdHwyHashState* HWY_RESTRICT state, const uint8_t* HWY_RESTRICT ptr,
+    size_t byte_len, uint8_t* HWY_RESTRICT dst = nullptr) {
+  static_assert(!kPadded || kCopyMode == PacketCopyMode::kNone,
+                "The padded update does not copy the input");
+
+  const size_t lanes_per_u64_vec = Lanes(HighwayHashDU64());
   AtLeast4LaneU64Vec v0 =
       LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->v0);
   AtLeast4LaneU64Vec v1 =
@@ -777,31 +1154,56 @@ static HWY_INLINE void UpdateHwyHashState(SimdHwyHashState* HWY_RESTRICT state,
       LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->mul1);
 
   const uint8_t* full32_end_ptr = ptr + (byte_len & static_cast<size_t>(-32));
+
+  if (byte_len >= kLargeInputThreshold) {
+    // Large inputs are usually not reused after they are hashed, and the
+    // serial dependency chain of HighwayHash leaves the loads of upcoming
+    // packets exposed unless they are prefetched
+    const uint8_t* prefetch_end_ptr =
+        ptr + ((byte_len - kPrefetchDistance) & static_cast<size_t>(-64));
+    for (; ptr != prefetch_end_ptr; ptr += 64) {
+      PrefetchNonTemporal(ptr + kPrefetchDistance);
+
+      const auto a0 = LoadAndCopyAtLeast4LanePacketVec<kCopyMode>(
+          lanes_per_u64_vec, ptr, dst);
+      DoHwyHashUpdate(v0, v1, mul0, mul1, a0);
+      const auto a1 = LoadAndCopyAtLeast4LanePacketVec<kCopyMode>(
+          lanes_per_u64_vec, ptr + 32,
+          (kCopyMode != PacketCopyMode::kNone) ? dst + 32 : nullptr);
+      DoHwyHashUpdate(v0, v1, mul0, mul1, a1);
+
+      if (kCopyMode != PacketCopyMode::kNone) {
+        dst += 64;
+      }
+    }
+  }
+
   for (; ptr != full32_end_ptr; ptr += 32) {
-    const auto a = LoadAtLeast4LanePacketVec(lanes_per_u64_vec, ptr);
+    const auto a = LoadAndCopyAtLeast4LanePacketVec<kCopyMode>(
+        lanes_per_u64_vec, ptr, dst);
     DoHwyHashUpdate(v0, v1, mul0, mul1, a);
+
+    if (kCopyMode != PacketCopyMode::kNone) {
+      dst += 32;
+    }
+  }
+
+  if (kCopyMode == PacketCopyMode::kStream) {
+    // Non-temporal stores are weakly ordered, so fence them to make the copy
+    // visible to other threads in the same way as ordinary stores
+    hwy::FlushStream();
   }
 
   const unsigned remainder_len = static_cast<unsigned>(byte_len & 31u);
   if (remainder_len != 0) {
-#if HWY_TARGET != HWY_SCALAR
-    const AtLeast2LaneU64Vec vu64_len_x2 =
-        BitCast(du64, Set(du32, static_cast<uint32_t>(remainder_len)));
-#else
-    const Vec<HighwayHashDU64> vu64_len_x1 =
-        Set(du64,
-            static_cast<uint64_t>((static_cast<uint64_t>(remainder_len) << 32) |
-                                  remainder_len));
-    const AtLeast2LaneU64Vec vu64_len_x2 =
-        Create2(du64, vu64_len_x1, vu64_len_x1);
-#endif
-    const AtLeast4LaneU64Vec vu64_len_x4 =
-        CombineToAtLeast4LaneVec(vu64_len_x2, vu64_len_x2);
+    AddRemainderLen(v0, v1, remainder_len);
 
-    v0 = AtLeast4LaneU64VecAdd(v0, vu64_len_x4);
-    v1 = AtLeast4LaneU64VecRol32(v1, vu64_len_x4);
+    if (kCopyMode != PacketCopyMode::kNone) {
+      CopyBytes(ptr, dst, remainder_len);
+    }
 
-    const auto a = LoadRemainderPacket(lanes_per_u64_vec, ptr, remainder_len);
+    const auto a =
+        LoadRemainderPacket<kPadded>(lanes_per_u64_vec, ptr, remainder_len);
     DoHwyHashUpdate(v0, v1, mul0, mul1, a);
   }
 
@@ -811,6 +1213,36 @@ static HWY_INLINE void UpdateHwyHashState(SimdHwyHashState* HWY_RESTRICT state,
   StoreAtLeast4LaneStateVec(lanes_per_u64_vec, mul1, state->mul1);
 }
 
+static void UpdateHwyHashState(SimdHwyHashState* HWY_RESTRICT state,
+                               const uint8_t* HWY_RESTRICT ptr,
+                               size_t byte_len) {
+  DoUpdateHwyHashState<false>(state, ptr, byte_len);
+}
+
+// Same as UpdateHwyHashState, but requires at least
+// SIMDHWYHASH_INPUT_PADDING bytes past the end of the input to be readable
+static void UpdateHwyHashStatePadded(SimdHwyHashState* HWY_RESTRICT state,
+                                     const uint8_t* HWY_RESTRICT ptr,
+                                     size_t byte_len) {
+  DoUpdateHwyHashState<true>(state, ptr, byte_len);
+}
+
+// Same as UpdateHwyHashState, but also copies the input to dst. The packets
+// are written with non-temporal stores if non_temporal is true and dst is
+// 32-byte aligned, as the vectors that are streamed are at most 32 bytes.
+static void CopyAndUpdateHwyHashState(SimdHwyHashState* HWY_RESTRICT state,
+                                      uint8_t* HWY_RESTRICT dst,
+                                      const uint8_t* HWY_RESTRICT src,
+                                      size_t byte_len, bool non_temporal) {
+  if (non_temporal && (reinterpret_cast<uintptr_t>(dst) & 31u) == 0) {
+    DoUpdateHwyHashState<false, PacketCopyMode::kStream>(state, src, byte_len,
+                                                         dst);
+  } else {
+    DoUpdateHwyHashState<false, PacketCopyMode::kStore>(state, src, byte_len,
+                                                        dst);
+  }
+}
+
 #if HWY_TARGET == HWY_SCALAR
 static HWY_INLINE AtLeast4LaneU64Vec PermuteV0(AtLeast4LaneU64Vec& v0) {
   return Create4(HighwayHashDU64(), RotateRight<32>(Get4<2>(v0)),
@@ -1207,80 +1639,1793 @@ static void Finalize256(SimdHwyHashState* HWY_RESTRICT state,
   StoreHash256(lanes_per_u64_vec, v_hash, hash);
 }
 
-}  // namespace
-}  // namespace HWY_NAMESPACE
-HWY_AFTER_NAMESPACE();
+// "SXOF" followed by version 1 of the extendable-output construction, which is
+// absorbed together with the block counter so that no block of the output of
+// FinalizeXof is related to the output of Finalize256
+static constexpr uint64_t kXofDomainAndVersion = 0x00000001464F5853u;
 
-#if HWY_ONCE
-namespace {
-HWY_EXPORT(ResetHwyHashState);
-HWY_EXPORT(UpdateHwyHashState);
-HWY_EXPORT(Finalize64);
-HWY_EXPORT(Finalize128);
-HWY_EXPORT(Finalize256);
-}  // namespace
-#endif  // HWY_ONCE
+// Finalizes state with the same rounds as Finalize256, and then computes block
+// i of the output (words 4 * i to 4 * i + 3) by absorbing a packet of i and
+// kXofDomainAndVersion into a copy of the finalized state, followed by four
+// PermuteAndUpdate rounds and the modular reduction of Finalize256. Each block
+// only depends on the finalized state and its counter, so every 4 words of
+// output cost 5 rounds instead of a rehash of the input with another key.
+static void FinalizeXof(SimdHwyHashState* HWY_RESTRICT state,
+                        uint64_t* HWY_RESTRICT out, size_t num_words) {
+  const size_t lanes_per_u64_vec = Lanes(HighwayHashDU64());
+  AtLeast4LaneU64Vec v0 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->v0);
+  AtLeast4LaneU64Vec v1 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->v1);
+  AtLeast4LaneU64Vec mul0 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->mul0);
+  AtLeast4LaneU64Vec mul1 =
+      LoadAtLeast4LaneStateVec(lanes_per_u64_vec, state->mul1);
 
-}  // namespace simdhwyhash
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
+  PermuteAndUpdate(v0, v1, mul0, mul1);
 
-#if HWY_ONCE
-extern "C" {
+  for (uint64_t block = 0; num_words != 0; block++) {
+    const uint64_t packet_words[4] = {block, kXofDomainAndVersion, block,
+                                      kXofDomainAndVersion};
+    AtLeast4LaneU64Vec block_v0 = v0;
+    AtLeast4LaneU64Vec block_v1 = v1;
+    AtLeast4LaneU64Vec block_mul0 = mul0;
+    AtLeast4LaneU64Vec block_mul1 = mul1;
+
+    DoHwyHashUpdate(block_v0, block_v1, block_mul0, block_mul1,
+                    LoadAtLeast4LaneStateVec(lanes_per_u64_vec, packet_words));
+    PermuteAndUpdate(block_v0, block_v1, block_mul0, block_mul1);
+    PermuteAndUpdate(block_v0, block_v1, block_mul0, block_mul1);
+    PermuteAndUpdate(block_v0, block_v1, block_mul0, block_mul1);
+    PermuteAndUpdate(block_v0, block_v1, block_mul0, block_mul1);
+
+    const AtLeast4LaneU64Vec v_block =
+        ModularReduction(AtLeast4LaneU64VecAdd(block_v0, block_mul0),
+                         AtLeast4LaneU64VecAdd(block_v1, block_mul1));
+    if (num_words >= 4) {
+      StoreHash256(lanes_per_u64_vec, v_block, out);
+      out += 4;
+      num_words -= 4;
+    } else {
+      uint64_t last_block[4];
+      StoreHash256(lanes_per_u64_vec, v_block, last_block);
+      CopyBytes(last_block, out, num_words * sizeof(uint64_t));
+      num_words = 0;
+    }
+  }
+}
 
-void SimdHwyHash_Reset(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
-                       const uint64_t* SIMDHWYHASH_RESTRICT key) {
-  using namespace simdhwyhash;
-  HWY_DYNAMIC_DISPATCH(ResetHwyHashState)(state, key);
+// Updates state with the byte_len bytes at ptr, which is the whole input of a
+// one-shot hash. Inputs of fewer than 64 bytes are hashed by the kernel of
+// their length class, which is selected by a single switch, and longer inputs
+// are hashed by DoUpdateHwyHashState.
+template <bool kPadded>
+static HWY_INLINE void UpdateOneShot(SimdHwyHashState* HWY_RESTRICT state,
+                                     const uint8_t* HWY_RESTRICT ptr,
+                                     size_t byte_len) {
+  if (byte_len >= 64) {
+    DoUpdateHwyHashState<kPadded>(state, ptr, byte_len);
+    return;
+  }
+
+  switch (GetShortInputClass(byte_len)) {
+    case ShortInputClass::kEmpty:
+      break;
+    case ShortInputClass::k1To3:
+      UpdateShortInput<ShortInputClass::k1To3>(state, ptr, byte_len);
+      break;
+    case ShortInputClass::k4To15:
+      UpdateShortInput<ShortInputClass::k4To15>(state, ptr, byte_len);
+      break;
+    case ShortInputClass::k16To31:
+      UpdateShortInput<ShortInputClass::k16To31>(state, ptr, byte_len);
+      break;
+    case ShortInputClass::k32To63:
+      UpdateShortInput<ShortInputClass::k32To63>(state, ptr, byte_len);
+      break;
+  }
 }
 
-void SimdHwyHash_Update(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
-                        const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
-  using namespace simdhwyhash;
-  HWY_DYNAMIC_DISPATCH(UpdateHwyHashState)
-  (state, reinterpret_cast<const uint8_t*>(ptr), byte_len);
+// Computes the hash of the byte_len bytes at ptr in a single call, which skips
+// the buffering of partial packets that SimdHwyHash_Update does to support
+// streaming. If padded is true, at least SIMDHWYHASH_INPUT_PADDING bytes past
+// the end of the input must be readable.
+static uint64_t Hash64OneShot(const uint8_t* HWY_RESTRICT ptr, size_t byte_len,
+                              const uint64_t* HWY_RESTRICT key, bool padded) {
+  SimdHwyHashState state;
+  ResetHwyHashState(&state, key);
+  if (padded) {
+    UpdateOneShot<true>(&state, ptr, byte_len);
+  } else {
+    UpdateOneShot<false>(&state, ptr, byte_len);
+  }
+  return Finalize64(&state);
 }
 
-uint64_t SimdHwyHash_Finalize64(SimdHwyHashState* SIMDHWYHASH_RESTRICT state) {
-  using namespace simdhwyhash;
-  return HWY_DYNAMIC_DISPATCH(Finalize64)(state);
+static void Hash128OneShot(const uint8_t* HWY_RESTRICT ptr, size_t byte_len,
+                           const uint64_t* HWY_RESTRICT key, bool padded,
+                           uint64_t* HWY_RESTRICT hash) {
+  SimdHwyHashState state;
+  ResetHwyHashState(&state, key);
+  if (padded) {
+    UpdateOneShot<true>(&state, ptr, byte_len);
+  } else {
+    UpdateOneShot<false>(&state, ptr, byte_len);
+  }
+  Finalize128(&state, hash);
 }
 
-void SimdHwyHash_Finalize128(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
-                             uint64_t* SIMDHWYHASH_RESTRICT hash) {
-  using namespace simdhwyhash;
-  return HWY_DYNAMIC_DISPATCH(Finalize128)(state, hash);
+static void Hash256OneShot(const uint8_t* HWY_RESTRICT ptr, size_t byte_len,
+                           const uint64_t* HWY_RESTRICT key, bool padded,
+                           uint64_t* HWY_RESTRICT hash) {
+  SimdHwyHashState state;
+  ResetHwyHashState(&state, key);
+  if (padded) {
+    UpdateOneShot<true>(&state, ptr, byte_len);
+  } else {
+    UpdateOneShot<false>(&state, ptr, byte_len);
+  }
+  Finalize256(&state, hash);
 }
 
-void SimdHwyHash_Finalize256(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
-                             uint64_t* SIMDHWYHASH_RESTRICT hash) {
-  using namespace simdhwyhash;
-  return HWY_DYNAMIC_DISPATCH(Finalize256)(state, hash);
+#if !defined(SIMDHWYHASH_HEADER_ONLY)
+static const TargetKernelsRegistration kTargetKernelsRegistration(
+    AutotunedKernels{HWY_TARGET, &Hash64OneShot, &Hash128OneShot,
+                     &Hash256OneShot});
+#endif
+
+// Lane-interleaved HighwayHash states are used to advance several independent
+// streams at once. Lane j of row i of v0, v1, mul0, and mul1 holds word i of
+// the corresponding member of the state of stream j, which allows each step of
+// HighwayHash to be carried out for Lanes(InterleavedDU64()) streams by the
+// same vector instructions.
+
+using InterleavedDU64 = CappedTag<uint64_t, 8>;
+
+static constexpr size_t kInterleavedMaxLanes = HWY_MAX_LANES_D(InterleavedDU64);
+
+struct InterleavedHwyHashStates {
+  alignas(64) uint64_t v0[4][kInterleavedMaxLanes];
+  alignas(64) uint64_t v1[4][kInterleavedMaxLanes];
+  alignas(64) uint64_t mul0[4][kInterleavedMaxLanes];
+  alignas(64) uint64_t mul1[4][kInterleavedMaxLanes];
+};
+
+// Updates the lanes of states that are selected by m with the packet that is
+// held in the corresponding lanes of packet_words
+static HWY_INLINE void InterleavedHwyHashUpdate(
+    InterleavedDU64 d, Mask<InterleavedDU64> m,
+    InterleavedHwyHashStates& states,
+    const uint64_t (&packet_words)[4][kInterleavedMaxLanes]) {
+  for (size_t i = 0; i < 4; i += 2) {
+    auto v0_lo = Load(d, states.v0[i]);
+    auto v1_lo = Load(d, states.v1[i]);
+    auto mul0_lo = Load(d, states.mul0[i]);
+    auto mul1_lo = Load(d, states.mul1[i]);
+
+    auto v0_hi = Load(d, states.v0[i + 1]);
+    auto v1_hi = Load(d, states.v1[i + 1]);
+    auto mul0_hi = Load(d, states.mul0[i + 1]);
+    auto mul1_hi = Load(d, states.mul1[i + 1]);
+
+    HwyHashUpdateStep1(d, v0_lo, v1_lo, mul0_lo, mul1_lo,
+                       Load(d, packet_words[i]));
+    HwyHashUpdateStep1(d, v0_hi, v1_hi, mul0_hi, mul1_hi,
+                       Load(d, packet_words[i + 1]));
+
+    const auto v1_merged_lo = ZipperMergeEvenLane(d, v1_lo, v1_hi);
+    const auto v1_merged_hi = ZipperMergeOddLane(d, v1_lo, v1_hi);
+    v0_lo = Add(v0_lo, v1_merged_lo);
+    v0_hi = Add(v0_hi, v1_merged_hi);
+
+    const auto v0_merged_lo = ZipperMergeEvenLane(d, v0_lo, v0_hi);
+    const auto v0_merged_hi = ZipperMergeOddLane(d, v0_lo, v0_hi);
+    v1_lo = Add(v1_lo, v0_merged_lo);
+    v1_hi = Add(v1_hi, v0_merged_hi);
+
+    BlendedStore(v0_lo, m, d, states.v0[i]);
+    BlendedStore(v1_lo, m, d, states.v1[i]);
+    BlendedStore(mul0_lo, m, d, states.mul0[i]);
+    BlendedStore(mul1_lo, m, d, states.mul1[i]);
+
+    BlendedStore(v0_hi, m, d, states.v0[i + 1]);
+    BlendedStore(v1_hi, m, d, states.v1[i + 1]);
+    BlendedStore(mul0_hi, m, d, states.mul0[i + 1]);
+    BlendedStore(mul1_hi, m, d, states.mul1[i + 1]);
+  }
 }
 
-uint64_t SimdHwyHash_Hash64(const void* SIMDHWYHASH_RESTRICT ptr,
-                            size_t byte_len,
-                            const uint64_t* SIMDHWYHASH_RESTRICT key) {
-  SimdHwyHashState state;
-  SimdHwyHash_Reset(&state, key);
-  SimdHwyHash_Update(&state, ptr, byte_len);
-  return SimdHwyHash_Finalize64(&state);
+// Adds the remainder length to v0 and rotates each 32-bit half of v1 by the
+// remainder length in the lanes of states that are selected by m
+static HWY_INLINE void InterleavedAddRemainderLen(
+    InterleavedDU64 d, Mask<InterleavedDU64> m,
+    InterleavedHwyHashStates& states, Vec<InterleavedDU64> remainder_len) {
+  const auto len_x2 = Or(ShiftLeft<32>(remainder_len), remainder_len);
+  const auto lo32_mask = Set(d, uint64_t{0xffffffffU});
+  const auto shr_amt = Sub(Set(d, uint64_t{32}), remainder_len);
+
+  for (size_t i = 0; i < 4; i++) {
+    BlendedStore(Add(Load(d, states.v0[i]), len_x2), m, d, states.v0[i]);
+
+    const auto v1 = Load(d, states.v1[i]);
+    const auto v1_lo = And(v1, lo32_mask);
+    const auto v1_hi = ShiftRight<32>(v1);
+    const auto rot_v1_lo =
+        And(Or(Shl(v1_lo, remainder_len), Shr(v1_lo, shr_amt)), lo32_mask);
+    const auto rot_v1_hi =
+        And(Or(Shl(v1_hi, remainder_len), Shr(v1_hi, shr_amt)), lo32_mask);
+    BlendedStore(Or(ShiftLeft<32>(rot_v1_hi), rot_v1_lo), m, d, states.v1[i]);
+  }
 }
 
-void SimdHwyHash_Hash128(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
-                         const uint64_t* SIMDHWYHASH_RESTRICT key,
-                         uint64_t* SIMDHWYHASH_RESTRICT hash) {
-  SimdHwyHashState state;
-  SimdHwyHash_Reset(&state, key);
-  SimdHwyHash_Update(&state, ptr, byte_len);
-  SimdHwyHash_Finalize128(&state, hash);
+// Updates lane j of states with the byte_lens[j] bytes at ptrs[j] for each j
+// less than num_streams, in the same manner as UpdateHwyHashState
+static HWY_INLINE void InterleavedUpdatePackets(
+    InterleavedDU64 d, InterleavedHwyHashStates& states,
+    const void* const* HWY_RESTRICT ptrs, const size_t* HWY_RESTRICT byte_lens,
+    size_t num_streams) {
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  alignas(64) uint64_t num_full_packets[kInterleavedMaxLanes];
+  alignas(64) uint64_t remainder_lens[kInterleavedMaxLanes];
+  alignas(64) uint64_t packet_words[4][kInterleavedMaxLanes];
+  ZeroBytes(packet_words, sizeof(packet_words));
+
+  size_t max_full_packets = 0;
+  for (size_t j = 0; j < lanes_per_u64_vec; j++) {
+    const size_t byte_len = (j < num_streams) ? byte_lens[j] : 0;
+    num_full_packets[j] = static_cast<uint64_t>(byte_len >> 5);
+    remainder_lens[j] = static_cast<uint64_t>(byte_len & 31u);
+    max_full_packets = HWY_MAX(max_full_packets, byte_len >> 5);
+  }
+
+  const auto v_num_full_packets = Load(d, num_full_packets);
+  for (size_t k = 0; k < max_full_packets; k++) {
+    for (size_t j = 0; j < num_streams; j++) {
+      if (k < num_full_packets[j]) {
+        const uint8_t* packet = static_cast<const uint8_t*>(ptrs[j]) + k * 32;
+        for (size_t i = 0; i < 4; i++) {
+          packet_words[i][j] = LoadPacketWord(packet + i * sizeof(uint64_t));
+        }
+      }
+    }
+
+    const auto m = Lt(Set(d, static_cast<uint64_t>(k)), v_num_full_packets);
+    InterleavedHwyHashUpdate(d, m, states, packet_words);
+  }
+
+  const auto v_remainder_lens = Load(d, remainder_lens);
+  const auto remainder_mask = Ne(v_remainder_lens, Zero(d));
+  if (AllFalse(d, remainder_mask)) {
+    return;
+  }
+
+  InterleavedAddRemainderLen(d, remainder_mask, states, v_remainder_lens);
+  for (size_t j = 0; j < num_streams; j++) {
+    const unsigned remainder_len = static_cast<unsigned>(remainder_lens[j]);
+    if (remainder_len != 0) {
+      uint8_t packet_bytes[32];
+      CopyRemainderPacketBytes(static_cast<const uint8_t*>(ptrs[j]) +
+                                   (byte_lens[j] & static_cast<size_t>(-32)),
+                               remainder_len, packet_bytes);
+      for (size_t i = 0; i < 4; i++) {
+        packet_words[i][j] =
+            LoadPacketWord(packet_bytes + i * sizeof(uint64_t));
+      }
+    }
+  }
+
+  InterleavedHwyHashUpdate(d, remainder_mask, states, packet_words);
 }
 
-void SimdHwyHash_Hash256(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
-                         const uint64_t* SIMDHWYHASH_RESTRICT key,
-                         uint64_t* SIMDHWYHASH_RESTRICT hash) {
-  SimdHwyHashState state;
-  SimdHwyHash_Reset(&state, key);
-  SimdHwyHash_Update(&state, ptr, byte_len);
-  SimdHwyHash_Finalize256(&state, hash);
+static HWY_INLINE void InterleavedPermuteAndUpdate(
+    InterleavedDU64 d, InterleavedHwyHashStates& states) {
+  alignas(64) uint64_t permuted_v0[4][kInterleavedMaxLanes];
+  for (size_t i = 0; i < 4; i++) {
+    Store(RotateRight<32>(Load(d, states.v0[i ^ 2])), d, permuted_v0[i]);
+  }
+
+  InterleavedHwyHashUpdate(d, FirstN(d, Lanes(d)), states, permuted_v0);
+}
+
+static HWY_INLINE void InterleavedFinalize64(InterleavedDU64 d,
+                                             InterleavedHwyHashStates& states,
+                                             size_t num_streams,
+                                             uint64_t* HWY_RESTRICT hashes) {
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+
+  const auto v_hash =
+      Add(Add(Load(d, states.v0[0]), Load(d, states.v1[0])),
+          Add(Load(d, states.mul0[0]), Load(d, states.mul1[0])));
+  StoreN(v_hash, d, hashes, num_streams);
+}
+
+// Finalizes states and stores word i of the 128-bit hash of stream j in
+// lane j of hash_words[i]
+static HWY_INLINE void InterleavedFinalize128Words(
+    InterleavedDU64 d, InterleavedHwyHashStates& states,
+    uint64_t (&hash_words)[2][kInterleavedMaxLanes]) {
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+
+  for (size_t i = 0; i < 2; i++) {
+    Store(Add(Add(Load(d, states.v0[i]), Load(d, states.mul0[i])),
+              Add(Load(d, states.v1[i + 2]), Load(d, states.mul1[i + 2]))),
+          d, hash_words[i]);
+  }
+}
+
+static HWY_INLINE void InterleavedFinalize128(InterleavedDU64 d,
+                                              InterleavedHwyHashStates& states,
+                                              size_t num_streams,
+                                              uint64_t* HWY_RESTRICT hashes) {
+  alignas(64) uint64_t hash_words[2][kInterleavedMaxLanes];
+  InterleavedFinalize128Words(d, states, hash_words);
+
+  for (size_t j = 0; j < num_streams; j++) {
+    hashes[j * 2] = hash_words[0][j];
+    hashes[j * 2 + 1] = hash_words[1][j];
+  }
+}
+
+// Stores word i of the modular reduction of Finalize256 of the state of stream
+// j in lane j of hash_words[i]
+static HWY_INLINE void InterleavedModularReduction(
+    InterleavedDU64 d, const InterleavedHwyHashStates& states,
+    uint64_t (&hash_words)[4][kInterleavedMaxLanes]) {
+  for (size_t i = 0; i < 4; i += 2) {
+    const auto a0 = Add(Load(d, states.v0[i]), Load(d, states.mul0[i]));
+    const auto a1 = Add(Load(d, states.v0[i + 1]), Load(d, states.mul0[i + 1]));
+    const auto a2 = Add(Load(d, states.v1[i]), Load(d, states.mul1[i]));
+    const auto a3 =
+        And(Add(Load(d, states.v1[i + 1]), Load(d, states.mul1[i + 1])),
+            Set(d, uint64_t{0x3FFFFFFFFFFFFFFFu}));
+
+    Store(Xor3(a0, ShiftLeft<1>(a2), ShiftLeft<2>(a2)), d, hash_words[i]);
+    Store(Xor3(a1, Or(ShiftLeft<1>(a3), ShiftRight<63>(a2)),
+               Or(ShiftLeft<2>(a3), ShiftRight<62>(a2))),
+          d, hash_words[i + 1]);
+  }
+}
+
+static HWY_INLINE void InterleavedFinalize256(InterleavedDU64 d,
+                                              InterleavedHwyHashStates& states,
+                                              size_t num_streams,
+                                              uint64_t* HWY_RESTRICT hashes) {
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+  InterleavedPermuteAndUpdate(d, states);
+
+  alignas(64) uint64_t hash_words[4][kInterleavedMaxLanes];
+  InterleavedModularReduction(d, states, hash_words);
+
+  for (size_t j = 0; j < num_streams; j++) {
+    hashes[j * 4] = hash_words[0][j];
+    hashes[j * 4 + 1] = hash_words[1][j];
+    hashes[j * 4 + 2] = hash_words[2][j];
+    hashes[j * 4 + 3] = hash_words[3][j];
+  }
+}
+
+static HWY_INLINE void LoadPoolStates(
+    const SimdHwyHashStatePool* HWY_RESTRICT pool,
+    const size_t* HWY_RESTRICT indices, size_t num_streams,
+    InterleavedHwyHashStates& states) {
+  const size_t capacity = pool->capacity;
+  const uint64_t* HWY_RESTRICT words = pool->words;
+
+  for (size_t i = 0; i < 4; i++) {
+    for (size_t j = 0; j < num_streams; j++) {
+      const size_t idx = indices[j];
+      states.v0[i][j] = words[i * capacity + idx];
+      states.v1[i][j] = words[(4 + i) * capacity + idx];
+      states.mul0[i][j] = words[(8 + i) * capacity + idx];
+      states.mul1[i][j] = words[(12 + i) * capacity + idx];
+    }
+  }
+}
+
+static HWY_INLINE void StorePoolStates(
+    const InterleavedHwyHashStates& states, const size_t* HWY_RESTRICT indices,
+    size_t num_streams, SimdHwyHashStatePool* HWY_RESTRICT pool) {
+  const size_t capacity = pool->capacity;
+  uint64_t* HWY_RESTRICT words = pool->words;
+
+  for (size_t i = 0; i < 4; i++) {
+    for (size_t j = 0; j < num_streams; j++) {
+      const size_t idx = indices[j];
+      words[i * capacity + idx] = states.v0[i][j];
+      words[(4 + i) * capacity + idx] = states.v1[i][j];
+      words[(8 + i) * capacity + idx] = states.mul0[i][j];
+      words[(12 + i) * capacity + idx] = states.mul1[i][j];
+    }
+  }
+}
+
+static void UpdateHwyHashStatePool(SimdHwyHashStatePool* HWY_RESTRICT pool,
+                                   const size_t* HWY_RESTRICT indices,
+                                   const void* const* HWY_RESTRICT ptrs,
+                                   const size_t* HWY_RESTRICT byte_lens,
+                                   size_t num_streams) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  InterleavedHwyHashStates states;
+  ZeroBytes(&states, sizeof(InterleavedHwyHashStates));
+
+  for (size_t i = 0; i < num_streams; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_streams - i);
+    LoadPoolStates(pool, indices + i, n, states);
+    InterleavedUpdatePackets(d, states, ptrs + i, byte_lens + i, n);
+    StorePoolStates(states, indices + i, n, pool);
+  }
+}
+
+static void FinalizeHwyHashStatePool64(
+    const SimdHwyHashStatePool* HWY_RESTRICT pool,
+    const size_t* HWY_RESTRICT indices, size_t num_streams,
+    uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  InterleavedHwyHashStates states;
+  ZeroBytes(&states, sizeof(InterleavedHwyHashStates));
+
+  for (size_t i = 0; i < num_streams; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_streams - i);
+    LoadPoolStates(pool, indices + i, n, states);
+    InterleavedFinalize64(d, states, n, hashes + i);
+  }
+}
+
+static void FinalizeHwyHashStatePool128(
+    const SimdHwyHashStatePool* HWY_RESTRICT pool,
+    const size_t* HWY_RESTRICT indices, size_t num_streams,
+    uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  InterleavedHwyHashStates states;
+  ZeroBytes(&states, sizeof(InterleavedHwyHashStates));
+
+  for (size_t i = 0; i < num_streams; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_streams - i);
+    LoadPoolStates(pool, indices + i, n, states);
+    InterleavedFinalize128(d, states, n, hashes + i * 2);
+  }
+}
+
+static void FinalizeHwyHashStatePool256(
+    const SimdHwyHashStatePool* HWY_RESTRICT pool,
+    const size_t* HWY_RESTRICT indices, size_t num_streams,
+    uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  InterleavedHwyHashStates states;
+  ZeroBytes(&states, sizeof(InterleavedHwyHashStates));
+
+  for (size_t i = 0; i < num_streams; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_streams - i);
+    LoadPoolStates(pool, indices + i, n, states);
+    InterleavedFinalize256(d, states, n, hashes + i * 4);
+  }
+}
+
+// Computes the 64-bit hashes of the byte_lens[i] bytes at ptrs[i] under key
+// for each i less than num_inputs, Lanes(InterleavedDU64()) inputs at a time
+static void Hash64Batch(const void* const* HWY_RESTRICT ptrs,
+                        const size_t* HWY_RESTRICT byte_lens,
+                        size_t num_inputs, const uint64_t* HWY_RESTRICT key,
+                        uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  SimdHwyHashState init_state;
+  ResetHwyHashState(&init_state, key);
+
+  InterleavedHwyHashStates states;
+  for (size_t i = 0; i < num_inputs; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_inputs - i);
+    for (size_t j = 0; j < 4; j++) {
+      Store(Set(d, init_state.v0[j]), d, states.v0[j]);
+      Store(Set(d, init_state.v1[j]), d, states.v1[j]);
+      Store(Set(d, init_state.mul0[j]), d, states.mul0[j]);
+      Store(Set(d, init_state.mul1[j]), d, states.mul1[j]);
+    }
+
+    InterleavedUpdatePackets(d, states, ptrs + i, byte_lens + i, n);
+    InterleavedFinalize64(d, states, n, hashes + i);
+  }
+}
+
+// Computes the 128-bit hashes of the byte_lens[i] bytes at ptrs[i] under key,
+// which are stored in hashes[i * 2] and hashes[i * 2 + 1], for each i less
+// than num_inputs, Lanes(InterleavedDU64()) inputs at a time
+static void Hash128Batch(const void* const* HWY_RESTRICT ptrs,
+                         const size_t* HWY_RESTRICT byte_lens,
+                         size_t num_inputs, const uint64_t* HWY_RESTRICT key,
+                         uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  SimdHwyHashState init_state;
+  ResetHwyHashState(&init_state, key);
+
+  InterleavedHwyHashStates states;
+  for (size_t i = 0; i < num_inputs; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_inputs - i);
+    for (size_t j = 0; j < 4; j++) {
+      Store(Set(d, init_state.v0[j]), d, states.v0[j]);
+      Store(Set(d, init_state.v1[j]), d, states.v1[j]);
+      Store(Set(d, init_state.mul0[j]), d, states.mul0[j]);
+      Store(Set(d, init_state.mul1[j]), d, states.mul1[j]);
+    }
+
+    InterleavedUpdatePackets(d, states, ptrs + i, byte_lens + i, n);
+    InterleavedFinalize128(d, states, n, hashes + i * 2);
+  }
+}
+
+// Computes the 128-bit tags of the byte_lens[i] bytes at ptrs[i] under key,
+// Lanes(InterleavedDU64()) inputs at a time, and sets bit i of ok_bitmap if
+// the tag of input i is equal to tags[i]. The computed tags are compared with
+// vector instructions and without branches that depend on the tags, so the
+// time that is taken does not reveal how much of a forged tag was correct.
+// Returns the number of inputs whose tags are correct.
+static size_t VerifyBatch128(const void* const* HWY_RESTRICT ptrs,
+                             const size_t* HWY_RESTRICT byte_lens,
+                             size_t num_inputs,
+                             const uint64_t* HWY_RESTRICT key,
+                             const uint64_t (*HWY_RESTRICT tags)[2],
+                             uint8_t* HWY_RESTRICT ok_bitmap) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  ZeroBytes(ok_bitmap, (num_inputs + 7) / 8);
+
+  SimdHwyHashState init_state;
+  ResetHwyHashState(&init_state, key);
+
+  InterleavedHwyHashStates states;
+  alignas(64) uint64_t hash_words[2][kInterleavedMaxLanes];
+  alignas(64) uint64_t tag_words[2][kInterleavedMaxLanes];
+  ZeroBytes(tag_words, sizeof(tag_words));
+
+  size_t num_passed = 0;
+  for (size_t i = 0; i < num_inputs; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_inputs - i);
+    for (size_t j = 0; j < 4; j++) {
+      Store(Set(d, init_state.v0[j]), d, states.v0[j]);
+      Store(Set(d, init_state.v1[j]), d, states.v1[j]);
+      Store(Set(d, init_state.mul0[j]), d, states.mul0[j]);
+      Store(Set(d, init_state.mul1[j]), d, states.mul1[j]);
+    }
+
+    InterleavedUpdatePackets(d, states, ptrs + i, byte_lens + i, n);
+    InterleavedFinalize128Words(d, states, hash_words);
+
+    for (size_t j = 0; j < n; j++) {
+      tag_words[0][j] = tags[i + j][0];
+      tag_words[1][j] = tags[i + j][1];
+    }
+
+    const auto diff = Or(Xor(Load(d, hash_words[0]), Load(d, tag_words[0])),
+                         Xor(Load(d, hash_words[1]), Load(d, tag_words[1])));
+    const auto passed = And(Eq(diff, Zero(d)), FirstN(d, n));
+    num_passed += CountTrue(d, passed);
+
+    // At most 8 bits are stored, which are placed at bit i of ok_bitmap
+    uint8_t passed_bits[8];
+    StoreMaskBits(d, passed, passed_bits);
+    const unsigned shifted_bits = static_cast<unsigned>(passed_bits[0])
+                                  << (i & 7u);
+    ok_bitmap[i >> 3] |= static_cast<uint8_t>(shifted_bits);
+    if ((i & 7u) + n > 8) {
+      ok_bitmap[(i >> 3) + 1] |= static_cast<uint8_t>(shifted_bits >> 8);
+    }
+  }
+
+  return num_passed;
+}
+
+// Computes the 64-bit hashes of the little-endian encodings of keys[0] through
+// keys[num_keys - 1], Lanes(InterleavedDU64()) keys at a time
+static void HashU64Keys64(const uint64_t* HWY_RESTRICT keys, size_t num_keys,
+                          const uint64_t* HWY_RESTRICT key,
+                          uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+  const auto all_lanes = FirstN(d, lanes_per_u64_vec);
+
+  SimdHwyHashState init_state;
+  ResetHwyHashState(&init_state, key);
+
+  InterleavedHwyHashStates states;
+  alignas(64) uint64_t packet_words[4][kInterleavedMaxLanes];
+  ZeroBytes(packet_words, sizeof(packet_words));
+
+  for (size_t i = 0; i < num_keys; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_keys - i);
+    for (size_t j = 0; j < 4; j++) {
+      Store(Set(d, init_state.v0[j]), d, states.v0[j]);
+      Store(Set(d, init_state.v1[j]), d, states.v1[j]);
+      Store(Set(d, init_state.mul0[j]), d, states.mul0[j]);
+      Store(Set(d, init_state.mul1[j]), d, states.mul1[j]);
+    }
+
+    // An 8-byte input is a single remainder packet whose first word is the
+    // key and whose other words are zero
+    Store(LoadN(d, keys + i, n), d, packet_words[0]);
+    InterleavedAddRemainderLen(d, all_lanes, states, Set(d, uint64_t{8}));
+    InterleavedHwyHashUpdate(d, all_lanes, states, packet_words);
+    InterleavedFinalize64(d, states, n, hashes + i);
+  }
+}
+
+// Number of groups of Lanes(InterleavedDU64()) keys whose states are advanced
+// together by HashMultiKey64, which bounds the states to a few kilobytes that
+// stay in the L1 cache
+static constexpr size_t kMultiKeyMaxGroups = 8;
+
+// Computes the 64-bit hashes of the byte_len bytes at ptr under each of the
+// num_keys keys. Each packet is loaded and broadcast once per block of up to
+// kMultiKeyMaxGroups groups of keys, and then used to update the states of
+// every group in the block before the next packet is loaded.
+static void HashMultiKey64(const uint8_t* HWY_RESTRICT ptr, size_t byte_len,
+                           const uint64_t (*HWY_RESTRICT keys)[4],
+                           size_t num_keys, uint64_t* HWY_RESTRICT hashes) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+  const auto all_lanes = FirstN(d, lanes_per_u64_vec);
+  const size_t max_keys_per_block = lanes_per_u64_vec * kMultiKeyMaxGroups;
+
+  const size_t num_full_packets = byte_len >> 5;
+  const unsigned remainder_len = static_cast<unsigned>(byte_len & 31u);
+
+  uint64_t remainder_words[4] = {0, 0, 0, 0};
+  if (remainder_len != 0) {
+    uint8_t packet_bytes[32];
+    CopyRemainderPacketBytes(ptr + (byte_len & static_cast<size_t>(-32)),
+                             remainder_len, packet_bytes);
+    for (size_t i = 0; i < 4; i++) {
+      remainder_words[i] = LoadPacketWord(packet_bytes + i * sizeof(uint64_t));
+    }
+  }
+
+  InterleavedHwyHashStates states[kMultiKeyMaxGroups];
+  ZeroBytes(states, sizeof(states));
+  alignas(64) uint64_t packet_words[4][kInterleavedMaxLanes];
+
+  for (size_t i = 0; i < num_keys; i += max_keys_per_block) {
+    const size_t num_block_keys = HWY_MIN(max_keys_per_block, num_keys - i);
+    const size_t num_groups =
+        (num_block_keys + lanes_per_u64_vec - 1) / lanes_per_u64_vec;
+
+    for (size_t j = 0; j < num_block_keys; j++) {
+      InterleavedHwyHashStates& group = states[j / lanes_per_u64_vec];
+      const size_t lane = j % lanes_per_u64_vec;
+      SimdHwyHashState state;
+      ResetHwyHashState(&state, keys[i + j]);
+      for (size_t w = 0; w < 4; w++) {
+        group.v0[w][lane] = state.v0[w];
+        group.v1[w][lane] = state.v1[w];
+        group.mul0[w][lane] = state.mul0[w];
+        group.mul1[w][lane] = state.mul1[w];
+      }
+    }
+
+    // Every lane of every group is updated with the same packet
+    for (size_t k = 0; k < num_full_packets; k++) {
+      const uint8_t* packet = ptr + k * 32;
+      for (size_t w = 0; w < 4; w++) {
+        Store(Set(d, LoadPacketWord(packet + w * sizeof(uint64_t))), d,
+              packet_words[w]);
+      }
+      for (size_t g = 0; g < num_groups; g++) {
+        InterleavedHwyHashUpdate(d, all_lanes, states[g], packet_words);
+      }
+    }
+
+    if (remainder_len != 0) {
+      for (size_t w = 0; w < 4; w++) {
+        Store(Set(d, remainder_words[w]), d, packet_words[w]);
+      }
+      const auto remainder_len_vec =
+          Set(d, static_cast<uint64_t>(remainder_len));
+      for (size_t g = 0; g < num_groups; g++) {
+        InterleavedAddRemainderLen(d, all_lanes, states[g], remainder_len_vec);
+        InterleavedHwyHashUpdate(d, all_lanes, states[g], packet_words);
+      }
+    }
+
+    for (size_t g = 0; g < num_groups; g++) {
+      const size_t group_begin = g * lanes_per_u64_vec;
+      InterleavedFinalize64(
+          d, states[g],
+          HWY_MIN(lanes_per_u64_vec, num_block_keys - group_begin),
+          hashes + i + group_begin);
+    }
+  }
+}
+
+// Records of at least this many bytes are hashed one at a time by
+// HashRecords64, so that a long record does not hold up the lanes of the short
+// records that are hashed side by side
+static constexpr size_t kMaxInterleavedRecordLen = 256;
+
+// Bit i of each of the masks is set if byte i of a block of 64 bytes is the
+// delimiter, a newline, or a double quote
+struct RecordBlockBits {
+  uint64_t delimiter;
+  uint64_t newline;
+  uint64_t quote;
+};
+
+static HWY_INLINE uint64_t MaskBytesToU64(const uint8_t* HWY_RESTRICT bytes) {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < 8; i++) {
+    bits |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+  }
+  return bits;
+}
+
+// Finds the delimiters of the 64 bytes at block, and also the newlines and
+// double quotes if csv is true
+static HWY_INLINE void FindRecordBlockBits(const uint8_t* HWY_RESTRICT block,
+                                           uint8_t delimiter, bool csv,
+                                           RecordBlockBits& bits) {
+#if HWY_TARGET == HWY_SCALAR
+  bits.delimiter = 0;
+  bits.newline = 0;
+  bits.quote = 0;
+  for (size_t i = 0; i < 64; i++) {
+    bits.delimiter |= static_cast<uint64_t>(block[i] == delimiter) << i;
+    if (csv) {
+      bits.newline |= static_cast<uint64_t>(block[i] == '\n') << i;
+      bits.quote |= static_cast<uint64_t>(block[i] == '"') << i;
+    }
+  }
+#else
+  // Every vector has a multiple of 8 lanes, so the mask bits of each vector
+  // start at a byte boundary
+  const CappedTag<uint8_t, 64> du8;
+  const size_t lanes_per_u8_vec = Lanes(du8);
+
+  uint8_t delimiter_bytes[8];
+  uint8_t newline_bytes[8];
+  uint8_t quote_bytes[8];
+  for (size_t i = 0; i < 64; i += lanes_per_u8_vec) {
+    const auto v = LoadU(du8, block + i);
+    StoreMaskBits(du8, Eq(v, Set(du8, delimiter)), delimiter_bytes + i / 8);
+    if (csv) {
+      StoreMaskBits(du8, Eq(v, Set(du8, uint8_t{'\n'})), newline_bytes + i / 8);
+      StoreMaskBits(du8, Eq(v, Set(du8, uint8_t{'"'})), quote_bytes + i / 8);
+    }
+  }
+
+  bits.delimiter = MaskBytesToU64(delimiter_bytes);
+  bits.newline = csv ? MaskBytesToU64(newline_bytes) : 0;
+  bits.quote = csv ? MaskBytesToU64(quote_bytes) : 0;
+#endif
+}
+
+// Returns the mask whose bit i is the parity of the bits of quote_bits at or
+// below bit i, which is set for the bytes that are between an opening double
+// quote and its closing double quote
+static HWY_INLINE uint64_t PrefixXor64(uint64_t quote_bits) {
+  quote_bits ^= quote_bits << 1;
+  quote_bits ^= quote_bits << 2;
+  quote_bits ^= quote_bits << 4;
+  quote_bits ^= quote_bits << 8;
+  quote_bits ^= quote_bits << 16;
+  quote_bits ^= quote_bits << 32;
+  return quote_bits;
+}
+
+// Short records that have been found by HashRecords64 and are waiting to be
+// hashed Lanes(InterleavedDU64()) at a time
+struct RecordHashBatch {
+  const void* ptrs[kInterleavedMaxLanes];
+  size_t byte_lens[kInterleavedMaxLanes];
+  size_t record_indices[kInterleavedMaxLanes];
+  size_t num_records;
+};
+
+static HWY_INLINE void HashRecordBatch(InterleavedDU64 d,
+                                       const SimdHwyHashState& init_state,
+                                       RecordHashBatch& batch,
+                                       uint64_t* HWY_RESTRICT hashes) {
+  InterleavedHwyHashStates states;
+  for (size_t j = 0; j < 4; j++) {
+    Store(Set(d, init_state.v0[j]), d, states.v0[j]);
+    Store(Set(d, init_state.v1[j]), d, states.v1[j]);
+    Store(Set(d, init_state.mul0[j]), d, states.mul0[j]);
+    Store(Set(d, init_state.mul1[j]), d, states.mul1[j]);
+  }
+
+  alignas(64) uint64_t batch_hashes[kInterleavedMaxLanes];
+  InterleavedUpdatePackets(d, states, batch.ptrs, batch.byte_lens,
+                           batch.num_records);
+  InterleavedFinalize64(d, states, batch.num_records, batch_hashes);
+  for (size_t j = 0; j < batch.num_records; j++) {
+    hashes[batch.record_indices[j]] = batch_hashes[j];
+  }
+  batch.num_records = 0;
+}
+
+// Computes the 64-bit hash of the record at buf[begin] to buf[end - 1], which
+// is record record_idx, or adds it to batch if it is short
+static HWY_INLINE void HashRecord(InterleavedDU64 d,
+                                  const SimdHwyHashState& init_state,
+                                  const uint8_t* HWY_RESTRICT buf, size_t begin,
+                                  size_t end, size_t record_idx,
+                                  RecordHashBatch& batch,
+                                  uint64_t* HWY_RESTRICT hashes,
+                                  size_t (*HWY_RESTRICT offsets)[2]) {
+  if (offsets) {
+    offsets[record_idx][0] = begin;
+    offsets[record_idx][1] = end;
+  }
+
+  const size_t record_len = end - begin;
+  if (record_len >= kMaxInterleavedRecordLen) {
+    SimdHwyHashState state = init_state;
+    UpdateHwyHashState(&state, buf + begin, record_len);
+    hashes[record_idx] = Finalize64(&state);
+    return;
+  }
+
+  batch.ptrs[batch.num_records] = buf + begin;
+  batch.byte_lens[batch.num_records] = record_len;
+  batch.record_indices[batch.num_records] = record_idx;
+  if (++batch.num_records == Lanes(d)) {
+    HashRecordBatch(d, init_state, batch, hashes);
+  }
+}
+
+// Splits the byte_len bytes at buf into records that end at each delimiter,
+// and computes the 64-bit hashes of up to max_records of them under key. In
+// CSV mode, a record is a field that ends at a delimiter or a newline that is
+// not between double quotes. The delimiters are found 64 bytes at a time with
+// vector compares, and each record is hashed as soon as it has been found,
+// while its bytes are still in the cache. Returns the number of records.
+static size_t HashRecords64(const uint8_t* HWY_RESTRICT buf, size_t byte_len,
+                            uint8_t delimiter, bool csv,
+                            const uint64_t* HWY_RESTRICT key,
+                            uint64_t* HWY_RESTRICT hashes,
+                            size_t (*HWY_RESTRICT offsets)[2],
+                            size_t max_records) {
+  const InterleavedDU64 d;
+
+  SimdHwyHashState init_state;
+  ResetHwyHashState(&init_state, key);
+
+  RecordHashBatch batch;
+  batch.num_records = 0;
+
+  size_t num_records = 0;
+  size_t record_begin = 0;
+  // All ones if the previous block ended between double quotes
+  uint64_t quoted_carry = 0;
+
+  for (size_t block_begin = 0;
+       block_begin < byte_len && num_records < max_records;
+       block_begin += 64) {
+    const size_t block_len = HWY_MIN(size_t{64}, byte_len - block_begin);
+
+    RecordBlockBits bits;
+    if (block_len == 64) {
+      FindRecordBlockBits(buf + block_begin, delimiter, csv, bits);
+    } else {
+      // The last partial block is copied so that it can be loaded as a whole
+      // block, and the bits past its end are cleared
+      alignas(64) uint8_t last_block[64];
+      ZeroBytes(last_block, sizeof(last_block));
+      CopyBytes(buf + block_begin, last_block, block_len);
+      FindRecordBlockBits(last_block, delimiter, csv, bits);
+
+      const uint64_t valid_bits = (uint64_t{1} << block_len) - 1;
+      bits.delimiter &= valid_bits;
+      bits.newline &= valid_bits;
+      bits.quote &= valid_bits;
+    }
+
+    uint64_t end_bits = bits.delimiter;
+    if (csv) {
+      const uint64_t quoted_bits = PrefixXor64(bits.quote) ^ quoted_carry;
+      quoted_carry = 0 - (quoted_bits >> 63);
+      end_bits = (end_bits | bits.newline) & ~quoted_bits;
+    }
+
+    for (; end_bits != 0 && num_records < max_records;
+         end_bits &= end_bits - 1) {
+      const size_t record_end =
+          block_begin + hwy::Num0BitsBelowLS1Bit_Nonzero64(end_bits);
+      HashRecord(d, init_state, buf, record_begin, record_end, num_records,
+                 batch, hashes, offsets);
+      num_records++;
+      record_begin = record_end + 1;
+    }
+  }
+
+  // The bytes after the last delimiter are a record unless they are empty
+  if (record_begin < byte_len && num_records < max_records) {
+    HashRecord(d, init_state, buf, record_begin, byte_len, num_records, batch,
+               hashes, offsets);
+    num_records++;
+  }
+
+  if (batch.num_records != 0) {
+    HashRecordBatch(d, init_state, batch, hashes);
+  }
+  return num_records;
+}
+
+// Stores bytes offset to offset + byte_len - 1 of the output of FinalizeXof,
+// with each word encoded in little-endian byte order, for the state that has
+// been reset with key and updated with the little-endian encoding of nonce.
+// The state is finalized once in every lane, and the blocks of 4 words are
+// then computed Lanes(InterleavedDU64()) at a time, each from a copy of the
+// finalized state and its own counter, so that any block can be computed
+// without computing the blocks before it.
+static void RandomFill(const uint64_t* HWY_RESTRICT key, uint64_t nonce,
+                       uint64_t offset, uint8_t* HWY_RESTRICT out,
+                       size_t byte_len) {
+  const InterleavedDU64 d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+  const auto all_lanes = FirstN(d, lanes_per_u64_vec);
+
+  uint8_t nonce_bytes[8];
+  for (size_t i = 0; i < 8; i++) {
+    nonce_bytes[i] = static_cast<uint8_t>(nonce >> (i * 8));
+  }
+
+  SimdHwyHashState state;
+  ResetHwyHashState(&state, key);
+  UpdateHwyHashState(&state, nonce_bytes, sizeof(nonce_bytes));
+
+  InterleavedHwyHashStates finalized_states;
+  for (size_t j = 0; j < 4; j++) {
+    Store(Set(d, state.v0[j]), d, finalized_states.v0[j]);
+    Store(Set(d, state.v1[j]), d, finalized_states.v1[j]);
+    Store(Set(d, state.mul0[j]), d, finalized_states.mul0[j]);
+    Store(Set(d, state.mul1[j]), d, finalized_states.mul1[j]);
+  }
+  for (size_t i = 0; i < 10; i++) {
+    InterleavedPermuteAndUpdate(d, finalized_states);
+  }
+
+  alignas(64) uint64_t packet_words[4][kInterleavedMaxLanes];
+  Store(Set(d, kXofDomainAndVersion), d, packet_words[1]);
+  Store(Set(d, kXofDomainAndVersion), d, packet_words[3]);
+
+  // Lane j of block_words[i] holds word i of block first_block + j
+  alignas(64) uint64_t block_words[4][kInterleavedMaxLanes];
+  uint64_t first_block = offset / 32;
+  size_t skip_bytes = static_cast<size_t>(offset % 32);
+  while (byte_len != 0) {
+    InterleavedHwyHashStates states = finalized_states;
+    const auto v_blocks = Add(Set(d, first_block), Iota(d, 0));
+    Store(v_blocks, d, packet_words[0]);
+    Store(v_blocks, d, packet_words[2]);
+
+    InterleavedHwyHashUpdate(d, all_lanes, states, packet_words);
+    InterleavedPermuteAndUpdate(d, states);
+    InterleavedPermuteAndUpdate(d, states);
+    InterleavedPermuteAndUpdate(d, states);
+    InterleavedPermuteAndUpdate(d, states);
+    InterleavedModularReduction(d, states, block_words);
+
+#if HWY_IS_BIG_ENDIAN
+    for (size_t i = 0; i < 4; i++) {
+      Store(ReverseLaneBytes(Load(d, block_words[i])), d, block_words[i]);
+    }
+#endif
+
+    for (size_t j = 0; j < lanes_per_u64_vec && byte_len != 0; j++) {
+      if (skip_bytes == 0 && byte_len >= 32) {
+        for (size_t i = 0; i < 4; i++) {
+          CopyBytes(&block_words[i][j], out + i * 8, 8);
+        }
+        out += 32;
+        byte_len -= 32;
+        continue;
+      }
+
+      // The first and last blocks may only be partly stored
+      uint8_t block_bytes[32];
+      for (size_t i = 0; i < 4; i++) {
+        CopyBytes(&block_words[i][j], block_bytes + i * 8, 8);
+      }
+      const size_t n = HWY_MIN(size_t{32} - skip_bytes, byte_len);
+      CopyBytes(block_bytes + skip_bytes, out, n);
+      out += n;
+      byte_len -= n;
+      skip_bytes = 0;
+    }
+
+    first_block += lanes_per_u64_vec;
+  }
+}
+
+}  // namespace
+}  // namespace HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace {
+#if defined(SIMDHWYHASH_HEADER_ONLY)
+// The kernels of the static target are called directly, which allows them to
+// be inlined into the callers of the entry points
+#define SIMDHWYHASH_DISPATCH(FUNC) HWY_STATIC_DISPATCH(FUNC)
+#define SIMDHWYHASH_DISPATCH_POINTER(FUNC) (&HWY_STATIC_DISPATCH(FUNC))
+#else
+#define SIMDHWYHASH_DISPATCH(FUNC) HWY_DYNAMIC_DISPATCH(FUNC)
+#define SIMDHWYHASH_DISPATCH_POINTER(FUNC) HWY_DYNAMIC_POINTER(FUNC)
+
+HWY_EXPORT(ResetHwyHashState);
+HWY_EXPORT(UpdateHwyHashState);
+HWY_EXPORT(UpdateHwyHashStatePadded);
+HWY_EXPORT(CopyAndUpdateHwyHashState);
+HWY_EXPORT(Finalize64);
+HWY_EXPORT(Finalize128);
+HWY_EXPORT(Finalize256);
+HWY_EXPORT(FinalizeXof);
+HWY_EXPORT(Hash64OneShot);
+HWY_EXPORT(Hash128OneShot);
+HWY_EXPORT(Hash256OneShot);
+HWY_EXPORT(UpdateHwyHashStatePool);
+HWY_EXPORT(FinalizeHwyHashStatePool64);
+HWY_EXPORT(FinalizeHwyHashStatePool128);
+HWY_EXPORT(FinalizeHwyHashStatePool256);
+HWY_EXPORT(Hash64Batch);
+HWY_EXPORT(Hash128Batch);
+HWY_EXPORT(HashU64Keys64);
+HWY_EXPORT(VerifyBatch128);
+HWY_EXPORT(HashMultiKey64);
+HWY_EXPORT(HashRecords64);
+HWY_EXPORT(RandomFill);
+#endif  // defined(SIMDHWYHASH_HEADER_ONLY)
+
+// Exported state blob layout, with all integers stored in little-endian order:
+//   bytes 0-3: kExportedStateMagic
+//   byte 4: kExportedStateVersion
+//   byte 5: number of buffered tail bytes (0 to 31)
+//   bytes 6-7: reserved, must be zero
+//   bytes 8-15: number of bytes absorbed into the state
+//   bytes 16-143: v0, v1, mul0, and mul1
+//   bytes 144 to 144 + tail_len - 1: buffered tail bytes
+//   last 8 bytes: SimdHwyHash_Hash64 of the preceding bytes, keyed with
+//   kExportedStateChecksumKey
+static constexpr uint8_t kExportedStateMagic[4] = {'S', 'H', 'H', 'S'};
+static constexpr uint8_t kExportedStateVersion = 1;
+static constexpr size_t kExportedStateHeaderSize = 16;
+static constexpr size_t kExportedStateWordsSize = 16 * sizeof(uint64_t);
+static constexpr size_t kExportedStateMinSize =
+    kExportedStateHeaderSize + kExportedStateWordsSize + sizeof(uint64_t);
+static constexpr uint64_t kExportedStateChecksumKey[4] = {
+    0x5348485300000001u, 0x243F6A8885A308D3u, 0x13198A2E03707344u,
+    0xA4093822299F31D0u};
+
+static_assert(kExportedStateMinSize + 31 ==
+                  SIMDHWYHASH_EXPORTED_STATE_MAX_SIZE,
+              "SIMDHWYHASH_EXPORTED_STATE_MAX_SIZE is out of sync with the "
+              "exported state layout");
+
+static inline void StoreLE64(uint8_t* HWY_RESTRICT ptr, uint64_t val) {
+  for (size_t i = 0; i < 8; i++) {
+    ptr[i] = static_cast<uint8_t>(val >> (i * 8));
+  }
+}
+
+static inline uint64_t LoadLE64(const uint8_t* HWY_RESTRICT ptr) {
+  uint64_t val = 0;
+  for (size_t i = 0; i < 8; i++) {
+    val |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+  }
+  return val;
+}
+
+// The one-shot hash functions are tuned for inputs of up to 16 bytes, and for
+// each power of 2 from 32 to 4096 bytes, with longer inputs in the last class
+static constexpr size_t kNumAutotuneLengthClasses = 10;
+static constexpr size_t kAutotuneMaxBenchLen = 16384;
+static constexpr int kAutotuneNumTrials = 5;
+static constexpr int kAutotuneCacheVersion = 1;
+
+static inline size_t AutotuneLengthClass(size_t byte_len) {
+  if (byte_len <= 16) {
+    return 0;
+  }
+  const size_t ceil_log2_len =
+      64 - hwy::Num0BitsAboveMS1Bit_Nonzero64(
+               static_cast<uint64_t>(byte_len - 1));
+  return HWY_MIN(ceil_log2_len - 4, kNumAutotuneLengthClasses - 1);
+}
+
+static inline size_t AutotuneBenchLen(size_t length_class) {
+  return (length_class + 1 < kNumAutotuneLengthClasses)
+             ? (size_t{16} << length_class)
+             : kAutotuneMaxBenchLen;
+}
+
+#if defined(SIMDHWYHASH_HEADER_ONLY)
+// There is only one compiled target to choose from in the header-only build,
+// so the one-shot hash functions always call the kernels of the static target
+static HWY_INLINE const AutotunedKernels* GetAutotunedKernels(size_t) {
+  return nullptr;
+}
+#else
+
+static std::mutex g_autotune_mutex;
+
+static std::atomic<bool> g_autotune_active{false};
+static std::atomic<const AutotunedKernels*>
+    g_autotuned_kernels[kNumAutotuneLengthClasses];
+
+// Returns the kernels of the one-shot hash functions for inputs of byte_len
+// bytes, or nullptr if the default dynamic dispatch should be used
+static HWY_INLINE const AutotunedKernels* GetAutotunedKernels(
+    size_t byte_len) {
+  if (!g_autotune_active.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return g_autotuned_kernels[AutotuneLengthClass(byte_len)].load(
+      std::memory_order_acquire);
+}
+
+// Returns the targets that the kernels can be run on, which are the compiled
+// targets that the CPU supports
+static int64_t AutotuneCandidateTargets() {
+  return hwy::SupportedTargets() & HWY_TARGETS;
+}
+
+// Returns the kernels of target, or nullptr if target was not compiled. The
+// entries of g_target_kernels are never changed after static initialization,
+// so the one-shot hash functions can keep using the kernels while
+// SimdHwyHash_Autotune runs again.
+static const AutotunedKernels* GetTargetKernels(int64_t target) {
+  const AutotunedKernels& kernels = g_target_kernels[
+      hwy::Num0BitsBelowLS1Bit_Nonzero64(static_cast<uint64_t>(target))];
+  return (kernels.target == target) ? &kernels : nullptr;
+}
+
+// Returns the number of nanoseconds that it takes kernels to compute the 64-bit
+// hashes of num_iters inputs of byte_len bytes
+static uint64_t MeasureAutotunedKernels(const AutotunedKernels& kernels,
+                                        const uint8_t* HWY_RESTRICT data,
+                                        size_t byte_len, size_t num_iters) {
+  // Each hash is fed into the key of the next, so that the calls cannot be
+  // overlapped or skipped
+  uint64_t key[4] = {0x0706050403020100u, 0x0F0E0D0C0B0A0908u,
+                     0x1716151413121110u, 0x1F1E1D1C1B1A1918u};
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_iters; i++) {
+    key[0] ^= kernels.hash64(data, byte_len, key, false);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  hwy::PreventElision(key[0]);
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+// Stores the fastest of candidate_targets for each length class in
+// best_targets. Returns false if memory could not be allocated or if none of
+// candidate_targets has registered its kernels.
+static bool MeasureAutotuneTargets(int64_t candidate_targets,
+                                   int64_t* HWY_RESTRICT best_targets) {
+  const AutotunedKernels* candidates[64];
+  size_t num_candidates = 0;
+  for (uint64_t remaining = static_cast<uint64_t>(candidate_targets);
+       remaining != 0; remaining &= remaining - 1) {
+    const AutotunedKernels* kernels =
+        GetTargetKernels(static_cast<int64_t>(remaining & (~remaining + 1)));
+    if (kernels) {
+      candidates[num_candidates++] = kernels;
+    }
+  }
+  if (num_candidates == 0) {
+    return false;
+  }
+
+  uint8_t* data = static_cast<uint8_t*>(malloc(kAutotuneMaxBenchLen));
+  if (!data) {
+    return false;
+  }
+  for (size_t i = 0; i < kAutotuneMaxBenchLen; i++) {
+    data[i] = static_cast<uint8_t>((i * 131) ^ (i >> 8));
+  }
+
+  for (size_t c = 0; c < kNumAutotuneLengthClasses; c++) {
+    const size_t byte_len = AutotuneBenchLen(c);
+    const size_t num_iters = HWY_MAX(size_t{16}, 262144 / (byte_len + 64));
+
+    // Every candidate is run once before it is timed, which lets the CPU
+    // finish any frequency or power state changes, and the trials of the
+    // candidates are interleaved so that all of them see the same conditions
+    uint64_t best_nanos[64];
+    for (size_t t = 0; t < num_candidates; t++) {
+      MeasureAutotunedKernels(*candidates[t], data, byte_len, num_iters);
+      best_nanos[t] = ~uint64_t{0};
+    }
+    for (int trial = 0; trial < kAutotuneNumTrials; trial++) {
+      for (size_t t = 0; t < num_candidates; t++) {
+        best_nanos[t] = HWY_MIN(best_nanos[t],
+                                MeasureAutotunedKernels(*candidates[t], data,
+                                                        byte_len, num_iters));
+      }
+    }
+
+    size_t best = 0;
+    for (size_t t = 1; t < num_candidates; t++) {
+      if (best_nanos[t] < best_nanos[best]) {
+        best = t;
+      }
+    }
+    best_targets[c] = candidates[best]->target;
+  }
+
+  free(data);
+  return true;
+}
+
+// Reads the targets that were written by WriteAutotuneCache to the file at
+// cache_path. Returns false if the file does not exist, is not valid, or was
+// written for different candidate targets.
+static bool ReadAutotuneCache(const char* cache_path, int64_t candidate_targets,
+                              int64_t* HWY_RESTRICT best_targets) {
+  FILE* file = fopen(cache_path, "r");
+  if (!file) {
+    return false;
+  }
+
+  int version = 0;
+  unsigned long long cached_candidates = 0;
+  bool valid = fscanf(file, "simdhwyhash-autotune %d %llx", &version,
+                      &cached_candidates) == 2 &&
+               version == kAutotuneCacheVersion &&
+               cached_candidates ==
+                   static_cast<unsigned long long>(candidate_targets);
+  for (size_t c = 0; valid && c < kNumAutotuneLengthClasses; c++) {
+    unsigned long long target = 0;
+    valid = fscanf(file, "%llx", &target) == 1 && target != 0 &&
+            (target & (target - 1)) == 0 &&
+            (target & cached_candidates) != 0;
+    best_targets[c] = static_cast<int64_t>(target);
+  }
+  fclose(file);
+  return valid;
+}
+
+// Writes best_targets to the file at cache_path, on a single line of text
+static void WriteAutotuneCache(const char* cache_path,
+                               int64_t candidate_targets,
+                               const int64_t* HWY_RESTRICT best_targets) {
+  FILE* file = fopen(cache_path, "w");
+  if (!file) {
+    return;
+  }
+
+  fprintf(file, "simdhwyhash-autotune %d %llx", kAutotuneCacheVersion,
+          static_cast<unsigned long long>(candidate_targets));
+  for (size_t c = 0; c < kNumAutotuneLengthClasses; c++) {
+    fprintf(file, " %llx", static_cast<unsigned long long>(best_targets[c]));
+  }
+  fprintf(file, "\n");
+  fclose(file);
+}
+#endif  // defined(SIMDHWYHASH_HEADER_ONLY)
+}  // namespace
+#endif  // HWY_ONCE
+
+}  // namespace simdhwyhash
+
+#if HWY_ONCE
+extern "C" {
+
+void SimdHwyHash_Reset(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                       const uint64_t* SIMDHWYHASH_RESTRICT key) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(ResetHwyHashState)(state, key);
+}
+
+void SimdHwyHash_Update(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                        const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(UpdateHwyHashState)
+  (state, reinterpret_cast<const uint8_t*>(ptr), byte_len);
+}
+
+uint64_t SimdHwyHash_Finalize64(SimdHwyHashState* SIMDHWYHASH_RESTRICT state) {
+  using namespace simdhwyhash;
+  return SIMDHWYHASH_DISPATCH(Finalize64)(state);
+}
+
+void SimdHwyHash_Finalize128(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                             uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  return SIMDHWYHASH_DISPATCH(Finalize128)(state, hash);
+}
+
+void SimdHwyHash_Finalize256(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                             uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  return SIMDHWYHASH_DISPATCH(Finalize256)(state, hash);
+}
+
+void SimdHwyHash_FinalizeXof(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                             uint64_t* SIMDHWYHASH_RESTRICT out,
+                             size_t num_words) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(FinalizeXof)(state, out, num_words);
+}
+
+uint64_t SimdHwyHash_Hash64(const void* SIMDHWYHASH_RESTRICT ptr,
+                            size_t byte_len,
+                            const uint64_t* SIMDHWYHASH_RESTRICT key) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    return kernels->hash64(bytes, byte_len, key, false);
+  }
+  return SIMDHWYHASH_DISPATCH(Hash64OneShot)(bytes, byte_len, key, false);
+}
+
+void SimdHwyHash_Hash128(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+                         const uint64_t* SIMDHWYHASH_RESTRICT key,
+                         uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    kernels->hash128(bytes, byte_len, key, false, hash);
+    return;
+  }
+  SIMDHWYHASH_DISPATCH(Hash128OneShot)(bytes, byte_len, key, false, hash);
+}
+
+void SimdHwyHash_Hash256(const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+                         const uint64_t* SIMDHWYHASH_RESTRICT key,
+                         uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    kernels->hash256(bytes, byte_len, key, false, hash);
+    return;
+  }
+  SIMDHWYHASH_DISPATCH(Hash256OneShot)(bytes, byte_len, key, false, hash);
+}
+
+uint64_t SimdHwyHash_Hash64Padded(const void* SIMDHWYHASH_RESTRICT ptr,
+                                  size_t byte_len,
+                                  const uint64_t* SIMDHWYHASH_RESTRICT key) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    return kernels->hash64(bytes, byte_len, key, true);
+  }
+  return SIMDHWYHASH_DISPATCH(Hash64OneShot)(bytes, byte_len, key, true);
+}
+
+void SimdHwyHash_Hash128Padded(const void* SIMDHWYHASH_RESTRICT ptr,
+                               size_t byte_len,
+                               const uint64_t* SIMDHWYHASH_RESTRICT key,
+                               uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    kernels->hash128(bytes, byte_len, key, true, hash);
+    return;
+  }
+  SIMDHWYHASH_DISPATCH(Hash128OneShot)(bytes, byte_len, key, true, hash);
+}
+
+void SimdHwyHash_Hash256Padded(const void* SIMDHWYHASH_RESTRICT ptr,
+                               size_t byte_len,
+                               const uint64_t* SIMDHWYHASH_RESTRICT key,
+                               uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  using namespace simdhwyhash;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  if (kernels) {
+    kernels->hash256(bytes, byte_len, key, true, hash);
+    return;
+  }
+  SIMDHWYHASH_DISPATCH(Hash256OneShot)(bytes, byte_len, key, true, hash);
+}
+
+void SimdHwyHash_CopyAndUpdate(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                               void* SIMDHWYHASH_RESTRICT dst,
+                               const void* SIMDHWYHASH_RESTRICT src,
+                               size_t byte_len, unsigned flags) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(CopyAndUpdateHwyHashState)
+  (state, reinterpret_cast<uint8_t*>(dst),
+   reinterpret_cast<const uint8_t*>(src), byte_len,
+   (flags & SIMDHWYHASH_COPY_NON_TEMPORAL) != 0);
+}
+
+uint64_t SimdHwyHash_CopyAndHash64(void* SIMDHWYHASH_RESTRICT dst,
+                                   const void* SIMDHWYHASH_RESTRICT src,
+                                   size_t byte_len,
+                                   const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                   unsigned flags) {
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, key);
+  SimdHwyHash_CopyAndUpdate(&state, dst, src, byte_len, flags);
+  return SimdHwyHash_Finalize64(&state);
+}
+
+void SimdHwyHash_CopyAndHash128(void* SIMDHWYHASH_RESTRICT dst,
+                                const void* SIMDHWYHASH_RESTRICT src,
+                                size_t byte_len,
+                                const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                unsigned flags,
+                                uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, key);
+  SimdHwyHash_CopyAndUpdate(&state, dst, src, byte_len, flags);
+  SimdHwyHash_Finalize128(&state, hash);
+}
+
+void SimdHwyHash_CopyAndHash256(void* SIMDHWYHASH_RESTRICT dst,
+                                const void* SIMDHWYHASH_RESTRICT src,
+                                size_t byte_len,
+                                const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                unsigned flags,
+                                uint64_t* SIMDHWYHASH_RESTRICT hash) {
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, key);
+  SimdHwyHash_CopyAndUpdate(&state, dst, src, byte_len, flags);
+  SimdHwyHash_Finalize256(&state, hash);
+}
+
+#if defined(SIMDHWYHASH_HEADER_ONLY)
+int SimdHwyHash_Autotune(const char*) { return 0; }
+
+void SimdHwyHash_AutotuneReset(void) {}
+
+int64_t SimdHwyHash_AutotunedTarget(size_t) { return 0; }
+#else
+int SimdHwyHash_Autotune(const char* cache_path) {
+  using namespace simdhwyhash;
+
+  std::lock_guard<std::mutex> lock(g_autotune_mutex);
+
+  const int64_t candidate_targets = AutotuneCandidateTargets();
+  int64_t best_targets[kNumAutotuneLengthClasses];
+  int result = 2;
+  if (!cache_path ||
+      !ReadAutotuneCache(cache_path, candidate_targets, best_targets)) {
+    if (!MeasureAutotuneTargets(candidate_targets, best_targets)) {
+      return 0;
+    }
+    if (cache_path) {
+      WriteAutotuneCache(cache_path, candidate_targets, best_targets);
+    }
+    result = 1;
+  }
+
+  for (size_t c = 0; c < kNumAutotuneLengthClasses; c++) {
+    g_autotuned_kernels[c].store(GetTargetKernels(best_targets[c]),
+                                 std::memory_order_release);
+  }
+  g_autotune_active.store(true, std::memory_order_relaxed);
+  return result;
+}
+
+void SimdHwyHash_AutotuneReset(void) {
+  using namespace simdhwyhash;
+
+  std::lock_guard<std::mutex> lock(g_autotune_mutex);
+  g_autotune_active.store(false, std::memory_order_relaxed);
+  for (size_t c = 0; c < kNumAutotuneLengthClasses; c++) {
+    g_autotuned_kernels[c].store(nullptr, std::memory_order_release);
+  }
+}
+
+int64_t SimdHwyHash_AutotunedTarget(size_t byte_len) {
+  using namespace simdhwyhash;
+  const AutotunedKernels* kernels = GetAutotunedKernels(byte_len);
+  return kernels ? kernels->target : 0;
+}
+#endif  // defined(SIMDHWYHASH_HEADER_ONLY)
+
+size_t SimdHwyHash_ExportState(
+    const SimdHwyHashState* SIMDHWYHASH_RESTRICT state, uint64_t processed_len,
+    const void* SIMDHWYHASH_RESTRICT tail, size_t tail_len,
+    void* SIMDHWYHASH_RESTRICT blob, size_t blob_capacity) {
+  using namespace simdhwyhash;
+
+  // The state can only have absorbed whole packets before the final update
+  if ((processed_len & 31u) != 0 || tail_len > 31) {
+    return 0;
+  }
+
+  const size_t blob_len = kExportedStateMinSize + tail_len;
+  if (blob_capacity < blob_len) {
+    return 0;
+  }
+
+  uint8_t* out = reinterpret_cast<uint8_t*>(blob);
+  memcpy(out, kExportedStateMagic, sizeof(kExportedStateMagic));
+  out[4] = kExportedStateVersion;
+  out[5] = static_cast<uint8_t>(tail_len);
+  out[6] = 0;
+  out[7] = 0;
+  StoreLE64(out + 8, processed_len);
+
+  uint8_t* words_out = out + kExportedStateHeaderSize;
+  for (size_t i = 0; i < 4; i++) {
+    StoreLE64(words_out + i * 8, state->v0[i]);
+    StoreLE64(words_out + 32 + i * 8, state->v1[i]);
+    StoreLE64(words_out + 64 + i * 8, state->mul0[i]);
+    StoreLE64(words_out + 96 + i * 8, state->mul1[i]);
+  }
+
+  const size_t checksum_offset = blob_len - sizeof(uint64_t);
+  if (tail_len != 0) {
+    memcpy(words_out + kExportedStateWordsSize, tail, tail_len);
+  }
+  StoreLE64(out + checksum_offset,
+            SimdHwyHash_Hash64(out, checksum_offset, kExportedStateChecksumKey));
+  return blob_len;
+}
+
+size_t SimdHwyHash_ImportState(SimdHwyHashState* SIMDHWYHASH_RESTRICT state,
+                               uint64_t* SIMDHWYHASH_RESTRICT processed_len,
+                               void* SIMDHWYHASH_RESTRICT tail,
+                               size_t* SIMDHWYHASH_RESTRICT tail_len,
+                               const void* SIMDHWYHASH_RESTRICT blob,
+                               size_t blob_len) {
+  using namespace simdhwyhash;
+
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(blob);
+  if (blob_len < kExportedStateMinSize ||
+      memcmp(in, kExportedStateMagic, sizeof(kExportedStateMagic)) != 0 ||
+      in[4] != kExportedStateVersion || in[5] > 31 || in[6] != 0 ||
+      in[7] != 0) {
+    return 0;
+  }
+
+  const size_t stored_tail_len = in[5];
+  const size_t stored_blob_len = kExportedStateMinSize + stored_tail_len;
+  if (blob_len < stored_blob_len) {
+    return 0;
+  }
+
+  const size_t checksum_offset = stored_blob_len - sizeof(uint64_t);
+  if (LoadLE64(in + checksum_offset) !=
+      SimdHwyHash_Hash64(in, checksum_offset, kExportedStateChecksumKey)) {
+    return 0;
+  }
+
+  const uint64_t stored_processed_len = LoadLE64(in + 8);
+  if ((stored_processed_len & 31u) != 0) {
+    return 0;
+  }
+
+  const uint8_t* words_in = in + kExportedStateHeaderSize;
+  for (size_t i = 0; i < 4; i++) {
+    state->v0[i] = LoadLE64(words_in + i * 8);
+    state->v1[i] = LoadLE64(words_in + 32 + i * 8);
+    state->mul0[i] = LoadLE64(words_in + 64 + i * 8);
+    state->mul1[i] = LoadLE64(words_in + 96 + i * 8);
+  }
+
+  *processed_len = stored_processed_len;
+  *tail_len = stored_tail_len;
+  if (stored_tail_len != 0) {
+    memcpy(tail, words_in + kExportedStateWordsSize, stored_tail_len);
+  }
+  return stored_blob_len;
+}
+
+int SimdHwyHash_StatePoolInit(SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+                              size_t capacity) {
+  pool->words = nullptr;
+  pool->capacity = 0;
+
+  if (capacity == 0 || capacity > SIZE_MAX / (16 * sizeof(uint64_t))) {
+    return 0;
+  }
+
+  uint64_t* words =
+      static_cast<uint64_t*>(calloc(capacity * 16, sizeof(uint64_t)));
+  if (!words) {
+    return 0;
+  }
+
+  pool->words = words;
+  pool->capacity = capacity;
+  return 1;
+}
+
+void SimdHwyHash_StatePoolFree(SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT
+                                   pool) {
+  free(pool->words);
+  pool->words = nullptr;
+  pool->capacity = 0;
+}
+
+void SimdHwyHash_StatePoolGet(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool, size_t index,
+    SimdHwyHashState* SIMDHWYHASH_RESTRICT state) {
+  const size_t capacity = pool->capacity;
+  const uint64_t* words = pool->words + index;
+  for (size_t i = 0; i < 4; i++) {
+    state->v0[i] = words[i * capacity];
+    state->v1[i] = words[(4 + i) * capacity];
+    state->mul0[i] = words[(8 + i) * capacity];
+    state->mul1[i] = words[(12 + i) * capacity];
+  }
+}
+
+void SimdHwyHash_StatePoolSet(SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+                              size_t index,
+                              const SimdHwyHashState* SIMDHWYHASH_RESTRICT
+                                  state) {
+  const size_t capacity = pool->capacity;
+  uint64_t* words = pool->words + index;
+  for (size_t i = 0; i < 4; i++) {
+    words[i * capacity] = state->v0[i];
+    words[(4 + i) * capacity] = state->v1[i];
+    words[(8 + i) * capacity] = state->mul0[i];
+    words[(12 + i) * capacity] = state->mul1[i];
+  }
+}
+
+void SimdHwyHash_StatePoolReset(SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+                                size_t index,
+                                const uint64_t* SIMDHWYHASH_RESTRICT key) {
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, key);
+  SimdHwyHash_StatePoolSet(pool, index, &state);
+}
+
+void SimdHwyHash_StatePoolUpdateMany(
+    SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices,
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_streams) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(UpdateHwyHashStatePool)
+  (pool, indices, ptrs, byte_lens, num_streams);
+}
+
+void SimdHwyHash_StatePoolFinalizeMany64(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(FinalizeHwyHashStatePool64)
+  (pool, indices, num_streams, hashes);
+}
+
+void SimdHwyHash_StatePoolFinalizeMany128(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(FinalizeHwyHashStatePool128)
+  (pool, indices, num_streams, hashes);
+}
+
+void SimdHwyHash_StatePoolFinalizeMany256(
+    const SimdHwyHashStatePool* SIMDHWYHASH_RESTRICT pool,
+    const size_t* SIMDHWYHASH_RESTRICT indices, size_t num_streams,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(FinalizeHwyHashStatePool256)
+  (pool, indices, num_streams, hashes);
+}
+
+void SimdHwyHash_Hash64Batch(const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                             const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                             size_t num_inputs,
+                             const uint64_t* SIMDHWYHASH_RESTRICT key,
+                             uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(Hash64Batch)(ptrs, byte_lens, num_inputs, key, hashes);
+}
+
+void SimdHwyHash_Hash128Batch(const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                              const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                              size_t num_inputs,
+                              const uint64_t* SIMDHWYHASH_RESTRICT key,
+                              uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(Hash128Batch)(ptrs, byte_lens, num_inputs, key, hashes);
+}
+
+void SimdHwyHash_HashU64Keys64(const uint64_t* SIMDHWYHASH_RESTRICT keys,
+                               size_t num_keys,
+                               const uint64_t* SIMDHWYHASH_RESTRICT key,
+                               uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(HashU64Keys64)(keys, num_keys, key, hashes);
+}
+
+void SimdHwyHash_HashMultiKey64(const void* SIMDHWYHASH_RESTRICT ptr,
+                                size_t byte_len,
+                                const uint64_t (*SIMDHWYHASH_RESTRICT keys)[4],
+                                size_t num_keys,
+                                uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(HashMultiKey64)
+  (reinterpret_cast<const uint8_t*>(ptr), byte_len, keys, num_keys, hashes);
+}
+
+size_t SimdHwyHash_HashRecords64(const void* SIMDHWYHASH_RESTRICT buf,
+                                 size_t byte_len, uint8_t delimiter,
+                                 unsigned flags,
+                                 const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                 uint64_t* SIMDHWYHASH_RESTRICT hashes,
+                                 size_t (*SIMDHWYHASH_RESTRICT offsets)[2],
+                                 size_t max_records) {
+  using namespace simdhwyhash;
+  return SIMDHWYHASH_DISPATCH(HashRecords64)(
+      reinterpret_cast<const uint8_t*>(buf), byte_len, delimiter,
+      (flags & SIMDHWYHASH_RECORDS_CSV) != 0, key, hashes, offsets,
+      max_records);
+}
+
+void SimdHwyHash_RandomFill(const uint64_t* SIMDHWYHASH_RESTRICT key,
+                            uint64_t nonce, void* SIMDHWYHASH_RESTRICT out,
+                            size_t byte_len) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(RandomFill)(key, nonce, 0,
+                                   reinterpret_cast<uint8_t*>(out), byte_len);
+}
+
+void SimdHwyHash_RandomFillAt(const uint64_t* SIMDHWYHASH_RESTRICT key,
+                              uint64_t nonce, uint64_t offset,
+                              void* SIMDHWYHASH_RESTRICT out,
+                              size_t byte_len) {
+  using namespace simdhwyhash;
+  SIMDHWYHASH_DISPATCH(RandomFill)(key, nonce, offset,
+                                   reinterpret_cast<uint8_t*>(out), byte_len);
+}
+
+size_t SimdHwyHash_VerifyBatch128(
+    const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    const uint64_t (*SIMDHWYHASH_RESTRICT tags)[2],
+    uint8_t* SIMDHWYHASH_RESTRICT ok_bitmap) {
+  using namespace simdhwyhash;
+  return SIMDHWYHASH_DISPATCH(VerifyBatch128)(ptrs, byte_lens, num_inputs, key,
+                                              tags, ok_bitmap);
 }
 
 }  // extern "C"
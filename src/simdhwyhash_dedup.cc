@@ -0,0 +1,587 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_dedup.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SIMDHWYHASH_DEDUP_HAVE_MKSTEMP 1
+#include <unistd.h>
+#else
+#define SIMDHWYHASH_DEDUP_HAVE_MKSTEMP 0
+#endif
+
+// External-memory deduplication of records by their 128-bit hashes.
+//
+// Records are numbered in the order in which they are added, and each is
+// reduced to an entry of its 128-bit hash and its record ID. The records are
+// hashed kHashTaskRecords at a time on the workers of the thread pool with
+// SimdHwyHash_Hash128Batch, and their entries are radix-partitioned by the
+// upper 8 bits of the hash into the spill buffers of kNumDedupPartitions spill
+// files, each of which is appended to with a single large write once its
+// buffer is full. As the hashes are uniformly distributed, each partition
+// receives an equal share of the entries of distinct records.
+//
+// Once all of the records have been added, the partitions are processed in
+// parallel, with each worker getting an equal share of the memory budget. A
+// partition whose entries fit in that share is read in with a single read,
+// sorted by hash and then by record ID, and scanned for runs of equal hashes,
+// the first of which has the lowest record ID of its run. A larger partition,
+// such as one that holds many copies of the same record, is sorted and written
+// out in runs that fit in the share, and the sorted runs are then merged with
+// one buffer per run. All of the reads and writes other than the refills of
+// the merge buffers are sequential.
+
+namespace simdhwyhash {
+namespace {
+
+struct DedupEntry {
+  uint64_t hash[2];
+  uint64_t record_id;
+};
+
+static constexpr size_t kNumDedupPartitions = 256;
+
+// Records are hashed kHashChunkRecords at a time, in tasks of
+// kHashTaskRecords records each
+static constexpr size_t kHashChunkRecords = 65536;
+static constexpr size_t kHashTaskRecords = 4096;
+
+// The spill buffers, which take up half of the memory budget, and the sort and
+// merge buffers are never smaller than this many entries, which keeps the
+// reads and writes large even for a small memory budget
+static constexpr size_t kMinDedupBufferEntries = 1024;
+
+// Number of records that are passed to each call of the SimdHwyHashDedupFunc
+static constexpr size_t kDedupEmitBatchSize = 4096;
+
+static inline bool DedupEntryLess(const DedupEntry& a, const DedupEntry& b) {
+  if (a.hash[0] != b.hash[0]) {
+    return a.hash[0] < b.hash[0];
+  }
+  if (a.hash[1] != b.hash[1]) {
+    return a.hash[1] < b.hash[1];
+  }
+  return a.record_id < b.record_id;
+}
+
+// Creates a temporary file in spill_dir (or in the default temporary directory
+// if spill_dir is empty or mkstemp is not available) that is removed once it
+// is closed
+static FILE* OpenSpillFile(const std::string& spill_dir) {
+#if SIMDHWYHASH_DEDUP_HAVE_MKSTEMP
+  if (!spill_dir.empty()) {
+    std::string path = spill_dir + "/simdhwyhash_dedup_XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    // The file is unlinked right away so that it is removed even if the
+    // process exits without closing it
+    unlink(path.c_str());
+    FILE* file = fdopen(fd, "w+b");
+    if (!file) {
+      close(fd);
+      return nullptr;
+    }
+    setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+  }
+#endif
+
+  FILE* file = tmpfile();
+  if (file) {
+    setvbuf(file, nullptr, _IONBF, 0);
+  }
+  return file;
+}
+
+static bool SeekSpillFile(FILE* file, uint64_t entry_index) {
+  const uint64_t offset = entry_index * sizeof(DedupEntry);
+#if defined(_WIN32)
+  return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+static bool WriteEntries(FILE* file, const DedupEntry* entries, size_t n) {
+  return n == 0 || fwrite(entries, sizeof(DedupEntry), n, file) == n;
+}
+
+static bool ReadEntries(FILE* file, DedupEntry* entries, size_t n) {
+  return n == 0 || fread(entries, sizeof(DedupEntry), n, file) == n;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+struct SimdHwyHashDedup {
+  uint64_t key[4];
+  SimdHwyHashThreadPool* pool = nullptr;
+  std::string spill_dir;
+  size_t memory_budget = 0;
+
+  uint64_t num_records = 0;
+  bool failed = false;
+  bool finished = false;
+
+  // Entries of partition p that have not been written to its spill file yet
+  // are at spill_buffers[p * spill_buffer_entries]
+  size_t spill_buffer_entries = 0;
+  std::unique_ptr<simdhwyhash::DedupEntry[]> spill_buffers;
+  size_t spill_buffer_counts[simdhwyhash::kNumDedupPartitions] = {};
+
+  // The spill file of each partition is created by its first write
+  FILE* partition_files[simdhwyhash::kNumDedupPartitions] = {};
+  uint64_t partition_num_entries[simdhwyhash::kNumDedupPartitions] = {};
+
+  std::unique_ptr<uint64_t[]> chunk_hashes;
+};
+
+namespace simdhwyhash {
+namespace {
+
+static bool FlushSpillBuffer(SimdHwyHashDedup* dedup, size_t partition) {
+  const size_t n = dedup->spill_buffer_counts[partition];
+  if (n == 0) {
+    return true;
+  }
+
+  FILE*& file = dedup->partition_files[partition];
+  if (!file) {
+    file = OpenSpillFile(dedup->spill_dir);
+    if (!file) {
+      return false;
+    }
+  }
+
+  if (!WriteEntries(file,
+                    dedup->spill_buffers.get() +
+                        partition * dedup->spill_buffer_entries,
+                    n)) {
+    return false;
+  }
+  dedup->partition_num_entries[partition] += n;
+  dedup->spill_buffer_counts[partition] = 0;
+  return true;
+}
+
+struct HashChunkTaskContext {
+  const void* const* ptrs;
+  const size_t* byte_lens;
+  size_t num_records;
+  const uint64_t* key;
+  uint64_t* hashes;
+};
+
+static void RunHashChunkTask(void* context, size_t task_index) {
+  const HashChunkTaskContext& ctx =
+      *static_cast<const HashChunkTaskContext*>(context);
+  const size_t start = task_index * kHashTaskRecords;
+  const size_t remaining = ctx.num_records - start;
+  const size_t n =
+      (remaining < kHashTaskRecords) ? remaining : kHashTaskRecords;
+  SimdHwyHash_Hash128Batch(ctx.ptrs + start, ctx.byte_lens + start, n, ctx.key,
+                           ctx.hashes + start * 2);
+}
+
+// Hashes up to kHashChunkRecords records into dedup->chunk_hashes, and
+// appends their entries to the spill buffers of their partitions
+static bool AddRecordChunk(SimdHwyHashDedup* dedup,
+                           const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                           const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                           size_t num_records) {
+  uint64_t* hashes = dedup->chunk_hashes.get();
+  HashChunkTaskContext context = {ptrs, byte_lens, num_records, dedup->key,
+                                  hashes};
+  const size_t num_tasks =
+      (num_records + kHashTaskRecords - 1) / kHashTaskRecords;
+  if (dedup->pool) {
+    SimdHwyHash_ThreadPoolRun(dedup->pool, num_tasks, RunHashChunkTask,
+                              &context);
+  } else {
+    for (size_t t = 0; t < num_tasks; t++) {
+      RunHashChunkTask(&context, t);
+    }
+  }
+
+  DedupEntry* spill_buffers = dedup->spill_buffers.get();
+  const size_t spill_buffer_entries = dedup->spill_buffer_entries;
+  for (size_t i = 0; i < num_records; i++) {
+    const size_t partition = static_cast<size_t>(hashes[i * 2] >> 56);
+    size_t& count = dedup->spill_buffer_counts[partition];
+
+    DedupEntry& entry = spill_buffers[partition * spill_buffer_entries + count];
+    entry.hash[0] = hashes[i * 2];
+    entry.hash[1] = hashes[i * 2 + 1];
+    entry.record_id = dedup->num_records + i;
+    if (++count == spill_buffer_entries &&
+        !FlushSpillBuffer(dedup, partition)) {
+      return false;
+    }
+  }
+
+  dedup->num_records += num_records;
+  return true;
+}
+
+struct PartitionTaskContext {
+  SimdHwyHashDedup* dedup;
+  size_t max_sort_entries;
+  SimdHwyHashDedupFunc func;
+  void* context;
+
+  // Serializes the calls to func from different workers
+  std::mutex emit_mutex;
+  std::atomic<bool> failed;
+};
+
+// Record IDs of the sorted entries of a partition, along with the record ID
+// of the first entry of their run of equal hashes, which are passed to the
+// SimdHwyHashDedupFunc kDedupEmitBatchSize records at a time
+struct DedupEmitter {
+  PartitionTaskContext* ctx;
+  uint64_t record_ids[kDedupEmitBatchSize];
+  uint64_t first_record_ids[kDedupEmitBatchSize];
+  size_t num_pending;
+
+  uint64_t run_hash[2];
+  uint64_t run_first_record_id;
+  bool in_run;
+};
+
+static void FlushDedupEmitter(DedupEmitter& emitter) {
+  if (emitter.num_pending != 0) {
+    PartitionTaskContext& ctx = *emitter.ctx;
+    std::lock_guard<std::mutex> lock(ctx.emit_mutex);
+    ctx.func(ctx.context, emitter.record_ids, emitter.first_record_ids,
+             emitter.num_pending);
+  }
+  emitter.num_pending = 0;
+}
+
+static void EmitDedupEntry(DedupEmitter& emitter, const DedupEntry& entry) {
+  if (!emitter.in_run || entry.hash[0] != emitter.run_hash[0] ||
+      entry.hash[1] != emitter.run_hash[1]) {
+    emitter.run_hash[0] = entry.hash[0];
+    emitter.run_hash[1] = entry.hash[1];
+    emitter.run_first_record_id = entry.record_id;
+    emitter.in_run = true;
+  }
+
+  emitter.record_ids[emitter.num_pending] = entry.record_id;
+  emitter.first_record_ids[emitter.num_pending] = emitter.run_first_record_id;
+  if (++emitter.num_pending == kDedupEmitBatchSize) {
+    FlushDedupEmitter(emitter);
+  }
+}
+
+// A sorted run of a partition that is too large to be sorted in memory, whose
+// entries are read into buffer as they are merged
+struct SortedRunCursor {
+  uint64_t next_entry;
+  uint64_t end_entry;
+  DedupEntry* buffer;
+  size_t pos;
+  size_t count;
+};
+
+static bool RefillSortedRun(FILE* run_file, SortedRunCursor& cursor,
+                            size_t buffer_entries) {
+  const uint64_t remaining = cursor.end_entry - cursor.next_entry;
+  const size_t n = (remaining < buffer_entries)
+                       ? static_cast<size_t>(remaining)
+                       : buffer_entries;
+  if (!SeekSpillFile(run_file, cursor.next_entry) ||
+      !ReadEntries(run_file, cursor.buffer, n)) {
+    return false;
+  }
+  cursor.next_entry += n;
+  cursor.pos = 0;
+  cursor.count = n;
+  return true;
+}
+
+// Sorts the num_entries entries of file, which are more than max_sort_entries,
+// in runs of max_sort_entries entries, and merges the runs into emitter
+static bool MergeSortLargePartition(const std::string& spill_dir, FILE* file,
+                                    uint64_t num_entries,
+                                    size_t max_sort_entries,
+                                    DedupEmitter& emitter) {
+  FILE* run_file = OpenSpillFile(spill_dir);
+  if (!run_file) {
+    return false;
+  }
+  std::unique_ptr<FILE, int (*)(FILE*)> run_file_closer(run_file, fclose);
+
+  std::vector<DedupEntry> entries(max_sort_entries);
+  const size_t num_runs =
+      static_cast<size_t>((num_entries + max_sort_entries - 1) /
+                          max_sort_entries);
+  for (size_t r = 0; r < num_runs; r++) {
+    const uint64_t remaining = num_entries - uint64_t{r} * max_sort_entries;
+    const size_t n = (remaining < max_sort_entries)
+                         ? static_cast<size_t>(remaining)
+                         : max_sort_entries;
+    if (!ReadEntries(file, entries.data(), n)) {
+      return false;
+    }
+    std::sort(entries.begin(), entries.begin() + n, DedupEntryLess);
+    if (!WriteEntries(run_file, entries.data(), n)) {
+      return false;
+    }
+  }
+
+  // The buffers of the runs share the memory of the sort buffer, unless there
+  // are so many runs that each would get fewer than kMinDedupBufferEntries
+  const size_t buffer_entries = std::max(max_sort_entries / num_runs,
+                                         kMinDedupBufferEntries);
+  entries.resize(buffer_entries * num_runs);
+
+  std::vector<SortedRunCursor> cursors(num_runs);
+  std::vector<size_t> heap;
+  heap.reserve(num_runs);
+  for (size_t r = 0; r < num_runs; r++) {
+    SortedRunCursor& cursor = cursors[r];
+    cursor.next_entry = uint64_t{r} * max_sort_entries;
+    cursor.end_entry =
+        std::min(cursor.next_entry + max_sort_entries, num_entries);
+    cursor.buffer = entries.data() + r * buffer_entries;
+    if (!RefillSortedRun(run_file, cursor, buffer_entries)) {
+      return false;
+    }
+    heap.push_back(r);
+  }
+
+  // Min-heap of the runs, ordered by their next entry
+  const auto heap_less = [&cursors](size_t a, size_t b) {
+    return DedupEntryLess(cursors[b].buffer[cursors[b].pos],
+                          cursors[a].buffer[cursors[a].pos]);
+  };
+  std::make_heap(heap.begin(), heap.end(), heap_less);
+
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), heap_less);
+    SortedRunCursor& cursor = cursors[heap.back()];
+    EmitDedupEntry(emitter, cursor.buffer[cursor.pos]);
+
+    if (++cursor.pos == cursor.count) {
+      if (cursor.next_entry == cursor.end_entry) {
+        heap.pop_back();
+        continue;
+      }
+      if (!RefillSortedRun(run_file, cursor, buffer_entries)) {
+        return false;
+      }
+    }
+    std::push_heap(heap.begin(), heap.end(), heap_less);
+  }
+
+  return true;
+}
+
+static bool ProcessPartition(PartitionTaskContext& ctx, size_t partition) {
+  SimdHwyHashDedup* dedup = ctx.dedup;
+  const uint64_t num_entries = dedup->partition_num_entries[partition];
+  if (num_entries == 0) {
+    return true;
+  }
+
+  // The spill file is closed, which removes it, once it has been read
+  std::unique_ptr<FILE, int (*)(FILE*)> file(dedup->partition_files[partition],
+                                             fclose);
+  dedup->partition_files[partition] = nullptr;
+  rewind(file.get());
+
+  // The emitter holds 64 KiB of record IDs, so it is not kept on the stack
+  std::unique_ptr<DedupEmitter> emitter(new DedupEmitter);
+  emitter->ctx = &ctx;
+  emitter->num_pending = 0;
+  emitter->in_run = false;
+  if (num_entries <= ctx.max_sort_entries) {
+    std::vector<DedupEntry> entries(static_cast<size_t>(num_entries));
+    if (!ReadEntries(file.get(), entries.data(), entries.size())) {
+      return false;
+    }
+    std::sort(entries.begin(), entries.end(), DedupEntryLess);
+    for (const DedupEntry& entry : entries) {
+      EmitDedupEntry(*emitter, entry);
+    }
+  } else if (!MergeSortLargePartition(dedup->spill_dir, file.get(),
+                                      num_entries, ctx.max_sort_entries,
+                                      *emitter)) {
+    return false;
+  }
+
+  FlushDedupEmitter(*emitter);
+  return true;
+}
+
+static void RunPartitionTask(void* context, size_t task_index) {
+  PartitionTaskContext& ctx = *static_cast<PartitionTaskContext*>(context);
+  if (ctx.failed.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  bool ok;
+  try {
+    ok = ProcessPartition(ctx, task_index);
+  } catch (...) {
+    ok = false;
+  }
+  if (!ok) {
+    ctx.failed.store(true, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+SimdHwyHashDedup* SimdHwyHash_DedupCreate(
+    const char* spill_dir, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    size_t memory_budget, SimdHwyHashThreadPool* pool) {
+  using namespace simdhwyhash;
+
+  SimdHwyHashDedup* dedup = new (std::nothrow) SimdHwyHashDedup;
+  if (!dedup) {
+    return nullptr;
+  }
+
+  try {
+    memcpy(dedup->key, key, sizeof(dedup->key));
+    dedup->pool = pool;
+    if (spill_dir) {
+      dedup->spill_dir = spill_dir;
+    }
+    dedup->memory_budget = memory_budget;
+
+    dedup->spill_buffer_entries =
+        std::max(memory_budget / 2 / kNumDedupPartitions / sizeof(DedupEntry),
+                 kMinDedupBufferEntries);
+    dedup->spill_buffers.reset(
+        new DedupEntry[kNumDedupPartitions * dedup->spill_buffer_entries]);
+    dedup->chunk_hashes.reset(new uint64_t[kHashChunkRecords * 2]);
+  } catch (...) {
+    delete dedup;
+    return nullptr;
+  }
+
+  return dedup;
+}
+
+void SimdHwyHash_DedupDestroy(SimdHwyHashDedup* dedup) {
+  if (!dedup) {
+    return;
+  }
+
+  for (FILE* file : dedup->partition_files) {
+    if (file) {
+      fclose(file);
+    }
+  }
+  delete dedup;
+}
+
+int SimdHwyHash_DedupAdd(SimdHwyHashDedup* SIMDHWYHASH_RESTRICT dedup,
+                         const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                         const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                         size_t num_records) {
+  using namespace simdhwyhash;
+
+  if (dedup->failed || dedup->finished) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < num_records; i += kHashChunkRecords) {
+    const size_t remaining = num_records - i;
+    const size_t n =
+        (remaining < kHashChunkRecords) ? remaining : kHashChunkRecords;
+    if (!AddRecordChunk(dedup, ptrs + i, byte_lens + i, n)) {
+      dedup->failed = true;
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+uint64_t SimdHwyHash_DedupNumRecords(const SimdHwyHashDedup* dedup) {
+  return dedup->num_records;
+}
+
+int SimdHwyHash_DedupFinish(SimdHwyHashDedup* dedup,
+                            SimdHwyHashDedupFunc func, void* context) {
+  using namespace simdhwyhash;
+
+  if (dedup->failed || dedup->finished) {
+    return 0;
+  }
+  dedup->finished = true;
+
+  for (size_t p = 0; p < kNumDedupPartitions; p++) {
+    if (!FlushSpillBuffer(dedup, p)) {
+      dedup->failed = true;
+      return 0;
+    }
+  }
+
+  // The spill buffers are no longer needed, which leaves the whole memory
+  // budget to the sorting of the partitions
+  dedup->spill_buffers.reset();
+  dedup->chunk_hashes.reset();
+
+  const size_t num_workers =
+      dedup->pool ? SimdHwyHash_ThreadPoolNumThreads(dedup->pool) : 1;
+
+  PartitionTaskContext task_context;
+  task_context.dedup = dedup;
+  task_context.max_sort_entries =
+      std::max(dedup->memory_budget / num_workers / sizeof(DedupEntry),
+               kMinDedupBufferEntries);
+  task_context.func = func;
+  task_context.context = context;
+  task_context.failed.store(false, std::memory_order_relaxed);
+
+  if (dedup->pool) {
+    SimdHwyHash_ThreadPoolRun(dedup->pool, kNumDedupPartitions,
+                              RunPartitionTask, &task_context);
+  } else {
+    for (size_t p = 0; p < kNumDedupPartitions; p++) {
+      RunPartitionTask(&task_context, p);
+    }
+  }
+
+  if (task_context.failed.load(std::memory_order_relaxed)) {
+    dedup->failed = true;
+    return 0;
+  }
+  return 1;
+}
+
+}  // extern "C"
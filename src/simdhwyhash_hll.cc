@@ -0,0 +1,343 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_hll.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "simdhwyhash_hll.cc"
+#include "hwy/foreach_target.h"
+#include "hwy/highway.h"
+
+// HyperLogLog sketches of keyed HighwayHash values. The upper precision bits
+// of each hash select a register, and the register holds the maximum rank (the
+// number of leading zeros of the remaining bits plus one) of the hashes that
+// selected it.
+//
+// Register updates are encoded as (index << 8) | rank. Sketches start out in
+// a sparse representation, which is an open-addressed table of encoded
+// updates with one entry per register index, and are converted to 2^precision
+// dense 8-bit registers once the table is three-quarters full.
+
+namespace simdhwyhash {
+
+HWY_BEFORE_NAMESPACE();
+namespace HWY_NAMESPACE {
+namespace {
+
+using hwy::HWY_NAMESPACE::Add;
+using hwy::HWY_NAMESPACE::LeadingZeroCount;
+using hwy::HWY_NAMESPACE::Max;
+using hwy::HWY_NAMESPACE::Or;
+using hwy::HWY_NAMESPACE::Rebind;
+using hwy::HWY_NAMESPACE::ScalableTag;
+using hwy::HWY_NAMESPACE::ShiftLeft;
+using hwy::HWY_NAMESPACE::ShiftLeftSame;
+using hwy::HWY_NAMESPACE::ShiftRightSame;
+using hwy::HWY_NAMESPACE::TruncateTo;
+
+// Computes the encoded register update of hashes[i] for each i less than
+// num_hashes
+static void ComputeHllUpdates(const uint64_t* HWY_RESTRICT hashes,
+                              size_t num_hashes, unsigned precision,
+                              uint32_t* HWY_RESTRICT updates) {
+  const ScalableTag<uint64_t> d;
+  const Rebind<uint32_t, decltype(d)> du32;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  const int index_shift = static_cast<int>(64 - precision);
+  const int rank_shift = static_cast<int>(precision);
+
+  // The sentinel bit caps the rank at 64 - precision + 1
+  const auto sentinel = Set(d, uint64_t{1} << (precision - 1));
+  const auto one = Set(d, uint64_t{1});
+
+  for (size_t i = 0; i < num_hashes; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_hashes - i);
+    const auto h = LoadN(d, hashes + i, n);
+
+    const auto index = ShiftRightSame(h, index_shift);
+    const auto rank =
+        Add(LeadingZeroCount(Or(ShiftLeftSame(h, rank_shift), sentinel)), one);
+    StoreN(TruncateTo(du32, Or(ShiftLeft<8>(index), rank)), du32, updates + i,
+           n);
+  }
+}
+
+static void MaxU8(uint8_t* HWY_RESTRICT dst, const uint8_t* HWY_RESTRICT src,
+                  size_t num_bytes) {
+  const ScalableTag<uint8_t> d;
+  const size_t lanes_per_u8_vec = Lanes(d);
+
+  size_t i = 0;
+  for (; i + lanes_per_u8_vec <= num_bytes; i += lanes_per_u8_vec) {
+    StoreU(Max(LoadU(d, dst + i), LoadU(d, src + i)), d, dst + i);
+  }
+
+  if (i < num_bytes) {
+    const size_t n = num_bytes - i;
+    StoreN(Max(LoadN(d, dst + i, n), LoadN(d, src + i, n)), d, dst + i, n);
+  }
+}
+
+}  // namespace
+}  // namespace HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace {
+HWY_EXPORT(ComputeHllUpdates);
+HWY_EXPORT(MaxU8);
+
+// Number of keys that are hashed by each call to SimdHwyHash_Hash64Batch
+static constexpr size_t kHllBatchSize = 256;
+
+static inline size_t HllNumRegisters(const SimdHwyHashHll* hll) {
+  return size_t{1} << hll->precision;
+}
+
+static inline void ApplyDenseUpdate(uint8_t* HWY_RESTRICT registers,
+                                    uint32_t update) {
+  const uint8_t rank = static_cast<uint8_t>(update & 0xFFu);
+  uint8_t& reg = registers[update >> 8];
+  reg = (rank > reg) ? rank : reg;
+}
+
+static int ConvertToDense(SimdHwyHashHll* HWY_RESTRICT hll) {
+  uint8_t* registers = static_cast<uint8_t*>(calloc(HllNumRegisters(hll), 1));
+  if (!registers) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < hll->sparse_capacity; i++) {
+    const uint32_t update = hll->sparse_entries[i];
+    if (update != 0) {
+      ApplyDenseUpdate(registers, update);
+    }
+  }
+
+  free(hll->sparse_entries);
+  hll->sparse_entries = nullptr;
+  hll->num_sparse_entries = 0;
+  hll->sparse_capacity = 0;
+  hll->registers = registers;
+  return 1;
+}
+
+// Applies update to the sparse table of hll, converting hll to the dense
+// representation once the table is three-quarters full
+static int ApplySparseUpdate(SimdHwyHashHll* HWY_RESTRICT hll,
+                             uint32_t update) {
+  const size_t slot_mask = hll->sparse_capacity - 1;
+  const uint32_t index = update >> 8;
+
+  // The register index comes from the upper bits of a hash, so its lower bits
+  // are suitable for selecting the starting slot
+  for (size_t slot = index & slot_mask;; slot = (slot + 1) & slot_mask) {
+    uint32_t& entry = hll->sparse_entries[slot];
+    if (entry == 0) {
+      entry = update;
+      break;
+    }
+    if ((entry >> 8) == index) {
+      entry = (update > entry) ? update : entry;
+      return 1;
+    }
+  }
+
+  if (++hll->num_sparse_entries * 4 > hll->sparse_capacity * 3) {
+    return ConvertToDense(hll);
+  }
+  return 1;
+}
+
+static int ApplyUpdates(SimdHwyHashHll* HWY_RESTRICT hll,
+                        const uint32_t* HWY_RESTRICT updates,
+                        size_t num_updates) {
+  size_t i = 0;
+  for (; !hll->registers && i < num_updates; i++) {
+    if (!ApplySparseUpdate(hll, updates[i])) {
+      return 0;
+    }
+  }
+
+  for (; i < num_updates; i++) {
+    ApplyDenseUpdate(hll->registers, updates[i]);
+  }
+  return 1;
+}
+}  // namespace
+#endif  // HWY_ONCE
+
+}  // namespace simdhwyhash
+
+#if HWY_ONCE
+extern "C" {
+
+int SimdHwyHash_HllInit(SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+                        const uint64_t* SIMDHWYHASH_RESTRICT key,
+                        unsigned precision) {
+  hll->registers = nullptr;
+  hll->sparse_entries = nullptr;
+  hll->num_sparse_entries = 0;
+  hll->sparse_capacity = 0;
+  hll->precision = 0;
+
+  if (precision < SIMDHWYHASH_HLL_MIN_PRECISION ||
+      precision > SIMDHWYHASH_HLL_MAX_PRECISION) {
+    return 0;
+  }
+
+  // The sparse table takes up at most a quarter of the size of the dense
+  // registers
+  const size_t sparse_capacity = size_t{1} << (precision - 4);
+  uint32_t* sparse_entries =
+      static_cast<uint32_t*>(calloc(sparse_capacity, sizeof(uint32_t)));
+  if (!sparse_entries) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < 4; i++) {
+    hll->key[i] = key[i];
+  }
+  hll->sparse_entries = sparse_entries;
+  hll->sparse_capacity = sparse_capacity;
+  hll->precision = precision;
+  return 1;
+}
+
+void SimdHwyHash_HllFree(SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll) {
+  free(hll->registers);
+  free(hll->sparse_entries);
+  hll->registers = nullptr;
+  hll->sparse_entries = nullptr;
+  hll->num_sparse_entries = 0;
+  hll->sparse_capacity = 0;
+}
+
+int SimdHwyHash_HllAdd(SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+                       const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
+  const void* ptrs[1] = {ptr};
+  return SimdHwyHash_HllAddBatch(hll, ptrs, &byte_len, 1);
+}
+
+int SimdHwyHash_HllAddBatch(SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll,
+                            const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                            const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                            size_t num_keys) {
+  using namespace simdhwyhash;
+
+  uint64_t hashes[kHllBatchSize];
+  uint32_t updates[kHllBatchSize];
+  for (size_t i = 0; i < num_keys; i += kHllBatchSize) {
+    const size_t remaining = num_keys - i;
+    const size_t n = (remaining < kHllBatchSize) ? remaining : kHllBatchSize;
+
+    SimdHwyHash_Hash64Batch(ptrs + i, byte_lens + i, n, hll->key, hashes);
+    HWY_DYNAMIC_DISPATCH(ComputeHllUpdates)(hashes, n, hll->precision, updates);
+    if (!ApplyUpdates(hll, updates, n)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int SimdHwyHash_HllMerge(SimdHwyHashHll* SIMDHWYHASH_RESTRICT dst,
+                         const SimdHwyHashHll* SIMDHWYHASH_RESTRICT src) {
+  using namespace simdhwyhash;
+
+  if (dst->precision != src->precision || dst->key[0] != src->key[0] ||
+      dst->key[1] != src->key[1] || dst->key[2] != src->key[2] ||
+      dst->key[3] != src->key[3]) {
+    return 0;
+  }
+
+  if (!src->registers) {
+    for (size_t i = 0; i < src->sparse_capacity; i++) {
+      const uint32_t update = src->sparse_entries[i];
+      if (update != 0 && !ApplyUpdates(dst, &update, 1)) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+
+  if (!dst->registers && !ConvertToDense(dst)) {
+    return 0;
+  }
+
+  HWY_DYNAMIC_DISPATCH(MaxU8)
+  (dst->registers, src->registers, HllNumRegisters(dst));
+  return 1;
+}
+
+double SimdHwyHash_HllEstimate(const SimdHwyHashHll* SIMDHWYHASH_RESTRICT hll) {
+  using namespace simdhwyhash;
+
+  const size_t num_registers = HllNumRegisters(hll);
+
+  // Registers that are zero contribute 2^0 to the harmonic sum
+  size_t num_zero_registers = num_registers;
+  double sum = 0.0;
+  if (hll->registers) {
+    for (size_t i = 0; i < num_registers; i++) {
+      const uint8_t rank = hll->registers[i];
+      if (rank != 0) {
+        num_zero_registers--;
+        sum += ldexp(1.0, -static_cast<int>(rank));
+      }
+    }
+  } else {
+    for (size_t i = 0; i < hll->sparse_capacity; i++) {
+      const uint32_t update = hll->sparse_entries[i];
+      if (update != 0) {
+        num_zero_registers--;
+        sum += ldexp(1.0, -static_cast<int>(update & 0xFFu));
+      }
+    }
+  }
+  sum += static_cast<double>(num_zero_registers);
+
+  const double m = static_cast<double>(num_registers);
+  double alpha;
+  switch (num_registers) {
+    case 16:
+      alpha = 0.673;
+      break;
+    case 32:
+      alpha = 0.697;
+      break;
+    case 64:
+      alpha = 0.709;
+      break;
+    default:
+      alpha = 0.7213 / (1.0 + 1.079 / m);
+      break;
+  }
+
+  const double estimate = alpha * m * m / sum;
+
+  // Linear counting is more accurate for small cardinalities, and the 64-bit
+  // hashes make a large range correction unnecessary
+  if (estimate <= 2.5 * m && num_zero_registers != 0) {
+    return m * log(m / static_cast<double>(num_zero_registers));
+  }
+  return estimate;
+}
+
+}  // extern "C"
+#endif  // HWY_ONCE
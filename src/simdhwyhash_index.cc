@@ -0,0 +1,1072 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_index.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SIMDHWYHASH_INDEX_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SIMDHWYHASH_INDEX_HAVE_MMAP 0
+#endif
+
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "simdhwyhash_index.cc"
+#include "hwy/foreach_target.h"
+#include "hwy/highway.h"
+
+// Memory-mapped index from 128-bit hashes to 64-bit locations.
+//
+// The index file is made up of 4 KiB pages, with all integers stored in the
+// native byte order. Page 0 is the header:
+//   bytes 0-7: kIndexMagicAndVersion
+//   bytes 8-15: page size
+//   bytes 16-23: level in the lower 8 bits, split bucket in the upper bits
+//   bytes 24-31: number of entries
+//   bytes 32-39: number of pages that have been allocated
+//   bytes 40-47: 1 if the index was closed cleanly, 0 otherwise
+//   bytes 64-575: first page of each of the 64 segments
+//
+// The buckets are addressed by linear hashing: with level L and split bucket
+// s, the bucket of a hash is its first word modulo 2^L, or modulo 2^(L+1) if
+// that is less than s. The index grows by one bucket at a time, by splitting
+// bucket s into buckets s and s + 2^L, so no insert ever has to rehash more
+// than one bucket. Segment 0 holds buckets 0 to 2^kMinLevel - 1, and segment
+// k holds buckets 2^(kMinLevel+k-1) to 2^(kMinLevel+k) - 1. The pages of a
+// segment are allocated when the first of its buckets is split into, but are
+// only written to when their buckets are split into, so the file stays sparse.
+//
+// Each bucket is a page, followed by a chain of overflow pages if it holds
+// more than kEntriesPerPage entries:
+//   bytes 0-3: version of the bucket, which is odd while it is rewritten
+//   bytes 4-7: number of entries in the page
+//   bytes 8-15: next overflow page of the chain, or 0
+//   bytes 16-178: tag of each entry (the upper 8 bits of the hash)
+//   bytes 184-4095: entries, each of which is the hash followed by the location
+//
+// The tags of a page are compared with the tag of a hash using vectors of up
+// to 64 bytes, and only the entries whose tags match are compared in full.
+//
+// A single writer, which holds an exclusive flock on the file, inserts entries
+// while any number of readers look up hashes. An entry is written before the
+// entry count of its page is increased, and a page is written before it is
+// linked into a chain, so readers never see partial entries. Entries are only
+// ever moved or removed by a split, which rewrites the bucket that was split
+// between two updates of its version, and readers retry a lookup if the
+// version of its bucket or the level and split bucket change while it runs.
+//
+// A split first copies the entries that move to the new bucket, then updates
+// the level and split bucket, and only then removes the entries from the old
+// bucket, so a crash at any point leaves every entry reachable. The writer
+// finishes the last split again when it opens an index that was not closed
+// cleanly. If SIMDHWYHASH_INDEX_DURABLE is set, the steps of each split are
+// also ordered with msync, which keeps the index valid after a power loss.
+
+namespace simdhwyhash {
+
+HWY_BEFORE_NAMESPACE();
+namespace HWY_NAMESPACE {
+namespace {
+
+using hwy::HWY_NAMESPACE::And;
+using hwy::HWY_NAMESPACE::CappedTag;
+using hwy::HWY_NAMESPACE::Eq;
+
+// Sets bit i % 8 of match_bits[i / 8] for each i less than num_tags for which
+// tags[i] is equal to tag. The bits of the other tags are left unchanged.
+static void MatchTags(const uint8_t* HWY_RESTRICT tags, size_t num_tags,
+                      uint8_t tag, uint8_t* HWY_RESTRICT match_bits) {
+#if HWY_TARGET == HWY_SCALAR
+  for (size_t i = 0; i < num_tags; i++) {
+    if (tags[i] == tag) {
+      match_bits[i / 8] =
+          static_cast<uint8_t>(match_bits[i / 8] | (1u << (i & 7)));
+    }
+  }
+#else
+  // Every vector has a multiple of 8 lanes, so the mask bits of each vector
+  // start at a byte boundary
+  const CappedTag<uint8_t, 64> d;
+  const size_t lanes_per_u8_vec = Lanes(d);
+  const auto v_tag = Set(d, tag);
+
+  for (size_t i = 0; i < num_tags; i += lanes_per_u8_vec) {
+    const size_t n = HWY_MIN(lanes_per_u8_vec, num_tags - i);
+    const auto m = And(FirstN(d, n), Eq(LoadN(d, tags + i, n), v_tag));
+    StoreMaskBits(d, m, match_bits + i / 8);
+  }
+#endif
+}
+
+}  // namespace
+}  // namespace HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace {
+HWY_EXPORT(MatchTags);
+}  // namespace
+#endif  // HWY_ONCE
+
+}  // namespace simdhwyhash
+
+#if HWY_ONCE
+#if SIMDHWYHASH_INDEX_HAVE_MMAP
+
+namespace simdhwyhash {
+namespace {
+
+// "SHIX" followed by version 1 as a 32-bit integer
+static constexpr uint64_t kIndexMagicAndVersion = 0x0000000158494853u;
+
+static constexpr size_t kIndexPageSize = 4096;
+
+static constexpr size_t kHeaderStateOffset = 16;
+static constexpr size_t kHeaderNumEntriesOffset = 24;
+static constexpr size_t kHeaderNumPagesOffset = 32;
+static constexpr size_t kHeaderCleanOffset = 40;
+static constexpr size_t kHeaderSegmentsOffset = 64;
+
+static constexpr size_t kPageCountOffset = 4;
+static constexpr size_t kPageOverflowOffset = 8;
+static constexpr size_t kPageTagsOffset = 16;
+static constexpr size_t kPageEntriesOffset = 184;
+
+static constexpr size_t kEntrySize = 24;
+static constexpr size_t kEntriesPerPage = 163;
+static_assert(kPageTagsOffset + kEntriesPerPage <= kPageEntriesOffset &&
+                  kPageEntriesOffset + kEntriesPerPage * kEntrySize <=
+                      kIndexPageSize,
+              "The tags and entries must fit in a page");
+
+// Size of the match bits of a page, which MatchTags may write up to 64 bits
+// past the last tag of
+static constexpr size_t kMatchBitsSize = 32;
+static_assert((kEntriesPerPage + 64 + 7) / 8 <= kMatchBitsSize,
+              "kMatchBitsSize is too small");
+
+static constexpr unsigned kMinLevel = 4;
+static constexpr unsigned kMaxLevel = 40;
+static constexpr size_t kNumSegments = 64;
+
+// A bucket is split each time that the number of entries exceeds this many
+// times the number of buckets, which leaves enough room in the buckets that
+// have not been split yet that few of them overflow
+static constexpr uint64_t kTargetEntriesPerBucket = 96;
+
+// The file is extended in steps of kFileGrowthBytes, which is a multiple of
+// the page size of every supported system
+static constexpr size_t kFileGrowthBytes = size_t{1} << 20;
+
+// Address space that is reserved for the mapping of the file, so that the
+// mapping never moves when the file grows. Smaller reservations, down to
+// kMinMappedBytes, are tried if the system cannot reserve this much.
+static constexpr size_t kMaxMappedBytes =
+    (sizeof(void*) >= 8) ? (size_t{1} << 40) : (size_t{1} << 30);
+static constexpr size_t kMinMappedBytes = size_t{1} << 26;
+
+static constexpr int kMaxFindAttempts = 1 << 16;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "The index file is shared through lock-free atomics");
+
+static inline std::atomic<uint32_t>& AtomicU32At(uint8_t* ptr) {
+  return *reinterpret_cast<std::atomic<uint32_t>*>(ptr);
+}
+
+static inline std::atomic<uint64_t>& AtomicU64At(uint8_t* ptr) {
+  return *reinterpret_cast<std::atomic<uint64_t>*>(ptr);
+}
+
+static inline uint64_t LoadLE64(const uint8_t* ptr) {
+  uint64_t val = 0;
+  for (size_t i = 0; i < 8; i++) {
+    val |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+  }
+  return val;
+}
+
+static inline uint8_t TagOfHash(const uint64_t* hash) {
+  return static_cast<uint8_t>(hash[1] >> 56);
+}
+
+static inline unsigned StateLevel(uint64_t state) {
+  return static_cast<unsigned>(state & 0xFFu);
+}
+
+static inline uint64_t StateSplit(uint64_t state) { return state >> 8; }
+
+static inline uint64_t MakeState(unsigned level, uint64_t split) {
+  return (split << 8) | level;
+}
+
+static inline uint64_t StateNumBuckets(uint64_t state) {
+  return (uint64_t{1} << StateLevel(state)) + StateSplit(state);
+}
+
+static inline uint64_t BucketOfHash(uint64_t state, uint64_t hash0) {
+  const unsigned level = StateLevel(state);
+  uint64_t bucket = hash0 & ((uint64_t{1} << level) - 1);
+  if (bucket < StateSplit(state)) {
+    bucket = hash0 & ((uint64_t{2} << level) - 1);
+  }
+  return bucket;
+}
+
+// Returns the number of buckets in segment
+static inline uint64_t SegmentNumBuckets(size_t segment) {
+  return (segment == 0) ? (uint64_t{1} << kMinLevel)
+                        : (uint64_t{1} << (kMinLevel + segment - 1));
+}
+
+static inline void SegmentOfBucket(uint64_t bucket, size_t* segment,
+                                   uint64_t* offset) {
+  if (bucket < (uint64_t{1} << kMinLevel)) {
+    *segment = 0;
+    *offset = bucket;
+    return;
+  }
+  const size_t msb = 63 - hwy::Num0BitsAboveMS1Bit_Nonzero64(bucket);
+  *segment = msb - kMinLevel + 1;
+  *offset = bucket - (uint64_t{1} << msb);
+}
+
+enum class ChainScanStatus { kNotFound, kFound, kCorrupt };
+
+struct ChainScan {
+  ChainScanStatus status;
+  // Entry whose hash matches, if status is kFound
+  uint8_t* entry;
+  // First page of the chain with room for another entry, or nullptr
+  uint8_t* free_page;
+  // Last page of the chain
+  uint8_t* last_page;
+};
+
+}  // namespace
+}  // namespace simdhwyhash
+
+struct SimdHwyHashIndex {
+  int fd = -1;
+  unsigned flags = 0;
+  uint8_t* base = nullptr;
+  size_t reserved_bytes = 0;
+  size_t system_page_size = 0;
+
+  // Size of the file, which is only tracked by the writer
+  size_t file_bytes = 0;
+
+  // Serializes the extensions of the mapping of a handle, which are done by
+  // both the writer and readers that find pages past the end of the mapping
+  mutable std::mutex map_mutex;
+  mutable std::atomic<size_t> mapped_bytes{0};
+};
+
+namespace simdhwyhash {
+namespace {
+
+static inline uint8_t* IndexHeader(const SimdHwyHashIndex* index) {
+  return index->base;
+}
+
+static inline uint8_t* PageAt(const SimdHwyHashIndex* index,
+                              uint64_t page_num) {
+  return index->base + static_cast<size_t>(page_num) * kIndexPageSize;
+}
+
+static inline uint64_t IndexNumPages(const SimdHwyHashIndex* index) {
+  return AtomicU64At(IndexHeader(index) + kHeaderNumPagesOffset)
+      .load(std::memory_order_acquire);
+}
+
+// Maps the part of the file that is not mapped yet. Must be called with
+// index->map_mutex held.
+static bool MapNewFileBytes(const SimdHwyHashIndex* index) {
+  struct stat st;
+  if (fstat(index->fd, &st) != 0 || st.st_size < 0) {
+    return false;
+  }
+
+  const uint64_t file_bytes = static_cast<uint64_t>(st.st_size) &
+                              ~uint64_t{index->system_page_size - 1};
+  const size_t mapped_bytes =
+      index->mapped_bytes.load(std::memory_order_relaxed);
+  if (file_bytes <= mapped_bytes) {
+    return true;
+  }
+  if (file_bytes > index->reserved_bytes) {
+    return false;
+  }
+
+  const int prot = (index->flags & SIMDHWYHASH_INDEX_READ_ONLY)
+                       ? PROT_READ
+                       : (PROT_READ | PROT_WRITE);
+  void* ptr = mmap(index->base + mapped_bytes,
+                   static_cast<size_t>(file_bytes) - mapped_bytes, prot,
+                   MAP_SHARED | MAP_FIXED, index->fd,
+                   static_cast<off_t>(mapped_bytes));
+  if (ptr == MAP_FAILED) {
+    return false;
+  }
+  index->mapped_bytes.store(static_cast<size_t>(file_bytes),
+                            std::memory_order_release);
+  return true;
+}
+
+// Returns true if the first num_pages pages of the file are mapped, mapping
+// them first if needed
+static bool EnsureMapped(const SimdHwyHashIndex* index, uint64_t num_pages) {
+  if (num_pages > index->reserved_bytes / kIndexPageSize) {
+    return false;
+  }
+  const size_t needed_bytes = static_cast<size_t>(num_pages) * kIndexPageSize;
+  if (needed_bytes <= index->mapped_bytes.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(index->map_mutex);
+  return MapNewFileBytes(index) &&
+         needed_bytes <= index->mapped_bytes.load(std::memory_order_relaxed);
+}
+
+// Writes the pages from first_page to first_page + num_pages - 1 to the file
+static bool SyncPages(const SimdHwyHashIndex* index, uint64_t first_page,
+                      uint64_t num_pages) {
+  // msync requires an address that is aligned to the system page size
+  const size_t begin = static_cast<size_t>(first_page) * kIndexPageSize;
+  const size_t aligned_begin = begin & ~(index->system_page_size - 1);
+  const size_t end =
+      static_cast<size_t>(first_page + num_pages) * kIndexPageSize;
+  return msync(index->base + aligned_begin, end - aligned_begin, MS_SYNC) == 0;
+}
+
+static bool SyncPageIfDurable(const SimdHwyHashIndex* index,
+                              const uint8_t* page) {
+  if ((index->flags & SIMDHWYHASH_INDEX_DURABLE) == 0) {
+    return true;
+  }
+  return SyncPages(
+      index, static_cast<uint64_t>(page - index->base) / kIndexPageSize, 1);
+}
+
+// Returns the first page of bucket, or 0 if its segment has not been allocated
+static uint64_t BucketFirstPage(const SimdHwyHashIndex* index,
+                                uint64_t bucket) {
+  size_t segment;
+  uint64_t offset;
+  SegmentOfBucket(bucket, &segment, &offset);
+  if (segment >= kNumSegments) {
+    return 0;
+  }
+  const uint64_t segment_first_page =
+      AtomicU64At(IndexHeader(index) + kHeaderSegmentsOffset + segment * 8)
+          .load(std::memory_order_acquire);
+  return (segment_first_page != 0) ? segment_first_page + offset : 0;
+}
+
+// Returns page page_num, or nullptr if it is out of range. num_pages is the
+// number of pages that the caller last loaded from the header.
+static uint8_t* CheckedPage(const SimdHwyHashIndex* index, uint64_t page_num,
+                            uint64_t& num_pages) {
+  if (page_num >= num_pages) {
+    // The page may have been allocated after num_pages was loaded
+    num_pages = IndexNumPages(index);
+    if (page_num >= num_pages) {
+      return nullptr;
+    }
+  }
+  return EnsureMapped(index, page_num + 1) ? PageAt(index, page_num) : nullptr;
+}
+
+// Looks up hash in the chain of pages that starts at first_page
+static ChainScan ScanChain(const SimdHwyHashIndex* index, uint64_t first_page,
+                           const uint64_t* hash) {
+  ChainScan scan{ChainScanStatus::kNotFound, nullptr, nullptr, nullptr};
+  const uint8_t tag = TagOfHash(hash);
+
+  // A chain never has more pages than the file, so a longer chain is a cycle
+  uint64_t num_pages = IndexNumPages(index);
+  uint64_t page_num = first_page;
+  for (uint64_t chain_len = 0; page_num != 0; chain_len++) {
+    uint8_t* page = CheckedPage(index, page_num, num_pages);
+    if (!page || chain_len >= num_pages) {
+      scan.status = ChainScanStatus::kCorrupt;
+      return scan;
+    }
+
+    uint32_t count = AtomicU32At(page + kPageCountOffset)
+                         .load(std::memory_order_acquire);
+    count = HWY_MIN(count, static_cast<uint32_t>(kEntriesPerPage));
+
+    uint8_t match_bits[kMatchBitsSize] = {0};
+    HWY_DYNAMIC_DISPATCH(MatchTags)
+    (page + kPageTagsOffset, count, tag, match_bits);
+    for (size_t w = 0; w * 64 < count; w++) {
+      for (uint64_t bits = LoadLE64(match_bits + w * 8); bits != 0;
+           bits &= bits - 1) {
+        const size_t slot = w * 64 + hwy::Num0BitsBelowLS1Bit_Nonzero64(bits);
+        uint8_t* entry = page + kPageEntriesOffset + slot * kEntrySize;
+        if (AtomicU64At(entry).load(std::memory_order_relaxed) == hash[0] &&
+            AtomicU64At(entry + 8).load(std::memory_order_relaxed) ==
+                hash[1]) {
+          scan.status = ChainScanStatus::kFound;
+          scan.entry = entry;
+          return scan;
+        }
+      }
+    }
+
+    if (!scan.free_page && count < kEntriesPerPage) {
+      scan.free_page = page;
+    }
+    scan.last_page = page;
+    page_num = AtomicU64At(page + kPageOverflowOffset)
+                   .load(std::memory_order_acquire);
+  }
+  return scan;
+}
+
+static void ResetPage(uint8_t* page) {
+  AtomicU32At(page).store(0, std::memory_order_relaxed);
+  AtomicU32At(page + kPageCountOffset).store(0, std::memory_order_relaxed);
+  AtomicU64At(page + kPageOverflowOffset).store(0, std::memory_order_relaxed);
+}
+
+// Writes an entry to slot of page without publishing it. Readers may load the
+// tag of slot before it is published, as MatchTags loads whole vectors of
+// tags, but they ignore the tags past the entry count of the page. The first
+// word of the hash is written last, so that a slot whose first word has been
+// written by a compaction that was interrupted by a crash is complete.
+static void WriteEntry(uint8_t* page, size_t slot, uint64_t hash0,
+                       uint64_t hash1, uint64_t location) {
+  uint8_t* entry = page + kPageEntriesOffset + slot * kEntrySize;
+  AtomicU64At(entry + 8).store(hash1, std::memory_order_relaxed);
+  AtomicU64At(entry + 16).store(location, std::memory_order_relaxed);
+  page[kPageTagsOffset + slot] = static_cast<uint8_t>(hash1 >> 56);
+  AtomicU64At(entry).store(hash0, std::memory_order_release);
+}
+
+// Extends the file to hold at least num_pages pages and maps it
+static bool ExtendFile(SimdHwyHashIndex* index, uint64_t num_pages) {
+  if (num_pages > index->reserved_bytes / kIndexPageSize) {
+    return false;
+  }
+  const size_t needed_bytes = static_cast<size_t>(num_pages) * kIndexPageSize;
+  if (needed_bytes > index->file_bytes) {
+    const size_t new_file_bytes =
+        (needed_bytes + kFileGrowthBytes - 1) & ~(kFileGrowthBytes - 1);
+    if (ftruncate(index->fd, static_cast<off_t>(new_file_bytes)) != 0) {
+      return false;
+    }
+    index->file_bytes = new_file_bytes;
+  }
+  return EnsureMapped(index, num_pages);
+}
+
+// Allocates num_pages pages at the end of the file and returns the first of
+// them, or 0 if the file could not be extended
+static uint64_t AllocatePages(SimdHwyHashIndex* index, uint64_t num_pages) {
+  std::atomic<uint64_t>& header_num_pages =
+      AtomicU64At(IndexHeader(index) + kHeaderNumPagesOffset);
+  const uint64_t first_page = header_num_pages.load(std::memory_order_relaxed);
+  if (!ExtendFile(index, first_page + num_pages)) {
+    return 0;
+  }
+  header_num_pages.store(first_page + num_pages, std::memory_order_release);
+  return first_page;
+}
+
+// Allocates an overflow page that holds a single entry, and links it after
+// last_page once the entry has been written
+static bool AppendOverflowPage(SimdHwyHashIndex* index, uint8_t* last_page,
+                               uint64_t hash0, uint64_t hash1,
+                               uint64_t location) {
+  const uint64_t page_num = AllocatePages(index, 1);
+  if (page_num == 0) {
+    return false;
+  }
+
+  uint8_t* page = PageAt(index, page_num);
+  ResetPage(page);
+  WriteEntry(page, 0, hash0, hash1, location);
+  AtomicU32At(page + kPageCountOffset).store(1, std::memory_order_release);
+  if (!SyncPageIfDurable(index, page)) {
+    return false;
+  }
+  AtomicU64At(last_page + kPageOverflowOffset)
+      .store(page_num, std::memory_order_release);
+  return true;
+}
+
+// Writes the pages of the chain that starts at head to the file
+static bool SyncChain(const SimdHwyHashIndex* index, uint8_t* head) {
+  uint64_t num_pages = IndexNumPages(index);
+  uint8_t* page = head;
+  for (uint64_t chain_len = 0; page && chain_len < num_pages; chain_len++) {
+    if (!SyncPages(index,
+                   static_cast<uint64_t>(page - index->base) / kIndexPageSize,
+                   1)) {
+      return false;
+    }
+    const uint64_t next_page_num = AtomicU64At(page + kPageOverflowOffset)
+                                       .load(std::memory_order_relaxed);
+    page = (next_page_num != 0) ? CheckedPage(index, next_page_num, num_pages)
+                                : nullptr;
+  }
+  return true;
+}
+
+// Returns true if one of the first num_entries entries of page has hash0 as
+// the first word of its hash
+static bool PageHasHash0(uint8_t* page, size_t num_entries, uint64_t hash0) {
+  for (size_t i = 0; i < num_entries; i++) {
+    if (AtomicU64At(page + kPageEntriesOffset + i * kEntrySize)
+            .load(std::memory_order_relaxed) == hash0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Removes the entries from the chain of bucket that no longer belong to it,
+// and unlinks the overflow pages that this empties. The entries that stay are
+// moved within their page, so that a torn write of the file can never lose an
+// entry that was in a page that was not written.
+//
+// A compaction that was interrupted by a crash can leave a second copy of an
+// entry that was moved in the same page, and can leave the slot that it was
+// moving an entry to partially written. If recovering is true, each entry
+// whose first hash word is the same as that of an earlier entry of its page is
+// removed, which removes both. The earliest entry is always complete, as
+// WriteEntry writes the first word last.
+static bool CompactBucket(SimdHwyHashIndex* index, uint64_t bucket,
+                          bool recovering) {
+  const bool durable = (index->flags & SIMDHWYHASH_INDEX_DURABLE) != 0;
+  const uint64_t state = AtomicU64At(IndexHeader(index) + kHeaderStateOffset)
+                             .load(std::memory_order_relaxed);
+  const uint64_t first_page = BucketFirstPage(index, bucket);
+  uint64_t num_pages = IndexNumPages(index);
+  uint8_t* head = CheckedPage(index, first_page, num_pages);
+  if (!head) {
+    return false;
+  }
+
+  // The version is odd while the bucket is rewritten. A version that is
+  // already odd was left by a compaction that was interrupted by a crash.
+  std::atomic<uint32_t>& version = AtomicU32At(head);
+  const uint32_t odd_version = version.load(std::memory_order_relaxed) | 1u;
+  version.store(odd_version, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  bool valid = true;
+  uint8_t* prev = nullptr;
+  uint8_t* page = head;
+  for (uint64_t chain_len = 0; page; chain_len++) {
+    std::atomic<uint32_t>& count = AtomicU32At(page + kPageCountOffset);
+    const size_t num_entries = HWY_MIN(count.load(std::memory_order_relaxed),
+                                       static_cast<uint32_t>(kEntriesPerPage));
+    size_t num_kept = 0;
+    bool moved = false;
+    for (size_t i = 0; i < num_entries; i++) {
+      uint8_t* entry = page + kPageEntriesOffset + i * kEntrySize;
+      const uint64_t hash0 = AtomicU64At(entry).load(std::memory_order_relaxed);
+      if (BucketOfHash(state, hash0) != bucket ||
+          (recovering && PageHasHash0(page, num_kept, hash0))) {
+        continue;
+      }
+      if (num_kept != i) {
+        WriteEntry(page, num_kept, hash0,
+                   AtomicU64At(entry + 8).load(std::memory_order_relaxed),
+                   AtomicU64At(entry + 16).load(std::memory_order_relaxed));
+        moved = true;
+      }
+      num_kept++;
+    }
+
+    // The entries that were moved have to reach the file before the count
+    // that drops their old slots
+    if (moved && !SyncPageIfDurable(index, page)) {
+      valid = false;
+      break;
+    }
+    count.store(static_cast<uint32_t>(num_kept), std::memory_order_relaxed);
+
+    std::atomic<uint64_t>& overflow = AtomicU64At(page + kPageOverflowOffset);
+    const uint64_t next_page_num = overflow.load(std::memory_order_relaxed);
+    if (num_kept == 0 && prev) {
+      // The space of the unlinked page is not reused, as a stale reader may
+      // still be scanning it
+      AtomicU64At(prev + kPageOverflowOffset)
+          .store(next_page_num, std::memory_order_relaxed);
+    } else {
+      prev = page;
+    }
+
+    page = nullptr;
+    if (next_page_num != 0) {
+      page = CheckedPage(index, next_page_num, num_pages);
+      if (!page || chain_len >= num_pages) {
+        // Cut off the chain at the page that is out of range
+        AtomicU64At(prev + kPageOverflowOffset)
+            .store(0, std::memory_order_relaxed);
+        valid = false;
+        page = nullptr;
+      }
+    }
+  }
+
+  // The counts and links are written before the bucket is used again
+  if (durable && !SyncChain(index, head)) {
+    valid = false;
+  }
+  version.store(odd_version + 1, std::memory_order_release);
+  return valid;
+}
+
+// Splits the next bucket of the linear hashing scheme
+static bool SplitBucket(SimdHwyHashIndex* index) {
+  uint8_t* header = IndexHeader(index);
+  std::atomic<uint64_t>& header_state =
+      AtomicU64At(header + kHeaderStateOffset);
+  const uint64_t state = header_state.load(std::memory_order_relaxed);
+  const unsigned level = StateLevel(state);
+  const uint64_t split = StateSplit(state);
+  if (level >= kMaxLevel) {
+    return false;
+  }
+
+  const uint64_t new_bucket = split + (uint64_t{1} << level);
+  size_t segment;
+  uint64_t offset;
+  SegmentOfBucket(new_bucket, &segment, &offset);
+  std::atomic<uint64_t>& segment_first_page =
+      AtomicU64At(header + kHeaderSegmentsOffset + segment * 8);
+  if (segment_first_page.load(std::memory_order_relaxed) == 0) {
+    const uint64_t first_page =
+        AllocatePages(index, SegmentNumBuckets(segment));
+    if (first_page == 0) {
+      return false;
+    }
+    segment_first_page.store(first_page, std::memory_order_release);
+  }
+
+  // The new bucket may hold a partial copy from a split that was interrupted
+  // by a crash, so it is always reset first
+  uint64_t num_pages = IndexNumPages(index);
+  uint8_t* new_head = PageAt(index, BucketFirstPage(index, new_bucket));
+  ResetPage(new_head);
+
+  // Copy the entries that move to the new bucket, which is not visible to
+  // readers until the state is updated
+  const uint64_t old_first_page = BucketFirstPage(index, split);
+  uint8_t* new_tail = new_head;
+  uint8_t* page = CheckedPage(index, old_first_page, num_pages);
+  for (uint64_t chain_len = 0; page; chain_len++) {
+    if (chain_len >= num_pages) {
+      return false;
+    }
+
+    const size_t num_entries =
+        HWY_MIN(AtomicU32At(page + kPageCountOffset)
+                    .load(std::memory_order_relaxed),
+                static_cast<uint32_t>(kEntriesPerPage));
+    for (size_t i = 0; i < num_entries; i++) {
+      uint8_t* entry = page + kPageEntriesOffset + i * kEntrySize;
+      const uint64_t hash0 = AtomicU64At(entry).load(std::memory_order_relaxed);
+      if (((hash0 >> level) & 1) == 0) {
+        continue;
+      }
+
+      const uint64_t hash1 =
+          AtomicU64At(entry + 8).load(std::memory_order_relaxed);
+      const uint64_t location =
+          AtomicU64At(entry + 16).load(std::memory_order_relaxed);
+      std::atomic<uint32_t>& tail_count =
+          AtomicU32At(new_tail + kPageCountOffset);
+      const uint32_t slot = tail_count.load(std::memory_order_relaxed);
+      if (slot < kEntriesPerPage) {
+        WriteEntry(new_tail, slot, hash0, hash1, location);
+        tail_count.store(slot + 1, std::memory_order_relaxed);
+      } else {
+        uint8_t* prev_tail = new_tail;
+        if (!AppendOverflowPage(index, prev_tail, hash0, hash1, location) ||
+            !SyncPageIfDurable(index, prev_tail)) {
+          return false;
+        }
+        new_tail = PageAt(index, AtomicU64At(prev_tail + kPageOverflowOffset)
+                                     .load(std::memory_order_relaxed));
+      }
+    }
+
+    const uint64_t next_page_num = AtomicU64At(page + kPageOverflowOffset)
+                                       .load(std::memory_order_relaxed);
+    page = nullptr;
+    if (next_page_num != 0) {
+      page = CheckedPage(index, next_page_num, num_pages);
+      if (!page) {
+        return false;
+      }
+    }
+  }
+  if (!SyncPageIfDurable(index, new_tail)) {
+    return false;
+  }
+
+  // Publish the new bucket, and make the state durable before the entries are
+  // removed from the old bucket
+  const uint64_t new_state = (new_bucket + 1 == (uint64_t{2} << level))
+                                 ? MakeState(level + 1, 0)
+                                 : MakeState(level, split + 1);
+  header_state.store(new_state, std::memory_order_release);
+  if ((index->flags & SIMDHWYHASH_INDEX_DURABLE) != 0 &&
+      !SyncPages(index, 0, 1)) {
+    return false;
+  }
+
+  return CompactBucket(index, split, false);
+}
+
+// Finishes the last split, which may have been interrupted before the entries
+// that moved were removed from the bucket that was split, and recounts the
+// entries. Called by the writer when the index was not closed cleanly.
+static bool RecoverIndex(SimdHwyHashIndex* index) {
+  uint8_t* header = IndexHeader(index);
+  const uint64_t state = AtomicU64At(header + kHeaderStateOffset)
+                             .load(std::memory_order_relaxed);
+  const unsigned level = StateLevel(state);
+  const uint64_t split = StateSplit(state);
+  if (split != 0) {
+    CompactBucket(index, split - 1, true);
+  } else if (level > kMinLevel) {
+    CompactBucket(index, (uint64_t{1} << (level - 1)) - 1, true);
+  }
+
+  uint64_t num_entries = 0;
+  uint64_t num_pages = IndexNumPages(index);
+  const uint64_t num_buckets = StateNumBuckets(state);
+  for (uint64_t bucket = 0; bucket < num_buckets; bucket++) {
+    uint8_t* page = CheckedPage(index, BucketFirstPage(index, bucket),
+                                num_pages);
+    for (uint64_t chain_len = 0; page; chain_len++) {
+      if (chain_len >= num_pages) {
+        return false;
+      }
+      num_entries += HWY_MIN(AtomicU32At(page + kPageCountOffset)
+                                 .load(std::memory_order_relaxed),
+                             static_cast<uint32_t>(kEntriesPerPage));
+      const uint64_t next_page_num = AtomicU64At(page + kPageOverflowOffset)
+                                         .load(std::memory_order_relaxed);
+      page = (next_page_num != 0)
+                 ? CheckedPage(index, next_page_num, num_pages)
+                 : nullptr;
+    }
+  }
+  AtomicU64At(header + kHeaderNumEntriesOffset)
+      .store(num_entries, std::memory_order_relaxed);
+  return true;
+}
+
+// Writes the header of a new index to the empty file of index
+static bool InitIndexFile(SimdHwyHashIndex* index) {
+  const uint64_t num_pages = 1 + (uint64_t{1} << kMinLevel);
+  if (!ExtendFile(index, num_pages)) {
+    return false;
+  }
+
+  uint8_t* header = IndexHeader(index);
+  AtomicU64At(header + 8).store(kIndexPageSize, std::memory_order_relaxed);
+  AtomicU64At(header + kHeaderStateOffset)
+      .store(MakeState(kMinLevel, 0), std::memory_order_relaxed);
+  AtomicU64At(header + kHeaderNumPagesOffset)
+      .store(num_pages, std::memory_order_relaxed);
+  AtomicU64At(header + kHeaderSegmentsOffset)
+      .store(1, std::memory_order_relaxed);
+
+  // Readers check the magic number first, so it is written last
+  AtomicU64At(header).store(kIndexMagicAndVersion, std::memory_order_release);
+  return (index->flags & SIMDHWYHASH_INDEX_DURABLE) == 0 ||
+         SyncPages(index, 0, num_pages);
+}
+
+// Returns true if the header of index is valid
+static bool ValidateIndexHeader(const SimdHwyHashIndex* index) {
+  uint8_t* header = IndexHeader(index);
+  if (AtomicU64At(header).load(std::memory_order_acquire) !=
+          kIndexMagicAndVersion ||
+      AtomicU64At(header + 8).load(std::memory_order_relaxed) !=
+          kIndexPageSize) {
+    return false;
+  }
+
+  const uint64_t state = AtomicU64At(header + kHeaderStateOffset)
+                             .load(std::memory_order_relaxed);
+  const unsigned level = StateLevel(state);
+  return level >= kMinLevel && level <= kMaxLevel &&
+         StateSplit(state) < (uint64_t{1} << level) &&
+         BucketFirstPage(index, 0) == 1;
+}
+
+static bool ReserveAddressSpace(SimdHwyHashIndex* index) {
+  int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+  map_flags |= MAP_NORESERVE;
+#endif
+  for (size_t reserved_bytes = kMaxMappedBytes;
+       reserved_bytes >= kMinMappedBytes; reserved_bytes >>= 1) {
+    void* base = mmap(nullptr, reserved_bytes, PROT_NONE, map_flags, -1, 0);
+    if (base != MAP_FAILED) {
+      index->base = static_cast<uint8_t*>(base);
+      index->reserved_bytes = reserved_bytes;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void DestroyIndex(SimdHwyHashIndex* index) {
+  if (index->base) {
+    munmap(index->base, index->reserved_bytes);
+  }
+  if (index->fd >= 0) {
+    close(index->fd);
+  }
+  delete index;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+SimdHwyHashIndex* SimdHwyHash_IndexOpen(const char* path, unsigned flags) {
+  using namespace simdhwyhash;
+
+  SimdHwyHashIndex* index = new (std::nothrow) SimdHwyHashIndex;
+  if (!index) {
+    return nullptr;
+  }
+  index->flags = flags;
+  index->system_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  const bool read_only = (flags & SIMDHWYHASH_INDEX_READ_ONLY) != 0;
+  index->fd =
+      open(path, (read_only ? O_RDONLY : (O_RDWR | O_CREAT)) | O_CLOEXEC, 0644);
+  // The exclusive lock makes sure that there is only a single writer
+  if (index->fd < 0 ||
+      (!read_only && flock(index->fd, LOCK_EX | LOCK_NB) != 0)) {
+    DestroyIndex(index);
+    return nullptr;
+  }
+
+  if (!ReserveAddressSpace(index)) {
+    DestroyIndex(index);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(index->fd, &st) != 0) {
+    DestroyIndex(index);
+    return nullptr;
+  }
+  index->file_bytes = static_cast<size_t>(st.st_size);
+
+  bool valid;
+  if (st.st_size == 0 && !read_only) {
+    valid = InitIndexFile(index);
+  } else {
+    valid = EnsureMapped(index, 1) && ValidateIndexHeader(index);
+  }
+  if (valid && !read_only) {
+    std::atomic<uint64_t>& clean =
+        AtomicU64At(IndexHeader(index) + kHeaderCleanOffset);
+    if (clean.load(std::memory_order_relaxed) == 0) {
+      valid = RecoverIndex(index);
+    }
+    clean.store(0, std::memory_order_relaxed);
+  }
+  if (!valid) {
+    DestroyIndex(index);
+    return nullptr;
+  }
+  return index;
+}
+
+int SimdHwyHash_IndexClose(SimdHwyHashIndex* index) {
+  using namespace simdhwyhash;
+
+  if (!index) {
+    return 1;
+  }
+
+  int ok = 1;
+  if ((index->flags & SIMDHWYHASH_INDEX_READ_ONLY) == 0) {
+    ok = SimdHwyHash_IndexSync(index);
+    if (ok) {
+      AtomicU64At(IndexHeader(index) + kHeaderCleanOffset)
+          .store(1, std::memory_order_relaxed);
+      ok = SyncPages(index, 0, 1) ? 1 : 0;
+    }
+  }
+  DestroyIndex(index);
+  return ok;
+}
+
+int SimdHwyHash_IndexInsert(SimdHwyHashIndex* SIMDHWYHASH_RESTRICT index,
+                            const uint64_t* SIMDHWYHASH_RESTRICT hash,
+                            uint64_t location) {
+  using namespace simdhwyhash;
+
+  if ((index->flags & SIMDHWYHASH_INDEX_READ_ONLY) != 0) {
+    return -1;
+  }
+
+  uint8_t* header = IndexHeader(index);
+  const uint64_t state = AtomicU64At(header + kHeaderStateOffset)
+                             .load(std::memory_order_relaxed);
+  const uint64_t first_page =
+      BucketFirstPage(index, BucketOfHash(state, hash[0]));
+  const ChainScan scan = ScanChain(index, first_page, hash);
+  if (scan.status == ChainScanStatus::kCorrupt) {
+    return -1;
+  }
+  if (scan.status == ChainScanStatus::kFound) {
+    return 0;
+  }
+
+  if (scan.free_page) {
+    std::atomic<uint32_t>& count =
+        AtomicU32At(scan.free_page + kPageCountOffset);
+    const uint32_t slot = count.load(std::memory_order_relaxed);
+    WriteEntry(scan.free_page, slot, hash[0], hash[1], location);
+    count.store(slot + 1, std::memory_order_release);
+  } else if (!AppendOverflowPage(index, scan.last_page, hash[0], hash[1],
+                                 location)) {
+    return -1;
+  }
+
+  std::atomic<uint64_t>& num_entries =
+      AtomicU64At(header + kHeaderNumEntriesOffset);
+  const uint64_t new_num_entries =
+      num_entries.load(std::memory_order_relaxed) + 1;
+  num_entries.store(new_num_entries, std::memory_order_relaxed);
+
+  // A split that fails leaves the index valid, with longer chains
+  if (new_num_entries > StateNumBuckets(state) * kTargetEntriesPerBucket) {
+    SplitBucket(index);
+  }
+  return 1;
+}
+
+int SimdHwyHash_IndexFind(const SimdHwyHashIndex* SIMDHWYHASH_RESTRICT index,
+                          const uint64_t* SIMDHWYHASH_RESTRICT hash,
+                          uint64_t* SIMDHWYHASH_RESTRICT location) {
+  using namespace simdhwyhash;
+
+  std::atomic<uint64_t>& header_state =
+      AtomicU64At(IndexHeader(index) + kHeaderStateOffset);
+  for (int attempt = 0; attempt < kMaxFindAttempts; attempt++) {
+    const uint64_t state = header_state.load(std::memory_order_acquire);
+    const uint64_t first_page =
+        BucketFirstPage(index, BucketOfHash(state, hash[0]));
+    if (first_page == 0 || !EnsureMapped(index, first_page + 1)) {
+      return -1;
+    }
+
+    std::atomic<uint32_t>& version = AtomicU32At(PageAt(index, first_page));
+    const uint32_t start_version = version.load(std::memory_order_acquire);
+    if ((start_version & 1) == 0) {
+      const ChainScan scan = ScanChain(index, first_page, hash);
+      const uint64_t found_location =
+          scan.entry ? AtomicU64At(scan.entry + 16)
+                           .load(std::memory_order_relaxed)
+                     : 0;
+
+      // The result is only used if the bucket was not rewritten or split
+      // while it was scanned
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (version.load(std::memory_order_relaxed) == start_version &&
+          header_state.load(std::memory_order_relaxed) == state) {
+        if (scan.status == ChainScanStatus::kCorrupt) {
+          return -1;
+        }
+        if (scan.status == ChainScanStatus::kNotFound) {
+          return 0;
+        }
+        *location = found_location;
+        return 1;
+      }
+    }
+    std::this_thread::yield();
+  }
+  return -1;
+}
+
+uint64_t SimdHwyHash_IndexCount(const SimdHwyHashIndex* index) {
+  using namespace simdhwyhash;
+  return AtomicU64At(IndexHeader(index) + kHeaderNumEntriesOffset)
+      .load(std::memory_order_relaxed);
+}
+
+int SimdHwyHash_IndexSync(SimdHwyHashIndex* index) {
+  if ((index->flags & SIMDHWYHASH_INDEX_READ_ONLY) != 0) {
+    return 1;
+  }
+  return (msync(index->base, index->file_bytes, MS_SYNC) == 0) ? 1 : 0;
+}
+
+}  // extern "C"
+
+#else  // SIMDHWYHASH_INDEX_HAVE_MMAP
+
+// The index requires mmap and flock, so it cannot be opened on other systems
+
+extern "C" {
+
+SimdHwyHashIndex* SimdHwyHash_IndexOpen(const char*, unsigned) {
+  return nullptr;
+}
+
+int SimdHwyHash_IndexClose(SimdHwyHashIndex*) { return 1; }
+
+int SimdHwyHash_IndexInsert(SimdHwyHashIndex* SIMDHWYHASH_RESTRICT,
+                            const uint64_t* SIMDHWYHASH_RESTRICT, uint64_t) {
+  return -1;
+}
+
+int SimdHwyHash_IndexFind(const SimdHwyHashIndex* SIMDHWYHASH_RESTRICT,
+                          const uint64_t* SIMDHWYHASH_RESTRICT,
+                          uint64_t* SIMDHWYHASH_RESTRICT) {
+  return -1;
+}
+
+uint64_t SimdHwyHash_IndexCount(const SimdHwyHashIndex*) { return 0; }
+
+int SimdHwyHash_IndexSync(SimdHwyHashIndex*) { return 0; }
+
+}  // extern "C"
+
+#endif  // SIMDHWYHASH_INDEX_HAVE_MMAP
+#endif  // HWY_ONCE
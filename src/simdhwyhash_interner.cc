@@ -0,0 +1,509 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_interner.h"
+
+#include <string.h>
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// String interner.
+//
+// The bytes of each interned string are copied into arena chunks that are
+// never moved or freed before the interner is destroyed, so the pointers that
+// are returned by SimdHwyHash_InternerGet stay valid. The ID of a string is
+// its index in the order in which it was first interned, and the 64-bit
+// HighwayHash of each string is stored with its pointer and length so that it
+// never has to be recomputed when the index grows.
+//
+// The index is an open-addressing table with linear probing whose capacity is
+// a power of 2. Each slot is a 64-bit word that holds the ID of a string plus
+// 1 (or 0 if the slot is empty) in its lower 32 bits and the upper 32 bits of
+// the hash of the string in its upper 32 bits, which rejects most mismatches
+// without touching the strings. The first slot that is probed for a string is
+// given by the lower bits of its hash.
+//
+// A snapshot stores the same index together with the strings in a single
+// buffer, with all integers stored in little-endian order, so that it can be
+// queried directly from a memory-mapped file:
+//   bytes 0-7: kSnapshotMagicAndVersion
+//   bytes 8-15: number of strings
+//   bytes 16-47: HighwayHash key
+//   bytes 48-55: index capacity
+//   bytes 56-63: number of string bytes
+//   then: hash of each string
+//   then: offset of each string, followed by the number of string bytes
+//   then: index slots
+//   then: string bytes, in the order of the IDs
+
+namespace simdhwyhash {
+namespace {
+
+// "SHIN" followed by version 1 as a 32-bit integer
+static constexpr uint64_t kSnapshotMagicAndVersion = 0x000000014E494853u;
+static constexpr size_t kSnapshotHeaderSize = 64;
+
+static constexpr size_t kArenaChunkSize = size_t{1} << 20;
+
+static constexpr size_t kMinIndexCapacity = 64;
+
+// Number of strings that are hashed by each call to SimdHwyHash_Hash64Batch
+static constexpr size_t kInternBatchSize = 256;
+
+static constexpr uint64_t kMaxNumStrings = SIMDHWYHASH_INTERNER_INVALID_ID;
+
+// Points to the bytes of the empty string, which take no space in the arena
+static const uint8_t kEmptyStringBytes[1] = {0};
+
+struct InternedString {
+  uint64_t hash;
+  const uint8_t* ptr;
+  size_t byte_len;
+};
+
+static inline void StoreLE64(uint8_t* ptr, uint64_t val) {
+  for (size_t i = 0; i < 8; i++) {
+    ptr[i] = static_cast<uint8_t>(val >> (i * 8));
+  }
+}
+
+static inline uint64_t LoadLE64(const uint8_t* ptr) {
+  uint64_t val = 0;
+  for (size_t i = 0; i < 8; i++) {
+    val |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+  }
+  return val;
+}
+
+static inline uint64_t MakeIndexSlot(uint64_t hash, uint32_t id) {
+  return (hash & 0xFFFFFFFF00000000u) | (static_cast<uint64_t>(id) + 1);
+}
+
+// Returns true if slot may hold the string with the given hash
+static inline bool IndexSlotTagMatches(uint64_t slot, uint64_t hash) {
+  return ((slot ^ hash) >> 32) == 0;
+}
+
+// Returns the smallest power of 2 index capacity that keeps the index at most
+// 3/4 full with num_strings strings
+static size_t IndexCapacityFor(size_t num_strings) {
+  size_t capacity = kMinIndexCapacity;
+  while (capacity / 4 * 3 < num_strings) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+struct SimdHwyHashInterner {
+  uint64_t key[4];
+
+  std::vector<std::unique_ptr<uint8_t[]>> chunks;
+  uint8_t* chunk_pos = nullptr;
+  size_t chunk_remaining = 0;
+
+  std::vector<simdhwyhash::InternedString> strings;
+  uint64_t num_string_bytes = 0;
+
+  std::vector<uint64_t> index;
+};
+
+namespace simdhwyhash {
+namespace {
+
+// Returns the slot of interner->index that holds the string with the given
+// hash, or the empty slot at which it would be inserted
+static size_t FindIndexSlot(const SimdHwyHashInterner* interner,
+                            const uint8_t* ptr, size_t byte_len,
+                            uint64_t hash) {
+  const size_t mask = interner->index.size() - 1;
+  const uint64_t* index = interner->index.data();
+
+  size_t slot_idx = static_cast<size_t>(hash) & mask;
+  for (;;) {
+    const uint64_t slot = index[slot_idx];
+    if (slot == 0) {
+      return slot_idx;
+    }
+    if (IndexSlotTagMatches(slot, hash)) {
+      const InternedString& str =
+          interner->strings[static_cast<uint32_t>(slot) - 1];
+      if (str.hash == hash && str.byte_len == byte_len &&
+          (byte_len == 0 || memcmp(str.ptr, ptr, byte_len) == 0)) {
+        return slot_idx;
+      }
+    }
+    slot_idx = (slot_idx + 1) & mask;
+  }
+}
+
+// Doubles the capacity of the index and reinserts the strings using their
+// stored hashes
+static void GrowIndex(SimdHwyHashInterner* interner) {
+  std::vector<uint64_t> new_index(interner->index.size() * 2, 0);
+  const size_t mask = new_index.size() - 1;
+  for (uint64_t slot : interner->index) {
+    if (slot != 0) {
+      const uint64_t hash =
+          interner->strings[static_cast<uint32_t>(slot) - 1].hash;
+      size_t slot_idx = static_cast<size_t>(hash) & mask;
+      while (new_index[slot_idx] != 0) {
+        slot_idx = (slot_idx + 1) & mask;
+      }
+      new_index[slot_idx] = slot;
+    }
+  }
+  interner->index.swap(new_index);
+}
+
+// Copies byte_len bytes from ptr into the arena of interner and returns the
+// address of the copy
+static const uint8_t* CopyToArena(SimdHwyHashInterner* interner,
+                                  const uint8_t* ptr, size_t byte_len) {
+  if (byte_len == 0) {
+    return kEmptyStringBytes;
+  }
+
+  if (byte_len > interner->chunk_remaining) {
+    // Strings that are at least as long as a chunk get a chunk of their own,
+    // which leaves the rest of the current chunk to the strings that follow
+    const size_t chunk_size =
+        (byte_len > kArenaChunkSize) ? byte_len : kArenaChunkSize;
+    std::unique_ptr<uint8_t[]> chunk(new uint8_t[chunk_size]);
+    interner->chunks.push_back(std::move(chunk));
+    if (chunk_size != byte_len) {
+      interner->chunk_pos = interner->chunks.back().get();
+      interner->chunk_remaining = chunk_size;
+    } else {
+      uint8_t* copy = interner->chunks.back().get();
+      memcpy(copy, ptr, byte_len);
+      return copy;
+    }
+  }
+
+  uint8_t* copy = interner->chunk_pos;
+  memcpy(copy, ptr, byte_len);
+  interner->chunk_pos += byte_len;
+  interner->chunk_remaining -= byte_len;
+  return copy;
+}
+
+// Interns the byte_len bytes at ptr, whose 64-bit hash is hash. Throws
+// std::bad_alloc if memory could not be allocated.
+static uint32_t InternHashed(SimdHwyHashInterner* interner, const uint8_t* ptr,
+                             size_t byte_len, uint64_t hash) {
+  size_t slot_idx = FindIndexSlot(interner, ptr, byte_len, hash);
+  const uint64_t slot = interner->index[slot_idx];
+  if (slot != 0) {
+    return static_cast<uint32_t>(slot) - 1;
+  }
+
+  if (interner->strings.size() >= kMaxNumStrings) {
+    return SIMDHWYHASH_INTERNER_INVALID_ID;
+  }
+
+  if ((interner->strings.size() + 1) > interner->index.size() / 4 * 3) {
+    GrowIndex(interner);
+    slot_idx = FindIndexSlot(interner, ptr, byte_len, hash);
+  }
+
+  // Grow the strings before the copy so that the push_back below cannot
+  // throw after the arena has been modified
+  const uint32_t id = static_cast<uint32_t>(interner->strings.size());
+  if (interner->strings.size() == interner->strings.capacity()) {
+    interner->strings.reserve(
+        (id < kMinIndexCapacity) ? kMinIndexCapacity : size_t{id} * 2);
+  }
+  const uint8_t* copy = CopyToArena(interner, ptr, byte_len);
+  interner->strings.push_back(InternedString{hash, copy, byte_len});
+  interner->num_string_bytes += byte_len;
+  interner->index[slot_idx] = MakeIndexSlot(hash, id);
+  return id;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+SimdHwyHashInterner* SimdHwyHash_InternerCreate(
+    const uint64_t* SIMDHWYHASH_RESTRICT key, size_t expected_num_strings) {
+  using namespace simdhwyhash;
+
+  SimdHwyHashInterner* interner = new (std::nothrow) SimdHwyHashInterner;
+  if (!interner) {
+    return nullptr;
+  }
+
+  memcpy(interner->key, key, sizeof(interner->key));
+  try {
+    if (expected_num_strings > kMaxNumStrings) {
+      expected_num_strings = static_cast<size_t>(kMaxNumStrings);
+    }
+    interner->strings.reserve(expected_num_strings);
+    interner->index.assign(IndexCapacityFor(expected_num_strings), 0);
+  } catch (const std::bad_alloc&) {
+    delete interner;
+    return nullptr;
+  }
+  return interner;
+}
+
+void SimdHwyHash_InternerDestroy(SimdHwyHashInterner* interner) {
+  delete interner;
+}
+
+uint32_t SimdHwyHash_Intern(SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+                            const void* SIMDHWYHASH_RESTRICT ptr,
+                            size_t byte_len) {
+  using namespace simdhwyhash;
+
+  const uint64_t hash = SimdHwyHash_Hash64(ptr, byte_len, interner->key);
+  try {
+    return InternHashed(interner, static_cast<const uint8_t*>(ptr), byte_len,
+                        hash);
+  } catch (const std::bad_alloc&) {
+    return SIMDHWYHASH_INTERNER_INVALID_ID;
+  }
+}
+
+int SimdHwyHash_InternBatch(SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+                            const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                            const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                            size_t num_strings,
+                            uint32_t* SIMDHWYHASH_RESTRICT ids) {
+  using namespace simdhwyhash;
+
+  uint64_t hashes[kInternBatchSize];
+  try {
+    for (size_t i = 0; i < num_strings; i += kInternBatchSize) {
+      const size_t remaining = num_strings - i;
+      const size_t n =
+          (remaining < kInternBatchSize) ? remaining : kInternBatchSize;
+      SimdHwyHash_Hash64Batch(ptrs + i, byte_lens + i, n, interner->key,
+                              hashes);
+      for (size_t j = 0; j < n; j++) {
+        ids[i + j] = InternHashed(interner,
+                                  static_cast<const uint8_t*>(ptrs[i + j]),
+                                  byte_lens[i + j], hashes[j]);
+        if (ids[i + j] == SIMDHWYHASH_INTERNER_INVALID_ID) {
+          return 0;
+        }
+      }
+    }
+  } catch (const std::bad_alloc&) {
+    return 0;
+  }
+  return 1;
+}
+
+uint32_t SimdHwyHash_InternerFind(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
+  using namespace simdhwyhash;
+
+  const uint64_t hash = SimdHwyHash_Hash64(ptr, byte_len, interner->key);
+  const size_t slot_idx = FindIndexSlot(
+      interner, static_cast<const uint8_t*>(ptr), byte_len, hash);
+  const uint64_t slot = interner->index[slot_idx];
+  return (slot != 0) ? static_cast<uint32_t>(slot) - 1
+                     : SIMDHWYHASH_INTERNER_INVALID_ID;
+}
+
+const void* SimdHwyHash_InternerGet(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner, uint32_t id,
+    size_t* SIMDHWYHASH_RESTRICT byte_len) {
+  if (id >= interner->strings.size()) {
+    return nullptr;
+  }
+  *byte_len = interner->strings[id].byte_len;
+  return interner->strings[id].ptr;
+}
+
+size_t SimdHwyHash_InternerCount(const SimdHwyHashInterner* interner) {
+  return interner->strings.size();
+}
+
+size_t SimdHwyHash_InternerSnapshotSize(const SimdHwyHashInterner* interner) {
+  using namespace simdhwyhash;
+
+  const size_t num_strings = interner->strings.size();
+  return kSnapshotHeaderSize +
+         (num_strings * 2 + 1 + interner->index.size()) * sizeof(uint64_t) +
+         static_cast<size_t>(interner->num_string_bytes);
+}
+
+size_t SimdHwyHash_InternerWriteSnapshot(
+    const SimdHwyHashInterner* SIMDHWYHASH_RESTRICT interner,
+    void* SIMDHWYHASH_RESTRICT buf, size_t buf_capacity) {
+  using namespace simdhwyhash;
+
+  const size_t size = SimdHwyHash_InternerSnapshotSize(interner);
+  if (buf_capacity < size) {
+    return 0;
+  }
+
+  const size_t num_strings = interner->strings.size();
+  uint8_t* out = static_cast<uint8_t*>(buf);
+  StoreLE64(out, kSnapshotMagicAndVersion);
+  StoreLE64(out + 8, num_strings);
+  for (size_t i = 0; i < 4; i++) {
+    StoreLE64(out + 16 + i * 8, interner->key[i]);
+  }
+  StoreLE64(out + 48, interner->index.size());
+  StoreLE64(out + 56, interner->num_string_bytes);
+  out += kSnapshotHeaderSize;
+
+  for (const InternedString& str : interner->strings) {
+    StoreLE64(out, str.hash);
+    out += 8;
+  }
+
+  uint64_t offset = 0;
+  for (const InternedString& str : interner->strings) {
+    StoreLE64(out, offset);
+    out += 8;
+    offset += str.byte_len;
+  }
+  StoreLE64(out, offset);
+  out += 8;
+
+  for (uint64_t slot : interner->index) {
+    StoreLE64(out, slot);
+    out += 8;
+  }
+
+  for (const InternedString& str : interner->strings) {
+    if (str.byte_len != 0) {
+      memcpy(out, str.ptr, str.byte_len);
+      out += str.byte_len;
+    }
+  }
+  return size;
+}
+
+int SimdHwyHash_InternerSnapshotLoad(
+    SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    const void* SIMDHWYHASH_RESTRICT data, size_t size) {
+  using namespace simdhwyhash;
+
+  memset(snapshot, 0, sizeof(SimdHwyHashInternerSnapshot));
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  if (size < kSnapshotHeaderSize ||
+      LoadLE64(bytes) != kSnapshotMagicAndVersion) {
+    return 0;
+  }
+
+  const uint64_t num_strings = LoadLE64(bytes + 8);
+  const uint64_t index_capacity = LoadLE64(bytes + 48);
+  const uint64_t num_string_bytes = LoadLE64(bytes + 56);
+
+  // Every count is bounded by size, so none of the sums below can overflow.
+  // The index must have at least one empty slot for lookups to terminate.
+  const uint64_t max_words = size / sizeof(uint64_t);
+  if (num_strings > max_words || index_capacity > max_words ||
+      num_string_bytes > size || num_strings >= index_capacity ||
+      (index_capacity & (index_capacity - 1)) != 0) {
+    return 0;
+  }
+  const uint64_t expected_size =
+      kSnapshotHeaderSize +
+      (num_strings * 2 + 1 + index_capacity) * sizeof(uint64_t) +
+      num_string_bytes;
+  if (size != expected_size) {
+    return 0;
+  }
+
+  const uint8_t* offsets = bytes + kSnapshotHeaderSize + num_strings * 8;
+  if (LoadLE64(offsets) != 0 ||
+      LoadLE64(offsets + num_strings * 8) != num_string_bytes) {
+    return 0;
+  }
+
+  snapshot->data = bytes;
+  snapshot->size = size;
+  for (size_t i = 0; i < 4; i++) {
+    snapshot->key[i] = LoadLE64(bytes + 16 + i * 8);
+  }
+  snapshot->num_strings = num_strings;
+  snapshot->index_capacity = index_capacity;
+  snapshot->num_string_bytes = num_string_bytes;
+  snapshot->hashes = bytes + kSnapshotHeaderSize;
+  snapshot->offsets = offsets;
+  snapshot->index = offsets + (num_strings + 1) * 8;
+  snapshot->string_bytes = snapshot->index + index_capacity * 8;
+  return 1;
+}
+
+const void* SimdHwyHash_InternerSnapshotGet(
+    const SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    uint32_t id, size_t* SIMDHWYHASH_RESTRICT byte_len) {
+  using namespace simdhwyhash;
+
+  if (id >= snapshot->num_strings) {
+    return nullptr;
+  }
+
+  // The offsets are only checked when they are used, so that loading a
+  // snapshot does not have to read all of it
+  const uint64_t begin = LoadLE64(snapshot->offsets + uint64_t{id} * 8);
+  const uint64_t end = LoadLE64(snapshot->offsets + uint64_t{id} * 8 + 8);
+  if (begin > end || end > snapshot->num_string_bytes) {
+    return nullptr;
+  }
+  *byte_len = static_cast<size_t>(end - begin);
+  return snapshot->string_bytes + begin;
+}
+
+uint32_t SimdHwyHash_InternerSnapshotFind(
+    const SimdHwyHashInternerSnapshot* SIMDHWYHASH_RESTRICT snapshot,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
+  using namespace simdhwyhash;
+
+  if (snapshot->index_capacity == 0) {
+    return SIMDHWYHASH_INTERNER_INVALID_ID;
+  }
+
+  const uint64_t hash = SimdHwyHash_Hash64(ptr, byte_len, snapshot->key);
+  const uint64_t mask = snapshot->index_capacity - 1;
+
+  // A corrupted snapshot may have no empty slots, so at most index_capacity
+  // slots are probed
+  uint64_t slot_idx = hash & mask;
+  for (uint64_t i = 0; i < snapshot->index_capacity; i++) {
+    const uint64_t slot = LoadLE64(snapshot->index + slot_idx * 8);
+    if (slot == 0) {
+      break;
+    }
+    if (IndexSlotTagMatches(slot, hash)) {
+      const uint32_t id = static_cast<uint32_t>(slot) - 1;
+      size_t str_len;
+      const void* str = SimdHwyHash_InternerSnapshotGet(snapshot, id, &str_len);
+      if (str && LoadLE64(snapshot->hashes + uint64_t{id} * 8) == hash &&
+          str_len == byte_len &&
+          (byte_len == 0 || memcmp(str, ptr, byte_len) == 0)) {
+        return id;
+      }
+    }
+    slot_idx = (slot_idx + 1) & mask;
+  }
+  return SIMDHWYHASH_INTERNER_INVALID_ID;
+}
+
+}  // extern "C"
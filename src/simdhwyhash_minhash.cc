@@ -0,0 +1,244 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_minhash.h"
+
+#include <stdlib.h>
+
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "simdhwyhash_minhash.cc"
+#include "hwy/foreach_target.h"
+#include "hwy/highway.h"
+
+// MinHash signatures over byte shingles. Each shingle is hashed once using
+// SimdHwyHash_Hash64Batch, and the k permutations are derived from the shingle
+// hash h as the upper 32 bits of (a[i] * h + b[i]), where the odd multipliers
+// a[i] and the addends b[i] are derived from the key.
+
+namespace simdhwyhash {
+
+HWY_BEFORE_NAMESPACE();
+namespace HWY_NAMESPACE {
+namespace {
+
+using hwy::HWY_NAMESPACE::Add;
+using hwy::HWY_NAMESPACE::And;
+using hwy::HWY_NAMESPACE::CountTrue;
+using hwy::HWY_NAMESPACE::Eq;
+using hwy::HWY_NAMESPACE::Min;
+using hwy::HWY_NAMESPACE::Mul;
+using hwy::HWY_NAMESPACE::ScalableTag;
+using hwy::HWY_NAMESPACE::ShiftRight;
+
+// Lowers minima[i] to the smallest permuted value of hashes[0] through
+// hashes[num_hashes - 1] for each i less than num_perms
+static void UpdateMinHashMinima(const uint64_t* HWY_RESTRICT mul_coeffs,
+                                const uint64_t* HWY_RESTRICT add_coeffs,
+                                size_t num_perms,
+                                const uint64_t* HWY_RESTRICT hashes,
+                                size_t num_hashes,
+                                uint64_t* HWY_RESTRICT minima) {
+  const ScalableTag<uint64_t> d;
+  const size_t lanes_per_u64_vec = Lanes(d);
+
+  for (size_t i = 0; i < num_perms; i += lanes_per_u64_vec) {
+    const size_t n = HWY_MIN(lanes_per_u64_vec, num_perms - i);
+    const auto a = LoadN(d, mul_coeffs + i, n);
+    const auto b = LoadN(d, add_coeffs + i, n);
+
+    // The minima stay in registers for the entire batch of hashes, and two
+    // accumulators are used to shorten the dependency chain through Min
+    auto min0 = LoadN(d, minima + i, n);
+    auto min1 = min0;
+
+    size_t j = 0;
+    for (; j + 2 <= num_hashes; j += 2) {
+      const auto h0 = Set(d, hashes[j]);
+      const auto h1 = Set(d, hashes[j + 1]);
+      min0 = Min(min0, ShiftRight<32>(Add(Mul(a, h0), b)));
+      min1 = Min(min1, ShiftRight<32>(Add(Mul(a, h1), b)));
+    }
+    if (j < num_hashes) {
+      const auto h0 = Set(d, hashes[j]);
+      min0 = Min(min0, ShiftRight<32>(Add(Mul(a, h0), b)));
+    }
+
+    StoreN(Min(min0, min1), d, minima + i, n);
+  }
+}
+
+static size_t CountEqualU32(const uint32_t* HWY_RESTRICT a,
+                            const uint32_t* HWY_RESTRICT b, size_t num_lanes) {
+  const ScalableTag<uint32_t> d;
+  const size_t lanes_per_u32_vec = Lanes(d);
+
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + lanes_per_u32_vec <= num_lanes; i += lanes_per_u32_vec) {
+    count += CountTrue(d, Eq(LoadU(d, a + i), LoadU(d, b + i)));
+  }
+
+  if (i < num_lanes) {
+    const size_t n = num_lanes - i;
+    count += CountTrue(
+        d, And(Eq(LoadN(d, a + i, n), LoadN(d, b + i, n)), FirstN(d, n)));
+  }
+
+  return count;
+}
+
+}  // namespace
+}  // namespace HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace {
+HWY_EXPORT(UpdateMinHashMinima);
+HWY_EXPORT(CountEqualU32);
+
+// Number of shingles that are hashed by each call to SimdHwyHash_Hash64Batch
+static constexpr size_t kMinHashBatchSize = 256;
+
+static constexpr uint64_t kMinHashCoeffKeyTweak = 0x4D696E4861736801u;
+}  // namespace
+#endif  // HWY_ONCE
+
+}  // namespace simdhwyhash
+
+#if HWY_ONCE
+extern "C" {
+
+int SimdHwyHash_MinHashInit(SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT hasher,
+                            const uint64_t* SIMDHWYHASH_RESTRICT key,
+                            size_t num_perms, size_t shingle_len) {
+  using namespace simdhwyhash;
+
+  hasher->coeffs = nullptr;
+  hasher->num_perms = 0;
+  hasher->shingle_len = 0;
+
+  if (num_perms == 0 || num_perms > SIMDHWYHASH_MINHASH_MAX_PERMS ||
+      shingle_len == 0) {
+    return 0;
+  }
+
+  uint64_t* coeffs =
+      static_cast<uint64_t*>(malloc(num_perms * 2 * sizeof(uint64_t)));
+  if (!coeffs) {
+    return 0;
+  }
+
+  // Permutation i uses the hashes of 2 * i and 2 * i + 1 under a key that
+  // differs from the shingle key, so that the first k permutations do not
+  // depend on num_perms
+  const uint64_t coeff_key[4] = {key[0] ^ kMinHashCoeffKeyTweak, key[1], key[2],
+                                 key[3]};
+  uint64_t indices[kMinHashBatchSize];
+  uint64_t coeff_hashes[kMinHashBatchSize];
+  for (size_t i = 0; i < num_perms * 2; i += kMinHashBatchSize) {
+    const size_t remaining = num_perms * 2 - i;
+    const size_t n =
+        (remaining < kMinHashBatchSize) ? remaining : kMinHashBatchSize;
+    for (size_t j = 0; j < n; j++) {
+      indices[j] = static_cast<uint64_t>(i + j);
+    }
+
+    SimdHwyHash_HashU64Keys64(indices, n, coeff_key, coeff_hashes);
+    for (size_t j = 0; j < n; j += 2) {
+      coeffs[(i + j) / 2] = coeff_hashes[j] | 1u;
+      coeffs[num_perms + (i + j) / 2] = coeff_hashes[j + 1];
+    }
+  }
+
+  for (size_t i = 0; i < 4; i++) {
+    hasher->key[i] = key[i];
+  }
+  hasher->coeffs = coeffs;
+  hasher->num_perms = num_perms;
+  hasher->shingle_len = shingle_len;
+  return 1;
+}
+
+void SimdHwyHash_MinHashFree(SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT
+                                 hasher) {
+  free(hasher->coeffs);
+  hasher->coeffs = nullptr;
+  hasher->num_perms = 0;
+  hasher->shingle_len = 0;
+}
+
+void SimdHwyHash_MinHashSignature(
+    const SimdHwyHashMinHasher* SIMDHWYHASH_RESTRICT hasher,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    uint32_t* SIMDHWYHASH_RESTRICT signature) {
+  using namespace simdhwyhash;
+
+  const size_t num_perms = hasher->num_perms;
+  const uint64_t* mul_coeffs = hasher->coeffs;
+  const uint64_t* add_coeffs = hasher->coeffs + num_perms;
+
+  uint64_t minima[SIMDHWYHASH_MINHASH_MAX_PERMS];
+  for (size_t i = 0; i < num_perms; i++) {
+    minima[i] = 0xFFFFFFFFu;
+  }
+
+  // Inputs that are shorter than a shingle are treated as a single shingle
+  const size_t shingle_len =
+      (byte_len < hasher->shingle_len) ? byte_len : hasher->shingle_len;
+  const size_t num_shingles =
+      (byte_len == 0) ? 0 : byte_len - shingle_len + 1;
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+  const void* shingle_ptrs[kMinHashBatchSize];
+  size_t shingle_lens[kMinHashBatchSize];
+  uint64_t shingle_hashes[kMinHashBatchSize];
+  for (size_t j = 0; j < kMinHashBatchSize; j++) {
+    shingle_lens[j] = shingle_len;
+  }
+
+  for (size_t i = 0; i < num_shingles; i += kMinHashBatchSize) {
+    const size_t remaining = num_shingles - i;
+    const size_t n =
+        (remaining < kMinHashBatchSize) ? remaining : kMinHashBatchSize;
+    for (size_t j = 0; j < n; j++) {
+      shingle_ptrs[j] = bytes + i + j;
+    }
+
+    SimdHwyHash_Hash64Batch(shingle_ptrs, shingle_lens, n, hasher->key,
+                            shingle_hashes);
+    HWY_DYNAMIC_DISPATCH(UpdateMinHashMinima)
+    (mul_coeffs, add_coeffs, num_perms, shingle_hashes, n, minima);
+  }
+
+  for (size_t i = 0; i < num_perms; i++) {
+    signature[i] = static_cast<uint32_t>(minima[i]);
+  }
+}
+
+double SimdHwyHash_MinHashJaccard(
+    const uint32_t* SIMDHWYHASH_RESTRICT signature_a,
+    const uint32_t* SIMDHWYHASH_RESTRICT signature_b, size_t num_perms) {
+  using namespace simdhwyhash;
+
+  if (num_perms == 0) {
+    return 0.0;
+  }
+
+  const size_t num_equal =
+      HWY_DYNAMIC_DISPATCH(CountEqualU32)(signature_a, signature_b, num_perms);
+  return static_cast<double>(num_equal) / static_cast<double>(num_perms);
+}
+
+}  // extern "C"
+#endif  // HWY_ONCE
@@ -0,0 +1,494 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_mphf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Minimal perfect hash function in the style of BBHash.
+//
+// Each key is hashed once with HighwayHash. Level l is a bit array of about
+// gamma times the number of keys that reach level l, and each key that reaches
+// level l is mapped to a bit of the array by remixing its hash with l. Keys
+// that are the only key mapped to their bit set that bit, and the other keys
+// move on to the next level. The index of a key is the number of set bits
+// before its bit across all of the levels, which is found with a popcount and
+// a rank that is stored for each 512-bit block. The few keys that remain after
+// SIMDHWYHASH_MPHF_MAX_LEVELS levels are stored in a sorted fallback array of
+// hashes.
+//
+// The MPHF is stored in a single buffer that is also its serialized form, with
+// all integers stored in little-endian order, so that it can be queried
+// directly from a memory-mapped file:
+//   bytes 0-7: kMphfMagicAndVersion
+//   bytes 8-15: number of keys
+//   bytes 16-47: HighwayHash key
+//   bytes 48-55: number of levels
+//   bytes 56-63: number of 64-bit words of level bits
+//   bytes 64-71: number of fallback keys
+//   then: bit offset of each level, followed by the total number of bits
+//   then: level bits
+//   then: number of set bits before each block of 8 words of level bits
+//   then: sorted hashes of the fallback keys
+
+namespace simdhwyhash {
+namespace {
+
+// "SHMP" followed by version 1 as a 32-bit integer
+static constexpr uint64_t kMphfMagicAndVersion = 0x00000001504D4853u;
+static constexpr size_t kMphfHeaderSize = 72;
+
+static constexpr double kDefaultGamma = 1.0;
+
+// Number of keys that are processed by each task while a level is built
+static constexpr size_t kKeysPerTask = 65536;
+
+static constexpr size_t kWordsPerRankBlock = 8;
+
+// Number of HighwayHash keys that SimdHwyHash_MphfBuild tries before it gives
+// up on keys whose hashes collide
+static constexpr int kMaxBuildAttempts = 4;
+
+static inline void StoreLE64(uint8_t* ptr, uint64_t val) {
+  for (size_t i = 0; i < 8; i++) {
+    ptr[i] = static_cast<uint8_t>(val >> (i * 8));
+  }
+}
+
+static inline uint64_t LoadLE64(const uint8_t* ptr) {
+  uint64_t val = 0;
+  for (size_t i = 0; i < 8; i++) {
+    val |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+  }
+  return val;
+}
+
+static inline unsigned PopCount64(uint64_t val) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_popcountll(val));
+#else
+  val -= (val >> 1) & 0x5555555555555555u;
+  val = (val & 0x3333333333333333u) + ((val >> 2) & 0x3333333333333333u);
+  val = (val + (val >> 4)) & 0x0F0F0F0F0F0F0F0Fu;
+  return static_cast<unsigned>((val * 0x0101010101010101u) >> 56);
+#endif
+}
+
+// Returns the upper 64 bits of the 128-bit product of a and b
+static inline uint64_t MulHigh64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#else
+  const uint64_t a_lo = a & 0xFFFFFFFFu;
+  const uint64_t a_hi = a >> 32;
+  const uint64_t b_lo = b & 0xFFFFFFFFu;
+  const uint64_t b_hi = b >> 32;
+  const uint64_t lo_lo = a_lo * b_lo;
+  const uint64_t hi_lo = a_hi * b_lo;
+  const uint64_t lo_hi = a_lo * b_hi;
+  const uint64_t cross =
+      (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + (lo_hi & 0xFFFFFFFFu);
+  return a_hi * b_hi + (hi_lo >> 32) + (lo_hi >> 32) + (cross >> 32);
+#endif
+}
+
+// Returns the bit of a level of num_bits bits that the key with the given
+// HighwayHash is mapped to. The hash is remixed with the level so that keys
+// that collide on one level are spread out independently on the next.
+static inline uint64_t LevelBitIndex(uint64_t hash, uint64_t level,
+                                     uint64_t num_bits) {
+  uint64_t x = hash + (level + 1) * 0x9E3779B97F4A7C15u;
+  x ^= x >> 32;
+  x *= 0xD6E8FEB86659FD93u;
+  x ^= x >> 32;
+  return MulHigh64(x, num_bits);
+}
+
+static void RunTasks(SimdHwyHashThreadPool* pool, size_t num_tasks,
+                     SimdHwyHashTaskFunc func, void* context) {
+  if (pool) {
+    SimdHwyHash_ThreadPoolRun(pool, num_tasks, func, context);
+  } else {
+    for (size_t i = 0; i < num_tasks; i++) {
+      func(context, i);
+    }
+  }
+}
+
+struct LevelBuildContext {
+  const uint64_t* hashes;
+  size_t num_hashes;
+  uint64_t level;
+  uint64_t num_bits;
+  std::atomic<uint64_t>* taken;
+  std::atomic<uint64_t>* collided;
+  uint64_t* next_hashes;
+  size_t* num_next_hashes_per_task;
+};
+
+// Sets the bit of each key of the task in taken, and the bits that more than
+// one key is mapped to in collided
+static void MarkLevelBits(void* context, size_t task_index) {
+  const LevelBuildContext& ctx =
+      *static_cast<const LevelBuildContext*>(context);
+  const size_t begin = task_index * kKeysPerTask;
+  const size_t end = std::min(begin + kKeysPerTask, ctx.num_hashes);
+  for (size_t i = begin; i < end; i++) {
+    const uint64_t bit_idx =
+        LevelBitIndex(ctx.hashes[i], ctx.level, ctx.num_bits);
+    const uint64_t bit = uint64_t{1} << (bit_idx & 63);
+    const uint64_t prev_word =
+        ctx.taken[bit_idx >> 6].fetch_or(bit, std::memory_order_relaxed);
+    if ((prev_word & bit) != 0) {
+      ctx.collided[bit_idx >> 6].fetch_or(bit, std::memory_order_relaxed);
+    }
+  }
+}
+
+// Copies the hashes of the keys of the task that collided to the part of
+// next_hashes that starts at the first key of the task
+static void CollectCollidedKeys(void* context, size_t task_index) {
+  const LevelBuildContext& ctx =
+      *static_cast<const LevelBuildContext*>(context);
+  const size_t begin = task_index * kKeysPerTask;
+  const size_t end = std::min(begin + kKeysPerTask, ctx.num_hashes);
+  size_t num_collided = 0;
+  for (size_t i = begin; i < end; i++) {
+    const uint64_t bit_idx =
+        LevelBitIndex(ctx.hashes[i], ctx.level, ctx.num_bits);
+    const uint64_t word =
+        ctx.collided[bit_idx >> 6].load(std::memory_order_relaxed);
+    if ((word >> (bit_idx & 63)) & 1) {
+      ctx.next_hashes[begin + num_collided++] = ctx.hashes[i];
+    }
+  }
+  ctx.num_next_hashes_per_task[task_index] = num_collided;
+}
+
+struct HashKeysContext {
+  const void* const* ptrs;
+  const size_t* byte_lens;
+  size_t num_keys;
+  const uint64_t* key;
+  uint64_t* hashes;
+};
+
+static void HashKeys(void* context, size_t task_index) {
+  const HashKeysContext& ctx = *static_cast<const HashKeysContext*>(context);
+  const size_t begin = task_index * kKeysPerTask;
+  const size_t end = std::min(begin + kKeysPerTask, ctx.num_keys);
+  SimdHwyHash_Hash64Batch(ctx.ptrs + begin, ctx.byte_lens + begin, end - begin,
+                          ctx.key, ctx.hashes + begin);
+}
+
+// Sets up the pointers of mphf into the serialized MPHF at data, and returns
+// false if the size of data does not match its header
+static bool InitMphfFromData(SimdHwyHashMphf* mphf, const uint8_t* data,
+                             size_t size) {
+  if (size < kMphfHeaderSize || LoadLE64(data) != kMphfMagicAndVersion) {
+    return false;
+  }
+
+  const uint64_t num_keys = LoadLE64(data + 8);
+  const uint64_t num_levels = LoadLE64(data + 48);
+  const uint64_t num_bit_words = LoadLE64(data + 56);
+  const uint64_t num_fallback_keys = LoadLE64(data + 64);
+  if (num_levels > SIMDHWYHASH_MPHF_MAX_LEVELS ||
+      num_fallback_keys > num_keys) {
+    return false;
+  }
+
+  // Every count is bounded by size, so none of the sums below can overflow
+  const uint64_t max_words = size / sizeof(uint64_t);
+  if (num_bit_words > max_words || num_fallback_keys > max_words) {
+    return false;
+  }
+  const uint64_t num_rank_blocks =
+      (num_bit_words + kWordsPerRankBlock - 1) / kWordsPerRankBlock;
+  const uint64_t expected_size =
+      kMphfHeaderSize +
+      (num_levels + 1 + num_bit_words + num_rank_blocks + num_fallback_keys) *
+          sizeof(uint64_t);
+  if (size != expected_size) {
+    return false;
+  }
+
+  const uint8_t* level_offsets = data + kMphfHeaderSize;
+  if (LoadLE64(level_offsets) != 0 ||
+      LoadLE64(level_offsets + num_levels * 8) != num_bit_words * 64) {
+    return false;
+  }
+  for (uint64_t l = 0; l < num_levels; l++) {
+    const uint64_t begin = LoadLE64(level_offsets + l * 8);
+    const uint64_t end = LoadLE64(level_offsets + l * 8 + 8);
+    if (end <= begin || (end & 63) != 0) {
+      return false;
+    }
+  }
+
+  mphf->data = data;
+  mphf->size = size;
+  for (size_t i = 0; i < 4; i++) {
+    mphf->key[i] = LoadLE64(data + 16 + i * 8);
+  }
+  mphf->num_keys = num_keys;
+  mphf->num_levels = num_levels;
+  mphf->num_bit_words = num_bit_words;
+  mphf->num_fallback_keys = num_fallback_keys;
+  mphf->level_offsets = level_offsets;
+  mphf->bits = level_offsets + (num_levels + 1) * 8;
+  mphf->block_ranks = mphf->bits + num_bit_words * 8;
+  mphf->fallback_hashes = mphf->block_ranks + num_rank_blocks * 8;
+  return true;
+}
+
+// Builds mphf with key as the HighwayHash key. Returns false if memory could
+// not be allocated, or if two of the keys have the same hash, in which case
+// *hashes_collided is set to true. Throws std::bad_alloc if a vector could not
+// be allocated.
+static bool BuildMphf(SimdHwyHashMphf* mphf, const void* const* ptrs,
+                      const size_t* byte_lens, size_t num_keys,
+                      const uint64_t* key, double gamma,
+                      SimdHwyHashThreadPool* pool, bool* hashes_collided) {
+  std::vector<uint64_t> hashes(num_keys);
+  HashKeysContext hash_context = {ptrs, byte_lens, num_keys, key,
+                                  hashes.data()};
+  const size_t num_key_tasks = (num_keys + kKeysPerTask - 1) / kKeysPerTask;
+  RunTasks(pool, num_key_tasks, HashKeys, &hash_context);
+
+  std::vector<uint64_t> next_hashes(num_keys);
+  std::vector<size_t> num_next_hashes_per_task(num_key_tasks);
+  std::vector<uint64_t> level_offsets(1, 0);
+  std::vector<uint64_t> bits;
+
+  size_t num_hashes = num_keys;
+  for (uint64_t level = 0;
+       num_hashes != 0 && level < SIMDHWYHASH_MPHF_MAX_LEVELS; level++) {
+    const uint64_t num_words = static_cast<uint64_t>(
+        (static_cast<double>(num_hashes) * gamma + 63.0) / 64.0);
+    const size_t level_words =
+        static_cast<size_t>((num_words != 0) ? num_words : 1);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> taken(
+        new std::atomic<uint64_t>[level_words]);
+    std::unique_ptr<std::atomic<uint64_t>[]> collided(
+        new std::atomic<uint64_t>[level_words]);
+    for (size_t i = 0; i < level_words; i++) {
+      taken[i].store(0, std::memory_order_relaxed);
+      collided[i].store(0, std::memory_order_relaxed);
+    }
+
+    LevelBuildContext context = {hashes.data(),
+                                 num_hashes,
+                                 level,
+                                 level_words * 64,
+                                 taken.get(),
+                                 collided.get(),
+                                 next_hashes.data(),
+                                 num_next_hashes_per_task.data()};
+    const size_t num_tasks = (num_hashes + kKeysPerTask - 1) / kKeysPerTask;
+    RunTasks(pool, num_tasks, MarkLevelBits, &context);
+    RunTasks(pool, num_tasks, CollectCollidedKeys, &context);
+
+    // Keys that are alone on their bit are placed on this level
+    for (size_t i = 0; i < level_words; i++) {
+      bits.push_back(taken[i].load(std::memory_order_relaxed) &
+                     ~collided[i].load(std::memory_order_relaxed));
+    }
+    level_offsets.push_back(level_offsets.back() + level_words * 64);
+
+    // Gather the collided keys of each task, which keeps them in the same
+    // order no matter how the tasks were run
+    size_t num_next_hashes = 0;
+    for (size_t t = 0; t < num_tasks; t++) {
+      memmove(next_hashes.data() + num_next_hashes,
+              next_hashes.data() + t * kKeysPerTask,
+              num_next_hashes_per_task[t] * sizeof(uint64_t));
+      num_next_hashes += num_next_hashes_per_task[t];
+    }
+
+    hashes.swap(next_hashes);
+    num_hashes = num_next_hashes;
+  }
+
+  // The keys that remain are looked up by binary search, which needs their
+  // hashes to be distinct
+  std::sort(hashes.data(), hashes.data() + num_hashes);
+  for (size_t i = 1; i < num_hashes; i++) {
+    if (hashes[i] == hashes[i - 1]) {
+      *hashes_collided = true;
+      return false;
+    }
+  }
+
+  const size_t num_levels = level_offsets.size() - 1;
+  const size_t num_bit_words = bits.size();
+  const size_t num_rank_blocks =
+      (num_bit_words + kWordsPerRankBlock - 1) / kWordsPerRankBlock;
+  const size_t size =
+      kMphfHeaderSize +
+      (num_levels + 1 + num_bit_words + num_rank_blocks + num_hashes) *
+          sizeof(uint64_t);
+
+  uint8_t* data = static_cast<uint8_t*>(malloc(size));
+  if (!data) {
+    return false;
+  }
+
+  StoreLE64(data, kMphfMagicAndVersion);
+  StoreLE64(data + 8, num_keys);
+  for (size_t i = 0; i < 4; i++) {
+    StoreLE64(data + 16 + i * 8, key[i]);
+  }
+  StoreLE64(data + 48, num_levels);
+  StoreLE64(data + 56, num_bit_words);
+  StoreLE64(data + 64, num_hashes);
+
+  uint8_t* out = data + kMphfHeaderSize;
+  for (size_t l = 0; l <= num_levels; l++, out += 8) {
+    StoreLE64(out, level_offsets[l]);
+  }
+  for (size_t i = 0; i < num_bit_words; i++, out += 8) {
+    StoreLE64(out, bits[i]);
+  }
+  uint64_t rank = 0;
+  for (size_t i = 0; i < num_bit_words; i++) {
+    if (i % kWordsPerRankBlock == 0) {
+      StoreLE64(out, rank);
+      out += 8;
+    }
+    rank += PopCount64(bits[i]);
+  }
+  for (size_t i = 0; i < num_hashes; i++, out += 8) {
+    StoreLE64(out, hashes[i]);
+  }
+
+  InitMphfFromData(mphf, data, size);
+  mphf->owned_data = data;
+  return true;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+int SimdHwyHash_MphfBuild(SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+                          const void* const* SIMDHWYHASH_RESTRICT ptrs,
+                          const size_t* SIMDHWYHASH_RESTRICT byte_lens,
+                          size_t num_keys,
+                          const uint64_t* SIMDHWYHASH_RESTRICT key,
+                          double gamma, SimdHwyHashThreadPool* pool) {
+  using namespace simdhwyhash;
+
+  memset(mphf, 0, sizeof(SimdHwyHashMphf));
+
+  if (gamma == 0.0) {
+    gamma = kDefaultGamma;
+  }
+  if (!(gamma >= 1.0 && gamma <= 64.0)) {
+    return 0;
+  }
+
+  // Two distinct keys with the same 64-bit hash are separated by building
+  // again with another HighwayHash key, as is done by BBHash. Duplicate keys
+  // collide with every HighwayHash key, so the number of attempts is bounded.
+  uint64_t attempt_key[4] = {key[0], key[1], key[2], key[3]};
+  try {
+    for (int attempt = 0; attempt < kMaxBuildAttempts; attempt++) {
+      bool hashes_collided = false;
+      if (BuildMphf(mphf, ptrs, byte_lens, num_keys, attempt_key, gamma, pool,
+                    &hashes_collided)) {
+        return 1;
+      }
+      if (!hashes_collided) {
+        return 0;
+      }
+
+      uint64_t next_key[4];
+      SimdHwyHash_Hash256(attempt_key, sizeof(attempt_key), key, next_key);
+      memcpy(attempt_key, next_key, sizeof(attempt_key));
+    }
+    return 0;
+  } catch (const std::bad_alloc&) {
+    return 0;
+  }
+}
+
+int SimdHwyHash_MphfLoad(SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+                         const void* SIMDHWYHASH_RESTRICT data, size_t size) {
+  using namespace simdhwyhash;
+
+  memset(mphf, 0, sizeof(SimdHwyHashMphf));
+  return InitMphfFromData(mphf, static_cast<const uint8_t*>(data), size) ? 1
+                                                                         : 0;
+}
+
+void SimdHwyHash_MphfFree(SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf) {
+  free(mphf->owned_data);
+  memset(mphf, 0, sizeof(SimdHwyHashMphf));
+}
+
+uint64_t SimdHwyHash_MphfLookup(
+    const SimdHwyHashMphf* SIMDHWYHASH_RESTRICT mphf,
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len) {
+  using namespace simdhwyhash;
+
+  const uint64_t hash = SimdHwyHash_Hash64(ptr, byte_len, mphf->key);
+
+  uint64_t level_begin = 0;
+  for (uint64_t level = 0; level < mphf->num_levels; level++) {
+    const uint64_t level_end = LoadLE64(mphf->level_offsets + level * 8 + 8);
+    const uint64_t bit_idx =
+        level_begin + LevelBitIndex(hash, level, level_end - level_begin);
+    const uint64_t word_idx = bit_idx >> 6;
+    const uint64_t word = LoadLE64(mphf->bits + word_idx * 8);
+    if ((word >> (bit_idx & 63)) & 1) {
+      const uint64_t block = word_idx / kWordsPerRankBlock;
+      uint64_t rank = LoadLE64(mphf->block_ranks + block * 8);
+      for (uint64_t i = block * kWordsPerRankBlock; i < word_idx; i++) {
+        rank += PopCount64(LoadLE64(mphf->bits + i * 8));
+      }
+      return rank + PopCount64(word & ((uint64_t{1} << (bit_idx & 63)) - 1));
+    }
+    level_begin = level_end;
+  }
+
+  // Binary search of the fallback keys, which come after all of the keys
+  // that were placed on a level
+  uint64_t lo = 0;
+  uint64_t hi = mphf->num_fallback_keys;
+  while (lo < hi) {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    const uint64_t mid_hash = LoadLE64(mphf->fallback_hashes + mid * 8);
+    if (mid_hash == hash) {
+      return mphf->num_keys - mphf->num_fallback_keys + mid;
+    }
+    if (mid_hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return mphf->num_keys;
+}
+
+}  // extern "C"
@@ -0,0 +1,521 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Work-stealing thread pool for the batch hashing functions.
+//
+// The work of each call is split into tasks of roughly equal numbers of bytes,
+// and each worker (including the calling thread) starts out owning a
+// contiguous range of tasks. Workers take tasks from the front of their own
+// range, and once it is empty, steal the back half of the range of the nearest
+// worker that still has tasks left. Each task writes a disjoint part of the
+// output, so the results do not depend on the number of threads or on which
+// worker ran which task.
+
+namespace simdhwyhash {
+namespace {
+
+using TaskFunc = SimdHwyHashTaskFunc;
+
+// A range [begin, end) of task indices, packed into one word so that the owner
+// and thieves can claim tasks with a single compare-and-swap
+struct alignas(64) WorkerTaskRange {
+  std::atomic<uint64_t> packed_range;
+};
+
+static inline uint64_t PackTaskRange(uint32_t begin, uint32_t end) {
+  return (static_cast<uint64_t>(end) << 32) | begin;
+}
+
+static inline uint32_t TaskRangeBegin(uint64_t packed_range) {
+  return static_cast<uint32_t>(packed_range);
+}
+
+static inline uint32_t TaskRangeEnd(uint64_t packed_range) {
+  return static_cast<uint32_t>(packed_range >> 32);
+}
+
+// Number of tasks per worker that byte-based splitting aims for, which leaves
+// enough tasks to rebalance through stealing
+static constexpr size_t kTasksPerWorker = 8;
+
+// Tasks are not split below this many bytes, as the synchronization would
+// outweigh the hashing
+static constexpr size_t kMinTaskBytes = 16384;
+
+// Cost, in bytes, that is charged for each input on top of its length, so that
+// many empty or tiny inputs are still spread across the workers
+static constexpr size_t kPerInputCostBytes = 64;
+
+#if defined(__linux__)
+// Appends the CPUs in the cpulist file at path (such as "0-3,8-11") that are
+// also in allowed to cpus, and returns false if the file could not be read
+static bool AppendCpuList(const char* path, const cpu_set_t& allowed,
+                          std::vector<int>& cpus) {
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+
+  int first;
+  while (fscanf(file, "%d", &first) == 1) {
+    int last = first;
+    int separator = fgetc(file);
+    if (separator == '-') {
+      if (fscanf(file, "%d", &last) != 1) {
+        break;
+      }
+      separator = fgetc(file);
+    }
+
+    for (int cpu = first; cpu <= last; cpu++) {
+      if (cpu < CPU_SETSIZE && CPU_ISSET(static_cast<size_t>(cpu), &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (separator != ',') {
+      break;
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+// Returns the CPUs that this process may run on, grouped by NUMA node if
+// group_by_node is true so that consecutive workers share a node
+static std::vector<int> GetPinningCpus(bool group_by_node) {
+  std::vector<int> cpus;
+
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) {
+    return cpus;
+  }
+
+  if (group_by_node) {
+    char path[64];
+    for (int node = 0;; node++) {
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               node);
+      if (!AppendCpuList(path, allowed, cpus)) {
+        break;
+      }
+    }
+  }
+
+  if (cpus.empty()) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(static_cast<size_t>(cpu), &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+
+  return cpus;
+}
+
+static void PinThreadToCpu(std::thread& thread, int cpu) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(static_cast<size_t>(cpu), &cpu_set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpu_set);
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+}  // namespace simdhwyhash
+
+struct SimdHwyHashThreadPool {
+  size_t num_workers = 1;
+  std::unique_ptr<simdhwyhash::WorkerTaskRange[]> task_ranges;
+  std::vector<std::thread> threads;
+
+  // Serializes calls to RunTasks from different threads
+  std::mutex run_mutex;
+
+  std::mutex mutex;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  uint64_t generation = 0;
+  size_t num_busy_threads = 0;
+  bool shutdown = false;
+
+  simdhwyhash::TaskFunc func = nullptr;
+  void* context = nullptr;
+};
+
+namespace simdhwyhash {
+namespace {
+
+static bool ClaimOwnTask(SimdHwyHashThreadPool* pool, size_t worker,
+                         uint32_t* task_index) {
+  std::atomic<uint64_t>& own_range = pool->task_ranges[worker].packed_range;
+  uint64_t range = own_range.load(std::memory_order_acquire);
+  for (;;) {
+    const uint32_t begin = TaskRangeBegin(range);
+    const uint32_t end = TaskRangeEnd(range);
+    if (begin >= end) {
+      return false;
+    }
+    if (own_range.compare_exchange_weak(range, PackTaskRange(begin + 1, end),
+                                        std::memory_order_acq_rel)) {
+      *task_index = begin;
+      return true;
+    }
+  }
+}
+
+// Steals the back half of the range of the nearest worker that has tasks left,
+// keeps the first stolen task in task_index, and makes the rest of the stolen
+// tasks the range of worker
+static bool StealTask(SimdHwyHashThreadPool* pool, size_t worker,
+                      uint32_t* task_index) {
+  const size_t num_workers = pool->num_workers;
+  for (size_t distance = 1; distance < num_workers; distance++) {
+    // Visit worker + 1, worker - 1, worker + 2, and so on, which keeps
+    // stealing within a NUMA node when workers are pinned in node order
+    const size_t offset = (distance + 1) / 2;
+    const size_t victim = (distance & 1)
+                              ? (worker + offset) % num_workers
+                              : (worker + num_workers - offset) % num_workers;
+
+    std::atomic<uint64_t>& victim_range =
+        pool->task_ranges[victim].packed_range;
+    uint64_t range = victim_range.load(std::memory_order_acquire);
+    for (;;) {
+      const uint32_t begin = TaskRangeBegin(range);
+      const uint32_t end = TaskRangeEnd(range);
+      if (begin >= end) {
+        break;
+      }
+
+      const uint32_t mid = begin + (end - begin) / 2;
+      if (victim_range.compare_exchange_weak(range, PackTaskRange(begin, mid),
+                                             std::memory_order_acq_rel)) {
+        *task_index = mid;
+        pool->task_ranges[worker].packed_range.store(
+            PackTaskRange(mid + 1, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+static void RunWorkerTasks(SimdHwyHashThreadPool* pool, size_t worker) {
+  uint32_t task_index;
+  while (ClaimOwnTask(pool, worker, &task_index) ||
+         StealTask(pool, worker, &task_index)) {
+    pool->func(pool->context, task_index);
+  }
+}
+
+static void WorkerThreadMain(SimdHwyHashThreadPool* pool, size_t worker) {
+  uint64_t seen_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(pool->mutex);
+      pool->work_cv.wait(lock, [&] {
+        return pool->shutdown || pool->generation != seen_generation;
+      });
+      if (pool->shutdown) {
+        return;
+      }
+      seen_generation = pool->generation;
+    }
+
+    RunWorkerTasks(pool, worker);
+
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    if (--pool->num_busy_threads == 0) {
+      pool->done_cv.notify_one();
+    }
+  }
+}
+
+// Runs func(context, i) for each i less than num_tasks on the workers of pool,
+// and returns once all of the tasks have completed
+static void RunTasks(SimdHwyHashThreadPool* pool, uint32_t num_tasks,
+                     TaskFunc func, void* context) {
+  if (num_tasks == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(pool->run_mutex);
+
+  const size_t num_workers = pool->num_workers;
+  for (size_t w = 0; w < num_workers; w++) {
+    const uint32_t begin = static_cast<uint32_t>(w * num_tasks / num_workers);
+    const uint32_t end =
+        static_cast<uint32_t>((w + 1) * num_tasks / num_workers);
+    pool->task_ranges[w].packed_range.store(PackTaskRange(begin, end),
+                                            std::memory_order_relaxed);
+  }
+
+  pool->func = func;
+  pool->context = context;
+
+  if (!pool->threads.empty()) {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->num_busy_threads = pool->threads.size();
+    pool->generation++;
+    pool->work_cv.notify_all();
+  }
+
+  // The calling thread is worker 0
+  RunWorkerTasks(pool, 0);
+
+  if (!pool->threads.empty()) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done_cv.wait(lock, [&] { return pool->num_busy_threads == 0; });
+  }
+}
+
+// Returns the number of tasks that byte-based splitting aims for
+static size_t TargetNumTasks(const SimdHwyHashThreadPool* pool,
+                             size_t total_bytes) {
+  const size_t max_num_tasks = pool->num_workers * kTasksPerWorker;
+  const size_t num_min_size_tasks = total_bytes / kMinTaskBytes;
+  const size_t num_tasks =
+      (num_min_size_tasks < max_num_tasks) ? num_min_size_tasks : max_num_tasks;
+  return (num_tasks != 0) ? num_tasks : 1;
+}
+
+struct Hash64BatchTaskContext {
+  const void* const* ptrs;
+  const size_t* byte_lens;
+  const uint64_t* key;
+  uint64_t* hashes;
+  const size_t* task_starts;
+};
+
+static void RunHash64BatchTask(void* context, size_t task_index) {
+  const Hash64BatchTaskContext& ctx =
+      *static_cast<const Hash64BatchTaskContext*>(context);
+  const size_t start = ctx.task_starts[task_index];
+  const size_t end = ctx.task_starts[task_index + 1];
+  SimdHwyHash_Hash64Batch(ctx.ptrs + start, ctx.byte_lens + start,
+                          end - start, ctx.key, ctx.hashes + start);
+}
+
+struct HashU64Keys64TaskContext {
+  const uint64_t* keys;
+  size_t num_keys;
+  size_t keys_per_task;
+  const uint64_t* key;
+  uint64_t* hashes;
+};
+
+static void RunHashU64Keys64Task(void* context, size_t task_index) {
+  const HashU64Keys64TaskContext& ctx =
+      *static_cast<const HashU64Keys64TaskContext*>(context);
+  const size_t start = task_index * ctx.keys_per_task;
+  const size_t remaining = ctx.num_keys - start;
+  const size_t n =
+      (remaining < ctx.keys_per_task) ? remaining : ctx.keys_per_task;
+  SimdHwyHash_HashU64Keys64(ctx.keys + start, n, ctx.key, ctx.hashes + start);
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+SimdHwyHashThreadPool* SimdHwyHash_ThreadPoolCreate(size_t num_threads,
+                                                    unsigned flags) {
+  using namespace simdhwyhash;
+
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) {
+      num_threads = 1;
+    }
+  }
+
+  SimdHwyHashThreadPool* pool = new (std::nothrow) SimdHwyHashThreadPool;
+  if (!pool) {
+    return nullptr;
+  }
+
+  try {
+    pool->num_workers = num_threads;
+    pool->task_ranges.reset(new WorkerTaskRange[num_threads]);
+    for (size_t w = 0; w < num_threads; w++) {
+      pool->task_ranges[w].packed_range.store(0, std::memory_order_relaxed);
+    }
+
+    pool->threads.reserve(num_threads - 1);
+    for (size_t w = 1; w < num_threads; w++) {
+      pool->threads.emplace_back(WorkerThreadMain, pool, w);
+    }
+  } catch (...) {
+    SimdHwyHash_ThreadPoolDestroy(pool);
+    return nullptr;
+  }
+
+#if defined(__linux__)
+  // The calling thread (worker 0) is left unpinned
+  if ((flags & (SIMDHWYHASH_THREAD_POOL_PIN_THREADS |
+                SIMDHWYHASH_THREAD_POOL_NUMA_LOCAL)) != 0) {
+    const std::vector<int> cpus =
+        GetPinningCpus((flags & SIMDHWYHASH_THREAD_POOL_NUMA_LOCAL) != 0);
+    for (size_t i = 0; !cpus.empty() && i < pool->threads.size(); i++) {
+      PinThreadToCpu(pool->threads[i], cpus[(i + 1) % cpus.size()]);
+    }
+  }
+#else
+  (void)flags;
+#endif
+
+  return pool;
+}
+
+void SimdHwyHash_ThreadPoolDestroy(SimdHwyHashThreadPool* pool) {
+  if (!pool) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->shutdown = true;
+  }
+  pool->work_cv.notify_all();
+
+  for (std::thread& thread : pool->threads) {
+    thread.join();
+  }
+  delete pool;
+}
+
+size_t SimdHwyHash_ThreadPoolNumThreads(const SimdHwyHashThreadPool* pool) {
+  return pool->num_workers;
+}
+
+void SimdHwyHash_ThreadPoolRun(SimdHwyHashThreadPool* pool, size_t num_tasks,
+                               SimdHwyHashTaskFunc func, void* context) {
+  using namespace simdhwyhash;
+
+  // Task ranges are packed into 32-bit halves, so very large numbers of tasks
+  // are run in rounds
+  static constexpr size_t kMaxTasksPerRound = 0xFFFFFFFFu;
+  if (num_tasks <= kMaxTasksPerRound) {
+    RunTasks(pool, static_cast<uint32_t>(num_tasks), func, context);
+    return;
+  }
+
+  struct RoundContext {
+    SimdHwyHashTaskFunc func;
+    void* context;
+    size_t first_task;
+  };
+  RoundContext round = {func, context, 0};
+  for (; round.first_task < num_tasks; round.first_task += kMaxTasksPerRound) {
+    const size_t remaining = num_tasks - round.first_task;
+    RunTasks(pool,
+             static_cast<uint32_t>((remaining < kMaxTasksPerRound)
+                                       ? remaining
+                                       : kMaxTasksPerRound),
+             [](void* round_context, size_t task_index) {
+               const RoundContext& r =
+                   *static_cast<const RoundContext*>(round_context);
+               r.func(r.context, r.first_task + task_index);
+             },
+             &round);
+  }
+}
+
+int SimdHwyHash_ParallelHash64Batch(
+    SimdHwyHashThreadPool* pool, const void* const* SIMDHWYHASH_RESTRICT ptrs,
+    const size_t* SIMDHWYHASH_RESTRICT byte_lens, size_t num_inputs,
+    const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+
+  size_t total_bytes = 0;
+  for (size_t i = 0; i < num_inputs; i++) {
+    total_bytes += byte_lens[i] + kPerInputCostBytes;
+  }
+
+  // Split the inputs into consecutive runs of roughly total_bytes / num_tasks
+  // bytes each, with an input that is larger than that forming its own task
+  const size_t target_num_tasks = TargetNumTasks(pool, total_bytes);
+  const size_t task_bytes = total_bytes / target_num_tasks;
+  size_t* task_starts =
+      static_cast<size_t*>(malloc((num_inputs + 1) * sizeof(size_t)));
+  if (!task_starts) {
+    return 0;
+  }
+
+  size_t num_tasks = 0;
+  size_t bytes_in_task = 0;
+  task_starts[0] = 0;
+  for (size_t i = 0; i < num_inputs; i++) {
+    bytes_in_task += byte_lens[i] + kPerInputCostBytes;
+    if (bytes_in_task >= task_bytes || i + 1 == num_inputs) {
+      task_starts[++num_tasks] = i + 1;
+      bytes_in_task = 0;
+    }
+  }
+
+  Hash64BatchTaskContext context = {ptrs, byte_lens, key, hashes, task_starts};
+  RunTasks(pool, static_cast<uint32_t>(num_tasks), RunHash64BatchTask,
+           &context);
+
+  free(task_starts);
+  return 1;
+}
+
+int SimdHwyHash_ParallelHashU64Keys64(
+    SimdHwyHashThreadPool* pool, const uint64_t* SIMDHWYHASH_RESTRICT keys,
+    size_t num_keys, const uint64_t* SIMDHWYHASH_RESTRICT key,
+    uint64_t* SIMDHWYHASH_RESTRICT hashes) {
+  using namespace simdhwyhash;
+
+  const size_t target_num_tasks =
+      TargetNumTasks(pool, num_keys * sizeof(uint64_t));
+  const size_t keys_per_task =
+      (num_keys + target_num_tasks - 1) / target_num_tasks;
+  if (keys_per_task == 0) {
+    return 1;
+  }
+
+  HashU64Keys64TaskContext context = {keys, num_keys, keys_per_task, key,
+                                      hashes};
+  RunTasks(pool,
+           static_cast<uint32_t>((num_keys + keys_per_task - 1) /
+                                 keys_per_task),
+           RunHashU64Keys64Task, &context);
+  return 1;
+}
+
+}  // extern "C"
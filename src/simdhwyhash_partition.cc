@@ -0,0 +1,145 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_partition.h"
+
+#include <string.h>
+
+#include <new>
+
+namespace simdhwyhash {
+namespace {
+
+// Number of keys that are hashed by each call to SimdHwyHash_HashU64Keys64
+static constexpr size_t kPartitionBatchSize = 256;
+
+// Number of values that fit in one 64-byte cache line
+static constexpr size_t kWriteCombiningLanes = 8;
+
+// Values that are scattered to a partition are staged in a cache-line sized
+// buffer and written to the output one whole cache line at a time, which
+// avoids a read-for-ownership of a different output cache line for every value
+struct alignas(64) WriteCombiningBuffer {
+  uint64_t values[kWriteCombiningLanes];
+};
+
+// Reduces hash to a partition in [0, num_partitions) using multiply-shift on
+// the upper 32 bits of hash
+static inline uint32_t ReduceToPartition(uint64_t hash,
+                                         uint32_t num_partitions) {
+  return static_cast<uint32_t>(((hash >> 32) * num_partitions) >> 32);
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+int SimdHwyHash_Partition(const uint64_t* SIMDHWYHASH_RESTRICT keys,
+                          size_t num_keys,
+                          const uint64_t* SIMDHWYHASH_RESTRICT key,
+                          uint32_t num_partitions,
+                          uint32_t* SIMDHWYHASH_RESTRICT partition_ids,
+                          size_t* SIMDHWYHASH_RESTRICT histogram) {
+  using namespace simdhwyhash;
+
+  if (num_partitions == 0) {
+    return 0;
+  }
+
+  memset(histogram, 0, num_partitions * sizeof(size_t));
+
+  uint64_t hashes[kPartitionBatchSize];
+  for (size_t i = 0; i < num_keys; i += kPartitionBatchSize) {
+    const size_t remaining = num_keys - i;
+    const size_t n =
+        (remaining < kPartitionBatchSize) ? remaining : kPartitionBatchSize;
+    SimdHwyHash_HashU64Keys64(keys + i, n, key, hashes);
+
+    for (size_t j = 0; j < n; j++) {
+      partition_ids[i + j] = ReduceToPartition(hashes[j], num_partitions);
+    }
+    for (size_t j = 0; j < n; j++) {
+      histogram[partition_ids[i + j]]++;
+    }
+  }
+  return 1;
+}
+
+int SimdHwyHash_PartitionScatter(
+    const uint64_t* SIMDHWYHASH_RESTRICT values, size_t num_values,
+    const uint32_t* SIMDHWYHASH_RESTRICT partition_ids,
+    const size_t* SIMDHWYHASH_RESTRICT histogram, uint32_t num_partitions,
+    uint64_t* SIMDHWYHASH_RESTRICT out) {
+  using namespace simdhwyhash;
+
+  if (num_partitions == 0) {
+    return 0;
+  }
+
+  WriteCombiningBuffer* buffers =
+      new (std::nothrow) WriteCombiningBuffer[num_partitions];
+  size_t* offsets = new (std::nothrow) size_t[size_t{num_partitions} * 2];
+  if (!buffers || !offsets) {
+    delete[] buffers;
+    delete[] offsets;
+    return 0;
+  }
+
+  // offsets[p] is the start of partition p in out, and offsets[num_partitions
+  // + p] is the index in out of the next value of partition p
+  size_t* next_offsets = offsets + num_partitions;
+  size_t start_offset = 0;
+  for (uint32_t p = 0; p < num_partitions; p++) {
+    offsets[p] = start_offset;
+    next_offsets[p] = start_offset;
+    start_offset += histogram[p];
+  }
+
+  // The value that is written to out[k] is staged in slot (k & 7) of the
+  // buffer of its partition, so that each flush writes one aligned group of 8
+  // values
+  for (size_t i = 0; i < num_values; i++) {
+    const uint32_t p = partition_ids[i];
+    const size_t next_offset = next_offsets[p]++;
+    buffers[p].values[next_offset & (kWriteCombiningLanes - 1)] = values[i];
+
+    if (((next_offset + 1) & (kWriteCombiningLanes - 1)) == 0) {
+      const size_t group_start = next_offset + 1 - kWriteCombiningLanes;
+      const size_t copy_start =
+          (group_start < offsets[p]) ? offsets[p] : group_start;
+      memcpy(out + copy_start, buffers[p].values + (copy_start - group_start),
+             (next_offset + 1 - copy_start) * sizeof(uint64_t));
+    }
+  }
+
+  // Flush the values that remain in the partially filled buffers
+  for (uint32_t p = 0; p < num_partitions; p++) {
+    const size_t next_offset = next_offsets[p];
+    const size_t group_start =
+        next_offset & ~static_cast<size_t>(kWriteCombiningLanes - 1);
+    const size_t copy_start =
+        (group_start < offsets[p]) ? offsets[p] : group_start;
+    if (copy_start < next_offset) {
+      memcpy(out + copy_start, buffers[p].values + (copy_start - group_start),
+             (next_offset - copy_start) * sizeof(uint64_t));
+    }
+  }
+
+  delete[] buffers;
+  delete[] offsets;
+  return 1;
+}
+
+}  // extern "C"
@@ -0,0 +1,449 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_queue.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Asynchronous hashing queue.
+//
+// Each worker thread owns a bounded ring of jobs that any number of threads
+// can submit to without taking a lock, and that only the worker dequeues from
+// (the multi-producer ring of Dmitry Vyukov, with a single consumer). A worker
+// collects jobs from its ring until it has max_batch_size jobs or until
+// max_latency_ns has passed since it collected the oldest of them, then sorts
+// the jobs by key and by length class and hashes each run of jobs with the same
+// key and length class with SimdHwyHash_Hash64Batch, so that the lanes of the
+// interleaved kernel mostly process inputs with similar numbers of packets.
+
+namespace simdhwyhash {
+namespace {
+
+static constexpr size_t kDefaultRingCapacity = 4096;
+static constexpr size_t kDefaultMaxBatchSize = 64;
+
+// Rings larger than this are not allowed, which keeps the sequence numbers of
+// the ring from wrapping around in practice
+static constexpr size_t kMaxRingCapacity = size_t{1} << 24;
+
+struct QueueJob {
+  const void* ptr;
+  size_t byte_len;
+  uint64_t key[4];
+  SimdHwyHashQueueCallback callback;
+  void* user_data;
+};
+
+struct RingCell {
+  std::atomic<size_t> sequence;
+  QueueJob job;
+};
+
+struct alignas(64) QueueWorker {
+  // Producer side of the ring
+  alignas(64) std::atomic<size_t> enqueue_pos{0};
+
+  // Consumer side of the ring, which is only accessed by the worker thread
+  alignas(64) size_t dequeue_pos = 0;
+  std::unique_ptr<RingCell[]> cells;
+  size_t ring_mask = 0;
+
+  // Set while the worker thread is waiting for jobs, so that producers only
+  // take the mutex to wake the worker up when it is actually waiting
+  std::atomic<bool> sleeping{false};
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  // Number of jobs whose callbacks have run, which are always the first
+  // num_completed jobs that were enqueued into the ring
+  std::atomic<size_t> num_completed{0};
+
+  std::thread thread;
+
+  // Scratch space for the batches of the worker thread
+  std::vector<QueueJob> pending_jobs;
+  std::vector<uint32_t> job_order;
+  std::vector<const void*> batch_ptrs;
+  std::vector<size_t> batch_byte_lens;
+  std::vector<uint64_t> batch_hashes;
+};
+
+}  // namespace
+}  // namespace simdhwyhash
+
+struct SimdHwyHashQueue {
+  std::unique_ptr<simdhwyhash::QueueWorker[]> workers;
+  size_t num_workers = 0;
+  size_t max_batch_size = 0;
+  std::chrono::nanoseconds max_latency{0};
+
+  std::atomic<size_t> next_worker{0};
+  std::atomic<bool> stop{false};
+
+  std::atomic<size_t> num_flush_waiters{0};
+  std::mutex flush_mutex;
+  std::condition_variable flush_cv;
+};
+
+namespace simdhwyhash {
+namespace {
+
+static bool TryEnqueueJob(QueueWorker& worker, const QueueJob& job) {
+  size_t pos = worker.enqueue_pos.load(std::memory_order_relaxed);
+  for (;;) {
+    RingCell& cell = worker.cells[pos & worker.ring_mask];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    const intptr_t diff =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (worker.enqueue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        cell.job = job;
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The ring is full
+      return false;
+    } else {
+      pos = worker.enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+static bool RingIsEmpty(const QueueWorker& worker) {
+  const RingCell& cell = worker.cells[worker.dequeue_pos & worker.ring_mask];
+  return cell.sequence.load(std::memory_order_acquire) !=
+         worker.dequeue_pos + 1;
+}
+
+// Moves jobs from the ring of worker to its pending jobs until the ring is
+// empty or there are max_batch_size pending jobs
+static void DequeueJobs(QueueWorker& worker, size_t max_batch_size) {
+  while (worker.pending_jobs.size() < max_batch_size && !RingIsEmpty(worker)) {
+    RingCell& cell = worker.cells[worker.dequeue_pos & worker.ring_mask];
+    worker.pending_jobs.push_back(cell.job);
+    cell.sequence.store(worker.dequeue_pos + worker.ring_mask + 1,
+                        std::memory_order_release);
+    worker.dequeue_pos++;
+  }
+}
+
+// Returns 0 if an input of byte_len bytes has no whole 32-byte packets, or
+// one more than the floor of the base 2 logarithm of its number of whole
+// packets otherwise
+static unsigned LengthClass(size_t byte_len) {
+  unsigned length_class = 0;
+  for (size_t num_packets = byte_len >> 5; num_packets != 0;
+       num_packets >>= 1) {
+    length_class++;
+  }
+  return length_class;
+}
+
+static bool JobBatchesBefore(const QueueJob& a, const QueueJob& b) {
+  const int key_cmp = memcmp(a.key, b.key, sizeof(a.key));
+  if (key_cmp != 0) {
+    return key_cmp < 0;
+  }
+  return LengthClass(a.byte_len) < LengthClass(b.byte_len);
+}
+
+// Hashes the pending jobs of worker, runs their callbacks, and clears them
+static void ProcessPendingJobs(SimdHwyHashQueue* queue, QueueWorker& worker) {
+  const std::vector<QueueJob>& jobs = worker.pending_jobs;
+  const size_t num_jobs = jobs.size();
+
+  std::vector<uint32_t>& order = worker.job_order;
+  order.resize(num_jobs);
+  for (size_t i = 0; i < num_jobs; i++) {
+    order[i] = static_cast<uint32_t>(i);
+  }
+  std::sort(order.begin(), order.end(), [&jobs](uint32_t a, uint32_t b) {
+    return JobBatchesBefore(jobs[a], jobs[b]);
+  });
+
+  worker.batch_ptrs.resize(num_jobs);
+  worker.batch_byte_lens.resize(num_jobs);
+  worker.batch_hashes.resize(num_jobs);
+  for (size_t i = 0; i < num_jobs; i++) {
+    worker.batch_ptrs[i] = jobs[order[i]].ptr;
+    worker.batch_byte_lens[i] = jobs[order[i]].byte_len;
+  }
+
+  size_t batch_start = 0;
+  while (batch_start < num_jobs) {
+    const QueueJob& first_job = jobs[order[batch_start]];
+    size_t batch_end = batch_start + 1;
+    while (batch_end < num_jobs &&
+           !JobBatchesBefore(first_job, jobs[order[batch_end]])) {
+      batch_end++;
+    }
+
+    SimdHwyHash_Hash64Batch(worker.batch_ptrs.data() + batch_start,
+                            worker.batch_byte_lens.data() + batch_start,
+                            batch_end - batch_start, first_job.key,
+                            worker.batch_hashes.data() + batch_start);
+    batch_start = batch_end;
+  }
+
+  for (size_t i = 0; i < num_jobs; i++) {
+    const QueueJob& job = jobs[order[i]];
+    job.callback(job.user_data, worker.batch_hashes[i]);
+  }
+
+  worker.pending_jobs.clear();
+
+  worker.num_completed.fetch_add(num_jobs, std::memory_order_seq_cst);
+  if (queue->num_flush_waiters.load(std::memory_order_seq_cst) != 0) {
+    std::lock_guard<std::mutex> lock(queue->flush_mutex);
+    queue->flush_cv.notify_all();
+  }
+}
+
+static void WakeWorker(QueueWorker& worker) {
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  worker.cv.notify_one();
+}
+
+// Waits until the ring of worker has jobs or the queue is being destroyed. If
+// has_deadline is true, which is the case if the worker has pending jobs, also
+// stops waiting once the deadline has passed or the queue is being flushed.
+static void WaitForJobs(SimdHwyHashQueue* queue, QueueWorker& worker,
+                        bool has_deadline,
+                        std::chrono::steady_clock::time_point deadline) {
+  worker.sleeping.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  {
+    const auto wake_up = [queue, &worker, has_deadline] {
+      return !RingIsEmpty(worker) ||
+             queue->stop.load(std::memory_order_acquire) ||
+             (has_deadline &&
+              queue->num_flush_waiters.load(std::memory_order_acquire) != 0);
+    };
+
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (has_deadline) {
+      worker.cv.wait_until(lock, deadline, wake_up);
+    } else {
+      worker.cv.wait(lock, wake_up);
+    }
+  }
+  worker.sleeping.store(false, std::memory_order_relaxed);
+}
+
+static void QueueWorkerMain(SimdHwyHashQueue* queue, QueueWorker* worker) {
+  std::chrono::steady_clock::time_point batch_deadline;
+  for (;;) {
+    const bool had_pending_jobs = !worker->pending_jobs.empty();
+    DequeueJobs(*worker, queue->max_batch_size);
+
+    if (worker->pending_jobs.empty()) {
+      if (queue->stop.load(std::memory_order_acquire) &&
+          RingIsEmpty(*worker)) {
+        return;
+      }
+      WaitForJobs(queue, *worker, false, batch_deadline);
+      continue;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!had_pending_jobs) {
+      // A deadline past the range of the clock only waits for a full batch
+      // or a flush
+      const auto max_wait = std::chrono::steady_clock::time_point::max() - now;
+      batch_deadline = (queue->max_latency < max_wait)
+                           ? now + queue->max_latency
+                           : std::chrono::steady_clock::time_point::max();
+    }
+
+    if (worker->pending_jobs.size() >= queue->max_batch_size ||
+        now >= batch_deadline || queue->stop.load(std::memory_order_acquire) ||
+        queue->num_flush_waiters.load(std::memory_order_acquire) != 0) {
+      ProcessPendingJobs(queue, *worker);
+    } else {
+      WaitForJobs(queue, *worker, true, batch_deadline);
+    }
+  }
+}
+
+static size_t RoundUpToPowerOf2(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+SimdHwyHashQueue* SimdHwyHash_QueueCreate(size_t num_workers,
+                                          size_t ring_capacity,
+                                          size_t max_batch_size,
+                                          uint64_t max_latency_ns) {
+  using namespace simdhwyhash;
+
+  if (num_workers == 0) {
+    num_workers = 1;
+  }
+  if (ring_capacity == 0) {
+    ring_capacity = kDefaultRingCapacity;
+  }
+  if (max_batch_size == 0) {
+    max_batch_size = kDefaultMaxBatchSize;
+  }
+  if (ring_capacity > kMaxRingCapacity) {
+    return nullptr;
+  }
+  ring_capacity = RoundUpToPowerOf2(ring_capacity);
+
+  SimdHwyHashQueue* queue = new (std::nothrow) SimdHwyHashQueue;
+  if (!queue) {
+    return nullptr;
+  }
+
+  queue->max_batch_size = max_batch_size;
+  // std::chrono::nanoseconds is signed, so larger latencies are clamped to
+  // its maximum rather than wrapped around to negative latencies
+  const uint64_t max_latency_limit =
+      static_cast<uint64_t>(std::chrono::nanoseconds::max().count());
+  queue->max_latency =
+      std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(
+          std::min(max_latency_ns, max_latency_limit)));
+
+  try {
+    queue->workers.reset(new QueueWorker[num_workers]);
+    for (size_t w = 0; w < num_workers; w++) {
+      QueueWorker& worker = queue->workers[w];
+      worker.cells.reset(new RingCell[ring_capacity]);
+      worker.ring_mask = ring_capacity - 1;
+      for (size_t i = 0; i < ring_capacity; i++) {
+        worker.cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+      worker.pending_jobs.reserve(max_batch_size);
+    }
+
+    for (; queue->num_workers < num_workers; queue->num_workers++) {
+      QueueWorker* worker = &queue->workers[queue->num_workers];
+      worker->thread = std::thread(QueueWorkerMain, queue, worker);
+    }
+  } catch (...) {
+    SimdHwyHash_QueueDestroy(queue);
+    return nullptr;
+  }
+
+  return queue;
+}
+
+void SimdHwyHash_QueueDestroy(SimdHwyHashQueue* queue) {
+  using namespace simdhwyhash;
+
+  if (!queue) {
+    return;
+  }
+
+  queue->stop.store(true, std::memory_order_seq_cst);
+  for (size_t w = 0; w < queue->num_workers; w++) {
+    WakeWorker(queue->workers[w]);
+  }
+  for (size_t w = 0; w < queue->num_workers; w++) {
+    queue->workers[w].thread.join();
+  }
+  delete queue;
+}
+
+int SimdHwyHash_Submit(SimdHwyHashQueue* queue, const void* ptr,
+                       size_t byte_len, const uint64_t* key,
+                       SimdHwyHashQueueCallback callback, void* user_data) {
+  using namespace simdhwyhash;
+
+  QueueJob job;
+  job.ptr = ptr;
+  job.byte_len = byte_len;
+  memcpy(job.key, key, sizeof(job.key));
+  job.callback = callback;
+  job.user_data = user_data;
+
+  // Spread the jobs over the workers, and fall back to the other workers if
+  // the ring of the chosen worker is full
+  const size_t num_workers = queue->num_workers;
+  const size_t first_worker =
+      queue->next_worker.fetch_add(1, std::memory_order_relaxed) % num_workers;
+  for (size_t i = 0; i < num_workers; i++) {
+    size_t w = first_worker + i;
+    if (w >= num_workers) {
+      w -= num_workers;
+    }
+
+    QueueWorker& worker = queue->workers[w];
+    if (TryEnqueueJob(worker, job)) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (worker.sleeping.load(std::memory_order_relaxed)) {
+        WakeWorker(worker);
+      }
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void SimdHwyHash_QueueFlush(SimdHwyHashQueue* queue) {
+  using namespace simdhwyhash;
+
+  // The jobs that were submitted before the call are the jobs before the
+  // current enqueue position of each ring
+  const size_t num_workers = queue->num_workers;
+  std::vector<size_t> num_enqueued(num_workers);
+  for (size_t w = 0; w < num_workers; w++) {
+    num_enqueued[w] =
+        queue->workers[w].enqueue_pos.load(std::memory_order_acquire);
+  }
+
+  queue->num_flush_waiters.fetch_add(1, std::memory_order_seq_cst);
+  for (size_t w = 0; w < num_workers; w++) {
+    WakeWorker(queue->workers[w]);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(queue->flush_mutex);
+    queue->flush_cv.wait(lock, [queue, num_workers, &num_enqueued] {
+      for (size_t w = 0; w < num_workers; w++) {
+        if (queue->workers[w].num_completed.load(std::memory_order_seq_cst) <
+            num_enqueued[w]) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
+
+  queue->num_flush_waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+}  // extern "C"
@@ -0,0 +1,256 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_sharding.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <new>
+
+// Node selection for sharding.
+//
+// Rendezvous hashing hashes the input once under the key of each node using
+// SimdHwyHash_HashMultiKey64, which advances the states of several node keys
+// side by side, and selects the nodes with the highest scores. The score of a
+// node is its hash, or w / -ln(u) for a node of weight w, where u is the hash
+// mapped to (0, 1). The weighted scores are computed with scalar code so that
+// every CPU target gives bit-identical scores, as all of the clients of a
+// sharded service must agree on the selected nodes.
+
+namespace simdhwyhash {
+namespace {
+
+// Number of nodes that are hashed by each call to SimdHwyHash_HashMultiKey64
+static constexpr size_t kRendezvousBatchSize = 256;
+
+// Number of scores that are kept on the stack by SimdHwyHash_RendezvousSelect
+static constexpr size_t kMaxStackTopK = 64;
+
+// Inserts node into the num_top highest scores in top_scores (which are in
+// descending order) if its score is one of the top_k highest. Nodes are
+// inserted in increasing order, so a node that ties with an earlier node is
+// placed after it.
+template <class Score>
+static inline void InsertTopK(Score score, size_t node, size_t top_k,
+                              Score* SIMDHWYHASH_RESTRICT top_scores,
+                              size_t* SIMDHWYHASH_RESTRICT top_nodes,
+                              size_t& num_top) {
+  if (num_top == top_k) {
+    if (!(score > top_scores[num_top - 1])) {
+      return;
+    }
+    num_top--;
+  }
+
+  size_t pos = num_top;
+  while (pos != 0 && score > top_scores[pos - 1]) {
+    top_scores[pos] = top_scores[pos - 1];
+    top_nodes[pos] = top_nodes[pos - 1];
+    pos--;
+  }
+  top_scores[pos] = score;
+  top_nodes[pos] = node;
+  num_top++;
+}
+
+// Maps hash to a double in the open interval (0, 1)
+static inline double HashToUnitInterval(uint64_t hash) {
+  return (static_cast<double>(hash >> 11) + 0.5) * 0x1p-53;
+}
+
+// Selects the top_k nodes with the highest scores, where score_func(hash,
+// node, score) computes the score of a node from its hash and returns false if
+// the node cannot be selected
+template <class Score, class ScoreFunc>
+static size_t RendezvousSelectTopK(const void* ptr, size_t byte_len,
+                                   const uint64_t (*node_keys)[4],
+                                   size_t num_nodes, size_t top_k,
+                                   const ScoreFunc& score_func,
+                                   size_t* out) {
+  Score stack_scores[kMaxStackTopK];
+  Score* top_scores = (top_k <= kMaxStackTopK)
+                          ? stack_scores
+                          : new (std::nothrow) Score[top_k];
+  if (!top_scores) {
+    return 0;
+  }
+
+  uint64_t hashes[kRendezvousBatchSize];
+  size_t num_top = 0;
+  for (size_t i = 0; i < num_nodes; i += kRendezvousBatchSize) {
+    const size_t remaining = num_nodes - i;
+    const size_t n =
+        (remaining < kRendezvousBatchSize) ? remaining : kRendezvousBatchSize;
+    SimdHwyHash_HashMultiKey64(ptr, byte_len, node_keys + i, n, hashes);
+
+    for (size_t j = 0; j < n; j++) {
+      Score score;
+      if (score_func(hashes[j], i + j, score)) {
+        InsertTopK(score, i + j, top_k, top_scores, out, num_top);
+      }
+    }
+  }
+
+  if (top_scores != stack_scores) {
+    delete[] top_scores;
+  }
+  return num_top;
+}
+
+// Returns true if n is prime
+static bool IsPrime(size_t n) {
+  if (n < 2) {
+    return false;
+  }
+  for (size_t d = 2; d <= n / d; d++) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+}  // namespace simdhwyhash
+
+extern "C" {
+
+size_t SimdHwyHash_RendezvousSelect(
+    const void* SIMDHWYHASH_RESTRICT ptr, size_t byte_len,
+    const uint64_t (*SIMDHWYHASH_RESTRICT node_keys)[4], size_t num_nodes,
+    const double* SIMDHWYHASH_RESTRICT weights, size_t top_k,
+    size_t* SIMDHWYHASH_RESTRICT out) {
+  using namespace simdhwyhash;
+
+  if (top_k > num_nodes) {
+    top_k = num_nodes;
+  }
+  if (top_k == 0) {
+    return 0;
+  }
+
+  if (!weights) {
+    return RendezvousSelectTopK<uint64_t>(
+        ptr, byte_len, node_keys, num_nodes, top_k,
+        [](uint64_t hash, size_t /*node*/, uint64_t& score) {
+          score = hash;
+          return true;
+        },
+        out);
+  }
+
+  return RendezvousSelectTopK<double>(
+      ptr, byte_len, node_keys, num_nodes, top_k,
+      [weights](uint64_t hash, size_t node, double& score) {
+        // Nodes with a weight of zero (or NaN) are never selected
+        const double weight = weights[node];
+        if (!(weight > 0.0)) {
+          return false;
+        }
+        score = weight / -log(HashToUnitInterval(hash));
+        return true;
+      },
+      out);
+}
+
+uint32_t SimdHwyHash_JumpSelect(const void* SIMDHWYHASH_RESTRICT ptr,
+                                size_t byte_len,
+                                const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                uint32_t num_buckets) {
+  // Jump consistent hashing (Lamping and Veach), seeded with the 64-bit hash
+  // of the input
+  uint64_t state = SimdHwyHash_Hash64(ptr, byte_len, key);
+  int64_t bucket = -1;
+  int64_t next_bucket = 0;
+  while (next_bucket < static_cast<int64_t>(num_buckets)) {
+    bucket = next_bucket;
+    state = state * 2862933555777941757u + 1;
+    next_bucket = static_cast<int64_t>(
+        static_cast<double>(bucket + 1) *
+        (static_cast<double>(int64_t{1} << 31) /
+         static_cast<double>((state >> 33) + 1)));
+  }
+  return (bucket < 0) ? 0u : static_cast<uint32_t>(bucket);
+}
+
+int SimdHwyHash_MaglevBuild(const void* const* SIMDHWYHASH_RESTRICT node_ptrs,
+                            const size_t* SIMDHWYHASH_RESTRICT node_byte_lens,
+                            size_t num_nodes,
+                            const uint64_t* SIMDHWYHASH_RESTRICT key,
+                            uint32_t* SIMDHWYHASH_RESTRICT table,
+                            size_t table_size) {
+  using namespace simdhwyhash;
+
+  // The preference list of every node is a permutation of the table entries
+  // only if table_size is prime
+  if (num_nodes == 0 || num_nodes > table_size || num_nodes > 0xFFFFFFFFu ||
+      !IsPrime(table_size)) {
+    return 0;
+  }
+
+  // offsets[i] is the next entry in the preference list of node i, and
+  // skips[i] is the distance between the entries of its preference list
+  size_t* offsets = new (std::nothrow) size_t[num_nodes * 2];
+  if (!offsets) {
+    return 0;
+  }
+  size_t* skips = offsets + num_nodes;
+  for (size_t i = 0; i < num_nodes; i++) {
+    uint64_t node_hash[2];
+    SimdHwyHash_Hash128(node_ptrs[i], node_byte_lens[i], key, node_hash);
+    offsets[i] = static_cast<size_t>(node_hash[0] % table_size);
+    skips[i] = static_cast<size_t>(node_hash[1] % (table_size - 1)) + 1;
+  }
+
+  static constexpr uint32_t kEmptyEntry = 0xFFFFFFFFu;
+  for (size_t i = 0; i < table_size; i++) {
+    table[i] = kEmptyEntry;
+  }
+
+  // The nodes take turns claiming the next unclaimed entry of their
+  // preference lists until the table is full
+  size_t num_filled = 0;
+  for (;;) {
+    for (size_t i = 0; i < num_nodes; i++) {
+      size_t entry = offsets[i];
+      while (table[entry] != kEmptyEntry) {
+        entry += skips[i];
+        if (entry >= table_size) {
+          entry -= table_size;
+        }
+      }
+      table[entry] = static_cast<uint32_t>(i);
+
+      entry += skips[i];
+      offsets[i] = (entry >= table_size) ? entry - table_size : entry;
+
+      if (++num_filled == table_size) {
+        delete[] offsets;
+        return 1;
+      }
+    }
+  }
+}
+
+uint32_t SimdHwyHash_MaglevSelect(const uint32_t* SIMDHWYHASH_RESTRICT table,
+                                  size_t table_size,
+                                  const void* SIMDHWYHASH_RESTRICT ptr,
+                                  size_t byte_len,
+                                  const uint64_t* SIMDHWYHASH_RESTRICT key) {
+  const uint64_t hash = SimdHwyHash_Hash64(ptr, byte_len, key);
+  return table[hash % table_size];
+}
+
+}  // extern "C"
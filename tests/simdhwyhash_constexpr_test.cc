@@ -0,0 +1,114 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_constexpr.h"
+
+#include "simdhwyhash.h"
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static constexpr uint64_t kKey1234[4] = {1, 2, 3, 4};
+static constexpr uint8_t kB0[33] = {
+    128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138,
+    139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149,
+    150, 151, 152, 153, 154, 155, 156, 157, 158, 159, 160};
+static constexpr uint8_t kB1[1] = {255};
+
+// The known values of TestKnownValuesWithKey1234 in simdhwyhash_test.cc,
+// checked at compile time
+static_assert(ConstHash64(kB0, 33, kKey1234) == 0x53c516cce478cad7U,
+              "ConstHash64 of kB0 is wrong");
+static_assert(ConstHash64(kB1, 1, kKey1234) == 0x7858f24d2d79b2b2U,
+              "ConstHash64 of kB1 is wrong");
+
+enum class Method { kGet, kPut, kPost, kDelete, kUnknown };
+
+static Method ParseMethod(const char* str, size_t len) {
+  switch (SimdHwyHash_Hash64(str, len, kKey)) {
+    case ConstHash64("GET", kKey):
+      return Method::kGet;
+    case ConstHash64("PUT", kKey):
+      return Method::kPut;
+    case ConstHash64("POST", kKey):
+      return Method::kPost;
+    case ConstHash64("DELETE", kKey):
+      return Method::kDelete;
+    default:
+      return Method::kUnknown;
+  }
+}
+
+TEST(SimdHwyHashConstexprTest, TestSwitch) {
+  EXPECT_EQ(ParseMethod("GET", 3), Method::kGet);
+  EXPECT_EQ(ParseMethod("PUT", 3), Method::kPut);
+  EXPECT_EQ(ParseMethod("POST", 4), Method::kPost);
+  EXPECT_EQ(ParseMethod("DELETE", 6), Method::kDelete);
+  EXPECT_EQ(ParseMethod("PATCH", 5), Method::kUnknown);
+  EXPECT_EQ(ParseMethod("GET", 2), Method::kUnknown);
+}
+
+TEST(SimdHwyHashConstexprTest, TestMatchesSimdHwyHash) {
+  uint8_t data[200];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 53u + 29u) & 0xFFu);
+  }
+
+  for (size_t byte_len = 0; byte_len <= sizeof(data); byte_len++) {
+    EXPECT_EQ(ConstHash64(data, byte_len, kKey),
+              SimdHwyHash_Hash64(data, byte_len, kKey));
+
+    uint64_t expected[4];
+    SimdHwyHash_Hash128(data, byte_len, kKey, expected);
+    const std::array<uint64_t, 2> actual128 =
+        ConstHash128(data, byte_len, kKey);
+    EXPECT_EQ(actual128[0], expected[0]);
+    EXPECT_EQ(actual128[1], expected[1]);
+
+    SimdHwyHash_Hash256(data, byte_len, kKey, expected);
+    const std::array<uint64_t, 4> actual256 =
+        ConstHash256(data, byte_len, kKey);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(actual256[i], expected[i]);
+    }
+  }
+
+  // Hashing in multiple updates, all but the last of which are multiples of
+  // 32 bytes long
+  ConstHwyHashState state = ConstHwyHashReset(kKey);
+  ConstHwyHashUpdate(state, data, 64);
+  ConstHwyHashUpdate(state, data + 64, 32);
+  ConstHwyHashUpdate(state, data + 96, 45);
+  EXPECT_EQ(ConstHwyHashFinalize64(state), SimdHwyHash_Hash64(data, 141, kKey));
+
+  const char kStr[] = "The quick brown fox jumps over the lazy dog";
+  EXPECT_EQ(ConstHash64(kStr, kKey),
+            SimdHwyHash_Hash64(kStr, sizeof(kStr) - 1, kKey));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_dedup.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static constexpr uint64_t kNotEmitted = ~uint64_t{0};
+
+struct DedupResults {
+  std::vector<uint64_t> first_record_ids;
+  size_t num_emitted_twice;
+};
+
+static void CollectDedupResults(void* context, const uint64_t* record_ids,
+                                const uint64_t* first_record_ids,
+                                size_t num_records) {
+  DedupResults& results = *static_cast<DedupResults*>(context);
+  for (size_t i = 0; i < num_records; i++) {
+    uint64_t& first_record_id = results.first_record_ids.at(record_ids[i]);
+    if (first_record_id != kNotEmitted) {
+      results.num_emitted_twice++;
+    }
+    first_record_id = first_record_ids[i];
+  }
+}
+
+// Deduplicates records, adding them num_records_per_add at a time, and checks
+// that each record is reported along with its first copy
+static void CheckDedup(const std::vector<std::string>& records,
+                       const char* spill_dir, size_t memory_budget,
+                       SimdHwyHashThreadPool* pool,
+                       size_t num_records_per_add) {
+  std::vector<const void*> ptrs;
+  std::vector<size_t> byte_lens;
+  std::vector<uint64_t> expected_first_record_ids;
+  std::unordered_map<std::string, uint64_t> first_copies;
+  for (const std::string& record : records) {
+    ptrs.push_back(record.data());
+    byte_lens.push_back(record.size());
+    const uint64_t record_id = expected_first_record_ids.size();
+    expected_first_record_ids.push_back(
+        first_copies.emplace(record, record_id).first->second);
+  }
+
+  SimdHwyHashDedup* dedup =
+      SimdHwyHash_DedupCreate(spill_dir, kKey, memory_budget, pool);
+  ASSERT_NE(dedup, nullptr);
+  for (size_t i = 0; i < records.size(); i += num_records_per_add) {
+    const size_t n = (records.size() - i < num_records_per_add)
+                         ? records.size() - i
+                         : num_records_per_add;
+    ASSERT_NE(SimdHwyHash_DedupAdd(dedup, ptrs.data() + i,
+                                   byte_lens.data() + i, n),
+              0);
+  }
+  EXPECT_EQ(SimdHwyHash_DedupNumRecords(dedup), records.size());
+
+  DedupResults results;
+  results.first_record_ids.assign(records.size(), kNotEmitted);
+  results.num_emitted_twice = 0;
+  ASSERT_NE(SimdHwyHash_DedupFinish(dedup, CollectDedupResults, &results), 0);
+  EXPECT_EQ(results.num_emitted_twice, 0u);
+  EXPECT_EQ(results.first_record_ids, expected_first_record_ids);
+
+  // Records can no longer be added once the results have been reported
+  EXPECT_EQ(SimdHwyHash_DedupAdd(dedup, ptrs.data(), byte_lens.data(), 1), 0);
+  EXPECT_EQ(SimdHwyHash_DedupFinish(dedup, CollectDedupResults, &results), 0);
+  SimdHwyHash_DedupDestroy(dedup);
+}
+
+static std::vector<std::string> MakeRecords(size_t num_records,
+                                            size_t num_distinct) {
+  std::vector<std::string> records;
+  for (size_t i = 0; i < num_records; i++) {
+    const size_t value = (i * 7919) % num_distinct;
+    records.push_back("record " + std::to_string(value) +
+                      std::string(value % 50, '.'));
+  }
+  return records;
+}
+
+TEST(SimdHwyHashDedupTest, TestDedup) {
+  const std::vector<std::string> records = MakeRecords(100000, 30011);
+
+  CheckDedup(records, nullptr, size_t{64} << 20, nullptr, 1000000);
+  CheckDedup(records, testing::TempDir().c_str(), 0, nullptr, 777);
+
+  SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(4, 0);
+  ASSERT_NE(pool, nullptr);
+  CheckDedup(records, testing::TempDir().c_str(), size_t{1} << 20, pool,
+             100000);
+  CheckDedup(std::vector<std::string>(), nullptr, 0, pool, 1);
+  SimdHwyHash_ThreadPoolDestroy(pool);
+}
+
+TEST(SimdHwyHashDedupTest, TestManyCopies) {
+  // The copies of the same record all go to the same partition, which is too
+  // large to be sorted within the memory budget and is merged from sorted runs
+  std::vector<std::string> records = MakeRecords(20000, 5000);
+  for (size_t i = 0; i < 100000; i++) {
+    records.push_back((i % 3 == 0) ? "the same record" : "another record");
+  }
+  records.push_back("");
+
+  CheckDedup(records, testing::TempDir().c_str(), 0, nullptr, 4096);
+
+  SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(3, 0);
+  ASSERT_NE(pool, nullptr);
+  CheckDedup(records, nullptr, size_t{2} << 20, pool, 65537);
+  SimdHwyHash_ThreadPoolDestroy(pool);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
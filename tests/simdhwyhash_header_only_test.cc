@@ -0,0 +1,170 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_header_only.h"
+
+#include "simdhwyhash_constexpr.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+
+// Defined in simdhwyhash_header_only_test_tu2.cc
+uint64_t Hash64InSecondTU(const void* ptr, size_t byte_len,
+                          const uint64_t* key);
+void Hash128InSecondTU(const void* ptr, size_t byte_len, const uint64_t* key,
+                       uint64_t* hash);
+void Hash256InSecondTU(const void* ptr, size_t byte_len, const uint64_t* key,
+                       uint64_t* hash);
+void Hash64BatchInSecondTU(const void* const* ptrs, const size_t* byte_lens,
+                           size_t num_inputs, const uint64_t* key,
+                           uint64_t* hashes);
+void UpdateInSecondTU(SimdHwyHashState* state, const void* ptr,
+                      size_t byte_len);
+
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+TEST(SimdHwyHashHeaderOnlyTest, TestKnownValuesWithKey1234) {
+  static constexpr uint64_t kKey1234[4] = {1, 2, 3, 4};
+  static constexpr uint8_t kB0[33] = {
+      128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138,
+      139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149,
+      150, 151, 152, 153, 154, 155, 156, 157, 158, 159, 160};
+  static constexpr uint8_t kB1[1] = {255};
+
+  EXPECT_EQ(SimdHwyHash_Hash64(kB0, 33, kKey1234),
+            uint64_t{0x53c516cce478cad7U});
+  EXPECT_EQ(SimdHwyHash_Hash64(kB1, 1, kKey1234),
+            uint64_t{0x7858f24d2d79b2b2U});
+}
+
+TEST(SimdHwyHashHeaderOnlyTest, TestMatchesConstHash) {
+  uint8_t data[300];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 53u + 29u) & 0xFFu);
+  }
+
+  for (size_t byte_len = 0; byte_len <= sizeof(data); byte_len++) {
+    EXPECT_EQ(SimdHwyHash_Hash64(data, byte_len, kKey),
+              ConstHash64(data, byte_len, kKey));
+
+    uint64_t hash[4];
+    SimdHwyHash_Hash128(data, byte_len, kKey, hash);
+    const std::array<uint64_t, 2> expected128 =
+        ConstHash128(data, byte_len, kKey);
+    EXPECT_EQ(hash[0], expected128[0]);
+    EXPECT_EQ(hash[1], expected128[1]);
+
+    SimdHwyHash_Hash256(data, byte_len, kKey, hash);
+    const std::array<uint64_t, 4> expected256 =
+        ConstHash256(data, byte_len, kKey);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(hash[i], expected256[i]);
+    }
+  }
+
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, kKey);
+  SimdHwyHash_Update(&state, data, 64);
+  SimdHwyHash_Update(&state, data + 64, 32);
+  SimdHwyHash_Update(&state, data + 96, 45);
+  EXPECT_EQ(SimdHwyHash_Finalize64(&state), ConstHash64(data, 141, kKey));
+}
+
+TEST(SimdHwyHashHeaderOnlyTest, TestHash64Batch) {
+  static constexpr size_t kNumInputs = 23;
+
+  std::vector<uint8_t> data(kNumInputs * 40);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 7u);
+  }
+
+  const void* ptrs[kNumInputs];
+  size_t byte_lens[kNumInputs];
+  for (size_t i = 0; i < kNumInputs; i++) {
+    ptrs[i] = data.data() + i * 40;
+    byte_lens[i] = i * 3 % 41;
+  }
+
+  uint64_t hashes[kNumInputs];
+  SimdHwyHash_Hash64Batch(ptrs, byte_lens, kNumInputs, kKey, hashes);
+  for (size_t i = 0; i < kNumInputs; i++) {
+    EXPECT_EQ(hashes[i], ConstHash64(data.data() + i * 40, byte_lens[i], kKey));
+  }
+}
+
+TEST(SimdHwyHashHeaderOnlyTest, TestSecondTranslationUnit) {
+  uint8_t data[300];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 97u + 13u) & 0xFFu);
+  }
+
+  const void* ptrs[sizeof(data) + 1];
+  size_t byte_lens[sizeof(data) + 1];
+  for (size_t byte_len = 0; byte_len <= sizeof(data); byte_len++) {
+    EXPECT_EQ(Hash64InSecondTU(data, byte_len, kKey),
+              SimdHwyHash_Hash64(data, byte_len, kKey));
+
+    uint64_t hash[4];
+    uint64_t expected[4];
+    Hash128InSecondTU(data, byte_len, kKey, hash);
+    SimdHwyHash_Hash128(data, byte_len, kKey, expected);
+    EXPECT_EQ(hash[0], expected[0]);
+    EXPECT_EQ(hash[1], expected[1]);
+
+    Hash256InSecondTU(data, byte_len, kKey, hash);
+    SimdHwyHash_Hash256(data, byte_len, kKey, expected);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(hash[i], expected[i]);
+    }
+
+    ptrs[byte_len] = data;
+    byte_lens[byte_len] = byte_len;
+  }
+
+  uint64_t hashes[sizeof(data) + 1];
+  Hash64BatchInSecondTU(ptrs, byte_lens, sizeof(data) + 1, kKey, hashes);
+  for (size_t byte_len = 0; byte_len <= sizeof(data); byte_len++) {
+    EXPECT_EQ(hashes[byte_len], ConstHash64(data, byte_len, kKey));
+  }
+
+  // A state can be updated by both translation units
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, kKey);
+  UpdateInSecondTU(&state, data, 100);
+  SimdHwyHash_Update(&state, data + 100, 57);
+  UpdateInSecondTU(&state, data + 157, 143);
+  EXPECT_EQ(SimdHwyHash_Finalize64(&state), ConstHash64(data, 300, kKey));
+}
+
+TEST(SimdHwyHashHeaderOnlyTest, TestAutotuneIsDisabled) {
+  EXPECT_EQ(SimdHwyHash_Autotune(nullptr), 0);
+  EXPECT_EQ(SimdHwyHash_AutotunedTarget(100), 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,51 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The second translation unit of simdhwyhash_header_only_test, which checks
+// that the header-only build can be included by several translation units of
+// the same program
+
+#include "simdhwyhash_header_only.h"
+
+namespace simdhwyhash {
+namespace test {
+
+uint64_t Hash64InSecondTU(const void* ptr, size_t byte_len,
+                          const uint64_t* key) {
+  return SimdHwyHash_Hash64(ptr, byte_len, key);
+}
+
+void Hash128InSecondTU(const void* ptr, size_t byte_len, const uint64_t* key,
+                       uint64_t* hash) {
+  SimdHwyHash_Hash128(ptr, byte_len, key, hash);
+}
+
+void Hash256InSecondTU(const void* ptr, size_t byte_len, const uint64_t* key,
+                       uint64_t* hash) {
+  SimdHwyHash_Hash256(ptr, byte_len, key, hash);
+}
+
+void Hash64BatchInSecondTU(const void* const* ptrs, const size_t* byte_lens,
+                           size_t num_inputs, const uint64_t* key,
+                           uint64_t* hashes) {
+  SimdHwyHash_Hash64Batch(ptrs, byte_lens, num_inputs, key, hashes);
+}
+
+void UpdateInSecondTU(SimdHwyHashState* state, const void* ptr,
+                      size_t byte_len) {
+  SimdHwyHash_Update(state, ptr, byte_len);
+}
+
+}  // namespace test
+}  // namespace simdhwyhash
@@ -0,0 +1,135 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_hll.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+// Adds the 8-byte keys first_key through first_key + num_keys - 1 to hll
+static void AddKeys(SimdHwyHashHll* hll, uint64_t first_key, size_t num_keys) {
+  std::vector<uint64_t> keys(num_keys);
+  std::vector<const void*> ptrs(num_keys);
+  std::vector<size_t> byte_lens(num_keys, sizeof(uint64_t));
+  for (size_t i = 0; i < num_keys; i++) {
+    keys[i] = first_key + i;
+    ptrs[i] = &keys[i];
+  }
+  ASSERT_NE(SimdHwyHash_HllAddBatch(hll, ptrs.data(), byte_lens.data(),
+                                    num_keys),
+            0);
+}
+
+TEST(SimdHwyHashHllTest, TestEstimate) {
+  for (size_t num_keys : {size_t{1}, size_t{50}, size_t{2000},
+                          size_t{200000}}) {
+    SimdHwyHashHll hll;
+    ASSERT_NE(SimdHwyHash_HllInit(&hll, kKey, 12), 0);
+    EXPECT_EQ(SimdHwyHash_HllEstimate(&hll), 0.0);
+
+    AddKeys(&hll, 0, num_keys);
+    // Adding the same keys again must not change the estimate
+    AddKeys(&hll, 0, num_keys);
+
+    // The standard error with 4096 registers is about 1.6%
+    const double expected = static_cast<double>(num_keys);
+    EXPECT_NEAR(SimdHwyHash_HllEstimate(&hll), expected, expected * 0.05 + 1.0);
+    SimdHwyHash_HllFree(&hll);
+  }
+}
+
+TEST(SimdHwyHashHllTest, TestAddMatchesAddBatch) {
+  SimdHwyHashHll batched;
+  SimdHwyHashHll single;
+  ASSERT_NE(SimdHwyHash_HllInit(&batched, kKey, 8), 0);
+  ASSERT_NE(SimdHwyHash_HllInit(&single, kKey, 8), 0);
+
+  AddKeys(&batched, 1000, 700);
+  for (uint64_t i = 0; i < 700; i++) {
+    const uint64_t key = 1000 + i;
+    ASSERT_NE(SimdHwyHash_HllAdd(&single, &key, sizeof(key)), 0);
+  }
+
+  ASSERT_NE(batched.registers, nullptr);
+  ASSERT_NE(single.registers, nullptr);
+  for (size_t i = 0; i < 256; i++) {
+    EXPECT_EQ(batched.registers[i], single.registers[i]);
+  }
+
+  SimdHwyHash_HllFree(&batched);
+  SimdHwyHash_HllFree(&single);
+}
+
+TEST(SimdHwyHashHllTest, TestMerge) {
+  static constexpr size_t kNumShards = 6;
+
+  SimdHwyHashHll combined;
+  ASSERT_NE(SimdHwyHash_HllInit(&combined, kKey, 10), 0);
+
+  // Shards of varying sizes, so that both sparse and dense sketches are
+  // merged into both sparse and dense sketches
+  SimdHwyHashHll merged;
+  ASSERT_NE(SimdHwyHash_HllInit(&merged, kKey, 10), 0);
+  uint64_t first_key = 0;
+  for (size_t shard = 0; shard < kNumShards; shard++) {
+    const size_t num_keys = (shard % 2 == 0) ? 5 : 3000;
+
+    SimdHwyHashHll shard_hll;
+    ASSERT_NE(SimdHwyHash_HllInit(&shard_hll, kKey, 10), 0);
+    AddKeys(&shard_hll, first_key, num_keys);
+    AddKeys(&combined, first_key, num_keys);
+    ASSERT_NE(SimdHwyHash_HllMerge(&merged, &shard_hll), 0);
+    SimdHwyHash_HllFree(&shard_hll);
+
+    const double expected = SimdHwyHash_HllEstimate(&combined);
+    EXPECT_NEAR(SimdHwyHash_HllEstimate(&merged), expected, expected * 1e-9);
+    first_key += num_keys;
+  }
+
+  SimdHwyHashHll other;
+  ASSERT_NE(SimdHwyHash_HllInit(&other, kKey, 11), 0);
+  EXPECT_EQ(SimdHwyHash_HllMerge(&merged, &other), 0);
+  SimdHwyHash_HllFree(&other);
+
+  const uint64_t other_key[4] = {kKey[0], kKey[1], kKey[2], ~kKey[3]};
+  ASSERT_NE(SimdHwyHash_HllInit(&other, other_key, 10), 0);
+  EXPECT_EQ(SimdHwyHash_HllMerge(&merged, &other), 0);
+  SimdHwyHash_HllFree(&other);
+
+  SimdHwyHash_HllFree(&merged);
+  SimdHwyHash_HllFree(&combined);
+
+  EXPECT_EQ(
+      SimdHwyHash_HllInit(&other, kKey, SIMDHWYHASH_HLL_MIN_PRECISION - 1), 0);
+  EXPECT_EQ(
+      SimdHwyHash_HllInit(&other, kKey, SIMDHWYHASH_HLL_MAX_PRECISION + 1), 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
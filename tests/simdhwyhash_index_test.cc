@@ -0,0 +1,266 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_index.h"
+
+#include <stdio.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+struct IndexKey {
+  uint64_t hash[2];
+};
+
+static IndexKey MakeKey(uint64_t i) {
+  IndexKey key;
+  SimdHwyHash_Hash128(&i, sizeof(i), kKey, key.hash);
+  return key;
+}
+
+static uint64_t LocationOfKey(uint64_t i) { return i * 3 + 1; }
+
+static void ExpectKeys(const SimdHwyHashIndex* index, uint64_t begin,
+                       uint64_t end) {
+  for (uint64_t i = begin; i < end; i++) {
+    const IndexKey key = MakeKey(i);
+    uint64_t location = 0;
+    ASSERT_EQ(SimdHwyHash_IndexFind(index, key.hash, &location), 1) << i;
+    EXPECT_EQ(location, LocationOfKey(i));
+  }
+}
+
+TEST(SimdHwyHashIndexTest, TestInsertFind) {
+  static constexpr uint64_t kNumKeys = 200000;
+  const std::string path = testing::TempDir() + "simdhwyhash_index_test";
+  remove(path.c_str());
+
+  SimdHwyHashIndex* index = SimdHwyHash_IndexOpen(path.c_str(), 0);
+  ASSERT_NE(index, nullptr);
+
+  // Only a single writer may open the index
+  EXPECT_EQ(SimdHwyHash_IndexOpen(path.c_str(), 0), nullptr);
+
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    const IndexKey key = MakeKey(i);
+    ASSERT_EQ(SimdHwyHash_IndexInsert(index, key.hash, LocationOfKey(i)), 1);
+  }
+  EXPECT_EQ(SimdHwyHash_IndexCount(index), kNumKeys);
+
+  // Inserting a hash again keeps its existing location
+  for (uint64_t i = 0; i < kNumKeys; i += 97) {
+    const IndexKey key = MakeKey(i);
+    EXPECT_EQ(SimdHwyHash_IndexInsert(index, key.hash, 0), 0);
+  }
+  EXPECT_EQ(SimdHwyHash_IndexCount(index), kNumKeys);
+  ExpectKeys(index, 0, kNumKeys);
+
+  for (uint64_t i = kNumKeys; i < kNumKeys + 1000; i++) {
+    const IndexKey key = MakeKey(i);
+    uint64_t location = 0;
+    EXPECT_EQ(SimdHwyHash_IndexFind(index, key.hash, &location), 0);
+  }
+  EXPECT_NE(SimdHwyHash_IndexClose(index), 0);
+
+  // The entries persist, and a read-only handle rejects inserts
+  SimdHwyHashIndex* reader =
+      SimdHwyHash_IndexOpen(path.c_str(), SIMDHWYHASH_INDEX_READ_ONLY);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(SimdHwyHash_IndexCount(reader), kNumKeys);
+  ExpectKeys(reader, 0, kNumKeys);
+  const IndexKey new_key = MakeKey(kNumKeys);
+  EXPECT_EQ(SimdHwyHash_IndexInsert(reader, new_key.hash, 1), -1);
+
+  // A writer can open the index while there are readers
+  index = SimdHwyHash_IndexOpen(path.c_str(), SIMDHWYHASH_INDEX_DURABLE);
+  ASSERT_NE(index, nullptr);
+  for (uint64_t i = kNumKeys; i < kNumKeys + 20000; i++) {
+    const IndexKey key = MakeKey(i);
+    ASSERT_EQ(SimdHwyHash_IndexInsert(index, key.hash, LocationOfKey(i)), 1);
+  }
+  EXPECT_EQ(SimdHwyHash_IndexCount(index), kNumKeys + 20000);
+  EXPECT_NE(SimdHwyHash_IndexSync(index), 0);
+
+  // The reader sees the new entries, including those in pages that were
+  // added to the file after it was opened
+  ExpectKeys(reader, 0, kNumKeys + 20000);
+
+  EXPECT_NE(SimdHwyHash_IndexClose(reader), 0);
+  EXPECT_NE(SimdHwyHash_IndexClose(index), 0);
+  remove(path.c_str());
+}
+
+TEST(SimdHwyHashIndexTest, TestConcurrentReaders) {
+  static constexpr uint64_t kNumKeys = 100000;
+  static constexpr size_t kNumReaders = 4;
+  const std::string path = testing::TempDir() + "simdhwyhash_index_mt_test";
+  remove(path.c_str());
+
+  SimdHwyHashIndex* index = SimdHwyHash_IndexOpen(path.c_str(), 0);
+  ASSERT_NE(index, nullptr);
+  SimdHwyHashIndex* reader =
+      SimdHwyHash_IndexOpen(path.c_str(), SIMDHWYHASH_INDEX_READ_ONLY);
+  ASSERT_NE(reader, nullptr);
+
+  // The readers look up keys that have already been inserted while the writer
+  // inserts more keys and splits buckets
+  std::atomic<uint64_t> num_inserted{0};
+  std::atomic<uint64_t> num_errors{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumReaders; t++) {
+    threads.emplace_back([&, t] {
+      uint64_t i = t;
+      for (;;) {
+        const uint64_t n = num_inserted.load(std::memory_order_acquire);
+        if (n == 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        const IndexKey key = MakeKey(i % n);
+        uint64_t location = 0;
+        if (SimdHwyHash_IndexFind((t & 1) ? reader : index, key.hash,
+                                  &location) != 1 ||
+            location != LocationOfKey(i % n)) {
+          num_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (n == kNumKeys) {
+          break;
+        }
+        i = i * 6364136223846793005u + 1442695040888963407u;
+      }
+    });
+  }
+
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    const IndexKey key = MakeKey(i);
+    ASSERT_EQ(SimdHwyHash_IndexInsert(index, key.hash, LocationOfKey(i)), 1);
+    num_inserted.store(i + 1, std::memory_order_release);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_errors.load(), 0u);
+
+  EXPECT_NE(SimdHwyHash_IndexClose(reader), 0);
+  EXPECT_NE(SimdHwyHash_IndexClose(index), 0);
+  remove(path.c_str());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(SimdHwyHashIndexTest, TestRecoverAfterKill) {
+  static constexpr int kNumTrials = 8;
+  const std::string path = testing::TempDir() + "simdhwyhash_index_kill_test";
+
+  // The writer process stores the number of keys that it has inserted in
+  // shared memory, so that the keys that must be found after it is killed
+  // are known
+  void* shared = mmap(nullptr, sizeof(std::atomic<uint64_t>),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1,
+                      0);
+  ASSERT_NE(shared, MAP_FAILED);
+  std::atomic<uint64_t>* num_inserted = new (shared) std::atomic<uint64_t>(0);
+
+  for (int trial = 0; trial < kNumTrials; trial++) {
+    const unsigned flags = (trial & 1) ? SIMDHWYHASH_INDEX_DURABLE : 0u;
+    remove(path.c_str());
+    num_inserted->store(0, std::memory_order_relaxed);
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      SimdHwyHashIndex* index = SimdHwyHash_IndexOpen(path.c_str(), flags);
+      for (uint64_t i = 0; index; i++) {
+        const IndexKey key = MakeKey(i);
+        if (SimdHwyHash_IndexInsert(index, key.hash, LocationOfKey(i)) != 1) {
+          break;
+        }
+        num_inserted->store(i + 1, std::memory_order_release);
+      }
+      _exit(1);
+    }
+
+    // Kill the writer at a different point of its inserts and splits in each
+    // trial
+    const uint64_t min_inserted = 2000 + static_cast<uint64_t>(trial) * 1500;
+    while (num_inserted->load(std::memory_order_acquire) < min_inserted) {
+      usleep(100);
+    }
+    usleep(static_cast<useconds_t>(trial) * 1000);
+    ASSERT_EQ(kill(pid, SIGKILL), 0);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFSIGNALED(status));
+
+    // Every key whose insert returned is found, the key that was being
+    // inserted may or may not be found, and the count of the reopened index
+    // matches the keys that are found
+    const uint64_t n = num_inserted->load(std::memory_order_acquire);
+    SimdHwyHashIndex* index = SimdHwyHash_IndexOpen(path.c_str(), flags);
+    ASSERT_NE(index, nullptr);
+    ExpectKeys(index, 0, n);
+    const IndexKey last_key = MakeKey(n);
+    uint64_t location = 0;
+    const int last_found =
+        SimdHwyHash_IndexFind(index, last_key.hash, &location);
+    ASSERT_GE(last_found, 0);
+    EXPECT_EQ(SimdHwyHash_IndexCount(index),
+              n + static_cast<uint64_t>(last_found)) << trial;
+    for (uint64_t i = n + 1; i < n + 100; i++) {
+      const IndexKey key = MakeKey(i);
+      EXPECT_EQ(SimdHwyHash_IndexFind(index, key.hash, &location), 0);
+    }
+
+    // The recovered index keeps growing
+    for (uint64_t i = n; i < n + 5000; i++) {
+      const IndexKey key = MakeKey(i);
+      ASSERT_NE(SimdHwyHash_IndexInsert(index, key.hash, LocationOfKey(i)), -1);
+    }
+    EXPECT_EQ(SimdHwyHash_IndexCount(index), n + 5000);
+    ExpectKeys(index, 0, n + 5000);
+    EXPECT_NE(SimdHwyHash_IndexClose(index), 0);
+  }
+
+  munmap(shared, sizeof(std::atomic<uint64_t>));
+  remove(path.c_str());
+}
+#endif  // defined(__unix__) || defined(__APPLE__)
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_interner.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static std::string MakeToken(size_t i) {
+  std::string token = "ident_" + std::to_string(i);
+  if (i % 1000 == 7) {
+    // Longer than an arena chunk
+    token.append((size_t{1} << 20) + i, 'z');
+  } else if (i % 10 == 3) {
+    token.append(50, 'x');
+  }
+  return token;
+}
+
+static void ExpectInterned(const SimdHwyHashInterner* interner, uint32_t id,
+                           const std::string& token) {
+  size_t byte_len = 0;
+  const void* ptr = SimdHwyHash_InternerGet(interner, id, &byte_len);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(byte_len, token.size());
+  EXPECT_EQ(memcmp(ptr, token.data(), byte_len), 0);
+}
+
+TEST(SimdHwyHashInternerTest, TestIntern) {
+  static constexpr size_t kNumTokens = 20000;
+
+  SimdHwyHashInterner* interner = SimdHwyHash_InternerCreate(kKey, 0);
+  ASSERT_NE(interner, nullptr);
+
+  std::vector<std::string> tokens(kNumTokens);
+  for (size_t i = 0; i < kNumTokens; i++) {
+    tokens[i] = MakeToken(i);
+    EXPECT_EQ(SimdHwyHash_Intern(interner, tokens[i].data(), tokens[i].size()),
+              static_cast<uint32_t>(i));
+  }
+  EXPECT_EQ(SimdHwyHash_InternerCount(interner), kNumTokens);
+
+  // Interning a string again returns its existing ID, and the bytes of the
+  // interned strings are not moved as the interner grows
+  size_t first_len = 0;
+  const void* first_ptr = SimdHwyHash_InternerGet(interner, 0, &first_len);
+  for (size_t i = 0; i < kNumTokens; i++) {
+    const std::string copy = tokens[i];
+    EXPECT_EQ(SimdHwyHash_Intern(interner, copy.data(), copy.size()),
+              static_cast<uint32_t>(i));
+    EXPECT_EQ(SimdHwyHash_InternerFind(interner, copy.data(), copy.size()),
+              static_cast<uint32_t>(i));
+    ExpectInterned(interner, static_cast<uint32_t>(i), tokens[i]);
+  }
+  EXPECT_EQ(SimdHwyHash_InternerCount(interner), kNumTokens);
+  size_t len = 0;
+  EXPECT_EQ(SimdHwyHash_InternerGet(interner, 0, &len), first_ptr);
+
+  EXPECT_EQ(SimdHwyHash_InternerFind(interner, "missing", 7),
+            SIMDHWYHASH_INTERNER_INVALID_ID);
+  EXPECT_EQ(SimdHwyHash_InternerGet(interner, kNumTokens, &len), nullptr);
+
+  // The empty string is interned like any other string
+  const uint32_t empty_id = SimdHwyHash_Intern(interner, "", 0);
+  EXPECT_EQ(empty_id, static_cast<uint32_t>(kNumTokens));
+  EXPECT_EQ(SimdHwyHash_Intern(interner, nullptr, 0), empty_id);
+  ExpectInterned(interner, empty_id, std::string());
+
+  SimdHwyHash_InternerDestroy(interner);
+}
+
+TEST(SimdHwyHashInternerTest, TestInternBatch) {
+  static constexpr size_t kNumTokens = 3000;
+
+  // Every token appears twice, so that duplicates within a batch and across
+  // batches get the same ID
+  std::vector<std::string> tokens(kNumTokens * 2);
+  std::vector<const void*> ptrs(kNumTokens * 2);
+  std::vector<size_t> byte_lens(kNumTokens * 2);
+  for (size_t i = 0; i < kNumTokens * 2; i++) {
+    tokens[i] = MakeToken((i * 7) % kNumTokens);
+    ptrs[i] = tokens[i].data();
+    byte_lens[i] = tokens[i].size();
+  }
+
+  SimdHwyHashInterner* batch_interner =
+      SimdHwyHash_InternerCreate(kKey, kNumTokens);
+  ASSERT_NE(batch_interner, nullptr);
+  SimdHwyHashInterner* interner = SimdHwyHash_InternerCreate(kKey, 0);
+  ASSERT_NE(interner, nullptr);
+
+  std::vector<uint32_t> ids(kNumTokens * 2);
+  ASSERT_NE(SimdHwyHash_InternBatch(batch_interner, ptrs.data(),
+                                    byte_lens.data(), kNumTokens * 2,
+                                    ids.data()),
+            0);
+  EXPECT_EQ(SimdHwyHash_InternerCount(batch_interner), kNumTokens);
+
+  for (size_t i = 0; i < kNumTokens * 2; i++) {
+    EXPECT_EQ(ids[i], SimdHwyHash_Intern(interner, ptrs[i], byte_lens[i]));
+    ExpectInterned(batch_interner, ids[i], tokens[i]);
+  }
+
+  SimdHwyHash_InternerDestroy(interner);
+  SimdHwyHash_InternerDestroy(batch_interner);
+}
+
+TEST(SimdHwyHashInternerTest, TestSnapshot) {
+  static constexpr size_t kNumTokens = 5000;
+
+  SimdHwyHashInterner* interner = SimdHwyHash_InternerCreate(kKey, 0);
+  ASSERT_NE(interner, nullptr);
+  std::vector<std::string> tokens(kNumTokens);
+  for (size_t i = 0; i < kNumTokens; i++) {
+    tokens[i] = "token-" + std::to_string(i * 31);
+    ASSERT_EQ(SimdHwyHash_Intern(interner, tokens[i].data(), tokens[i].size()),
+              static_cast<uint32_t>(i));
+  }
+
+  // Query the snapshot at an odd address, as if it had been memory-mapped
+  // from a file
+  const size_t size = SimdHwyHash_InternerSnapshotSize(interner);
+  std::vector<uint8_t> buffer(size + 1);
+  EXPECT_EQ(SimdHwyHash_InternerWriteSnapshot(interner, buffer.data() + 1,
+                                              size - 1),
+            0u);
+  ASSERT_EQ(SimdHwyHash_InternerWriteSnapshot(interner, buffer.data() + 1,
+                                              size),
+            size);
+  SimdHwyHash_InternerDestroy(interner);
+
+  SimdHwyHashInternerSnapshot snapshot;
+  ASSERT_NE(SimdHwyHash_InternerSnapshotLoad(&snapshot, buffer.data() + 1,
+                                             size),
+            0);
+  EXPECT_EQ(snapshot.num_strings, kNumTokens);
+  for (size_t i = 0; i < kNumTokens; i++) {
+    EXPECT_EQ(SimdHwyHash_InternerSnapshotFind(&snapshot, tokens[i].data(),
+                                               tokens[i].size()),
+              static_cast<uint32_t>(i));
+
+    size_t byte_len = 0;
+    const void* ptr = SimdHwyHash_InternerSnapshotGet(
+        &snapshot, static_cast<uint32_t>(i), &byte_len);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(byte_len, tokens[i].size());
+    EXPECT_EQ(memcmp(ptr, tokens[i].data(), byte_len), 0);
+  }
+  EXPECT_EQ(SimdHwyHash_InternerSnapshotFind(&snapshot, "token-1", 7),
+            SIMDHWYHASH_INTERNER_INVALID_ID);
+
+  // Truncated or corrupted snapshots are rejected
+  EXPECT_EQ(SimdHwyHash_InternerSnapshotLoad(&snapshot, buffer.data() + 1,
+                                             size - 1),
+            0);
+  buffer[1] ^= 1;
+  EXPECT_EQ(SimdHwyHash_InternerSnapshotLoad(&snapshot, buffer.data() + 1,
+                                             size),
+            0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,145 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_minhash.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static std::vector<uint8_t> MakeDocument(size_t len, uint32_t seed) {
+  std::vector<uint8_t> doc(len);
+  uint32_t x = seed;
+  for (size_t i = 0; i < len; i++) {
+    x = x * 1103515245u + 12345u;
+    doc[i] = static_cast<uint8_t>(x >> 24);
+  }
+  return doc;
+}
+
+TEST(SimdHwyHashMinHashTest, TestSignature) {
+  static constexpr size_t kNumPerms = 37;
+  static constexpr size_t kShingleLen = 9;
+
+  SimdHwyHashMinHasher hasher;
+  ASSERT_NE(SimdHwyHash_MinHashInit(&hasher, kKey, kNumPerms, kShingleLen), 0);
+
+  for (size_t byte_len : {size_t{0}, size_t{3}, size_t{9}, size_t{300}}) {
+    const std::vector<uint8_t> doc = MakeDocument(byte_len, 1);
+
+    uint32_t signature[kNumPerms];
+    SimdHwyHash_MinHashSignature(&hasher, doc.data(), doc.size(), signature);
+
+    uint64_t expected[kNumPerms];
+    for (size_t i = 0; i < kNumPerms; i++) {
+      expected[i] = 0xFFFFFFFFu;
+    }
+
+    const size_t shingle_len =
+        (byte_len < kShingleLen) ? byte_len : kShingleLen;
+    for (size_t j = 0; byte_len != 0 && j + shingle_len <= byte_len; j++) {
+      const uint64_t h = SimdHwyHash_Hash64(doc.data() + j, shingle_len, kKey);
+      for (size_t i = 0; i < kNumPerms; i++) {
+        const uint64_t permuted =
+            (hasher.coeffs[i] * h + hasher.coeffs[kNumPerms + i]) >> 32;
+        expected[i] = (permuted < expected[i]) ? permuted : expected[i];
+      }
+    }
+
+    for (size_t i = 0; i < kNumPerms; i++) {
+      EXPECT_EQ(signature[i], static_cast<uint32_t>(expected[i]));
+    }
+  }
+
+  SimdHwyHash_MinHashFree(&hasher);
+
+  EXPECT_EQ(SimdHwyHash_MinHashInit(&hasher, kKey, 0, kShingleLen), 0);
+  EXPECT_EQ(SimdHwyHash_MinHashInit(&hasher, kKey,
+                                    SIMDHWYHASH_MINHASH_MAX_PERMS + 1,
+                                    kShingleLen),
+            0);
+  EXPECT_EQ(SimdHwyHash_MinHashInit(&hasher, kKey, kNumPerms, 0), 0);
+}
+
+TEST(SimdHwyHashMinHashTest, TestJaccard) {
+  static constexpr size_t kNumPerms = 256;
+  static constexpr size_t kShingleLen = 8;
+
+  SimdHwyHashMinHasher hasher;
+  ASSERT_NE(SimdHwyHash_MinHashInit(&hasher, kKey, kNumPerms, kShingleLen), 0);
+
+  // doc_b shares its first half with doc_a
+  const std::vector<uint8_t> doc_a = MakeDocument(2000, 1);
+  std::vector<uint8_t> doc_b = MakeDocument(2000, 2);
+  std::copy(doc_a.begin(), doc_a.begin() + 1000, doc_b.begin());
+
+  std::set<std::string> shingles_a;
+  std::set<std::string> shingles_b;
+  for (size_t j = 0; j + kShingleLen <= doc_a.size(); j++) {
+    shingles_a.emplace(reinterpret_cast<const char*>(doc_a.data() + j),
+                       kShingleLen);
+    shingles_b.emplace(reinterpret_cast<const char*>(doc_b.data() + j),
+                       kShingleLen);
+  }
+  size_t num_common = 0;
+  for (const std::string& shingle : shingles_a) {
+    num_common += shingles_b.count(shingle);
+  }
+  const double expected_jaccard =
+      static_cast<double>(num_common) /
+      static_cast<double>(shingles_a.size() + shingles_b.size() - num_common);
+
+  uint32_t signature_a[kNumPerms];
+  uint32_t signature_b[kNumPerms];
+  SimdHwyHash_MinHashSignature(&hasher, doc_a.data(), doc_a.size(),
+                               signature_a);
+  SimdHwyHash_MinHashSignature(&hasher, doc_b.data(), doc_b.size(),
+                               signature_b);
+
+  EXPECT_EQ(SimdHwyHash_MinHashJaccard(signature_a, signature_a, kNumPerms),
+            1.0);
+  EXPECT_NEAR(SimdHwyHash_MinHashJaccard(signature_a, signature_b, kNumPerms),
+              expected_jaccard, 0.1);
+
+  size_t num_equal = 0;
+  for (size_t i = 0; i < 37; i++) {
+    if (signature_a[i] == signature_b[i]) {
+      num_equal++;
+    }
+  }
+  EXPECT_EQ(SimdHwyHash_MinHashJaccard(signature_a, signature_b, 37),
+            static_cast<double>(num_equal) / 37.0);
+
+  SimdHwyHash_MinHashFree(&hasher);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
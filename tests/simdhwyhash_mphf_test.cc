@@ -0,0 +1,187 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_mphf.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+struct KeySet {
+  std::vector<std::string> strings;
+  std::vector<const void*> ptrs;
+  std::vector<size_t> byte_lens;
+};
+
+static void MakeKeySet(size_t num_keys, KeySet& key_set) {
+  key_set.strings.resize(num_keys);
+  key_set.ptrs.resize(num_keys);
+  key_set.byte_lens.resize(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    key_set.strings[i] = "key-" + std::to_string(i * 7919);
+    if (i % 10 == 0) {
+      key_set.strings[i].append(40, 'x');
+    }
+    key_set.ptrs[i] = key_set.strings[i].data();
+    key_set.byte_lens[i] = key_set.strings[i].size();
+  }
+}
+
+// Checks that mphf maps the keys of key_set to distinct indices
+static void ExpectMinimalPerfect(const SimdHwyHashMphf& mphf,
+                                 const KeySet& key_set) {
+  const size_t num_keys = key_set.strings.size();
+  ASSERT_EQ(mphf.num_keys, num_keys);
+
+  std::vector<bool> seen(num_keys, false);
+  for (size_t i = 0; i < num_keys; i++) {
+    const uint64_t idx =
+        SimdHwyHash_MphfLookup(&mphf, key_set.ptrs[i], key_set.byte_lens[i]);
+    ASSERT_LT(idx, num_keys) << "i=" << i;
+    ASSERT_FALSE(seen[idx]) << "i=" << i;
+    seen[idx] = true;
+  }
+}
+
+TEST(SimdHwyHashMphfTest, TestBuildAndLookup) {
+  static constexpr size_t kNumKeys = 200000;
+  KeySet key_set;
+  MakeKeySet(kNumKeys, key_set);
+
+  SimdHwyHashMphf mphf;
+  ASSERT_NE(SimdHwyHash_MphfBuild(&mphf, key_set.ptrs.data(),
+                                  key_set.byte_lens.data(), kNumKeys, kKey, 0.0,
+                                  nullptr),
+            0);
+  ExpectMinimalPerfect(mphf, key_set);
+
+  // The default gamma of 1 takes a little over 3 bits per key, plus 1 bit for
+  // every 8 bits for the ranks
+  EXPECT_LT(static_cast<double>(mphf.size) * 8.0 / kNumKeys, 4.0);
+
+  // Building with a thread pool must give exactly the same MPHF
+  for (size_t num_threads : {size_t{2}, size_t{5}}) {
+    SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(num_threads, 0);
+    ASSERT_NE(pool, nullptr);
+
+    SimdHwyHashMphf parallel_mphf;
+    ASSERT_NE(SimdHwyHash_MphfBuild(&parallel_mphf, key_set.ptrs.data(),
+                                    key_set.byte_lens.data(), kNumKeys, kKey,
+                                    0.0, pool),
+              0);
+    ASSERT_EQ(parallel_mphf.size, mphf.size);
+    EXPECT_EQ(memcmp(parallel_mphf.data, mphf.data, mphf.size), 0);
+
+    SimdHwyHash_MphfFree(&parallel_mphf);
+    SimdHwyHash_ThreadPoolDestroy(pool);
+  }
+
+  SimdHwyHash_MphfFree(&mphf);
+
+  // A larger gamma gives fewer levels at the cost of more space
+  ASSERT_NE(SimdHwyHash_MphfBuild(&mphf, key_set.ptrs.data(),
+                                  key_set.byte_lens.data(), kNumKeys, kKey, 2.0,
+                                  nullptr),
+            0);
+  ExpectMinimalPerfect(mphf, key_set);
+  SimdHwyHash_MphfFree(&mphf);
+}
+
+TEST(SimdHwyHashMphfTest, TestLoad) {
+  static constexpr size_t kNumKeys = 5000;
+  KeySet key_set;
+  MakeKeySet(kNumKeys, key_set);
+
+  SimdHwyHashMphf built;
+  ASSERT_NE(SimdHwyHash_MphfBuild(&built, key_set.ptrs.data(),
+                                  key_set.byte_lens.data(), kNumKeys, kKey, 1.5,
+                                  nullptr),
+            0);
+
+  // Query a copy of the serialized MPHF at an odd address, as if it had been
+  // memory-mapped from a file
+  std::vector<uint8_t> buffer(built.size + 1);
+  memcpy(buffer.data() + 1, built.data, built.size);
+
+  SimdHwyHashMphf loaded;
+  ASSERT_NE(SimdHwyHash_MphfLoad(&loaded, buffer.data() + 1, built.size), 0);
+  EXPECT_EQ(loaded.owned_data, nullptr);
+  for (size_t i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(SimdHwyHash_MphfLookup(&loaded, key_set.ptrs[i],
+                                     key_set.byte_lens[i]),
+              SimdHwyHash_MphfLookup(&built, key_set.ptrs[i],
+                                     key_set.byte_lens[i]));
+  }
+  SimdHwyHash_MphfFree(&loaded);
+
+  EXPECT_EQ(SimdHwyHash_MphfLoad(&loaded, buffer.data() + 1, built.size - 8),
+            0);
+  buffer[1] ^= 1;
+  EXPECT_EQ(SimdHwyHash_MphfLoad(&loaded, buffer.data() + 1, built.size), 0);
+
+  SimdHwyHash_MphfFree(&built);
+}
+
+TEST(SimdHwyHashMphfTest, TestEdgeCases) {
+  SimdHwyHashMphf mphf;
+  ASSERT_NE(SimdHwyHash_MphfBuild(&mphf, nullptr, nullptr, 0, kKey, 0.0,
+                                  nullptr),
+            0);
+  EXPECT_EQ(SimdHwyHash_MphfLookup(&mphf, "abc", 3), 0u);
+  SimdHwyHash_MphfFree(&mphf);
+
+  const char* const kOneKey = "only";
+  const void* one_ptr = kOneKey;
+  const size_t one_len = 4;
+  ASSERT_NE(SimdHwyHash_MphfBuild(&mphf, &one_ptr, &one_len, 1, kKey, 0.0,
+                                  nullptr),
+            0);
+  EXPECT_EQ(SimdHwyHash_MphfLookup(&mphf, kOneKey, one_len), 0u);
+  SimdHwyHash_MphfFree(&mphf);
+
+  // Duplicate keys cannot be given distinct indices
+  KeySet key_set;
+  MakeKeySet(1000, key_set);
+  key_set.ptrs[500] = key_set.ptrs[20];
+  key_set.byte_lens[500] = key_set.byte_lens[20];
+  EXPECT_EQ(SimdHwyHash_MphfBuild(&mphf, key_set.ptrs.data(),
+                                  key_set.byte_lens.data(), 1000, kKey, 0.0,
+                                  nullptr),
+            0);
+
+  EXPECT_EQ(SimdHwyHash_MphfBuild(&mphf, key_set.ptrs.data(),
+                                  key_set.byte_lens.data(), 10, kKey, 0.5,
+                                  nullptr),
+            0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
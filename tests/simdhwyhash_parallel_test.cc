@@ -0,0 +1,151 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_parallel.h"
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static constexpr unsigned kPoolFlags[] = {
+    0u, SIMDHWYHASH_THREAD_POOL_PIN_THREADS,
+    SIMDHWYHASH_THREAD_POOL_PIN_THREADS | SIMDHWYHASH_THREAD_POOL_NUMA_LOCAL};
+
+TEST(SimdHwyHashParallelTest, TestParallelHash64Batch) {
+  // A few large inputs among many small ones, so that splitting by count
+  // would leave most of the bytes to a single worker
+  static constexpr size_t kNumInputs = 3000;
+  std::vector<uint8_t> bytes(3 * 1048576 + 100000);
+  for (size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<uint8_t>((i * 131) ^ (i >> 8));
+  }
+
+  std::vector<const void*> ptrs(kNumInputs);
+  std::vector<size_t> byte_lens(kNumInputs);
+  size_t offset = 0;
+  for (size_t i = 0; i < kNumInputs; i++) {
+    byte_lens[i] = (i % 1000 == 17) ? 1048576 + i : i % 33;
+    ptrs[i] = bytes.data() + offset;
+    offset += byte_lens[i];
+  }
+  ASSERT_LE(offset, bytes.size());
+
+  std::vector<uint64_t> expected(kNumInputs);
+  for (size_t i = 0; i < kNumInputs; i++) {
+    expected[i] = SimdHwyHash_Hash64(ptrs[i], byte_lens[i], kKey);
+  }
+
+  for (size_t num_threads : {size_t{1}, size_t{2}, size_t{4}, size_t{7}}) {
+    for (unsigned flags : kPoolFlags) {
+      SimdHwyHashThreadPool* pool =
+          SimdHwyHash_ThreadPoolCreate(num_threads, flags);
+      ASSERT_NE(pool, nullptr);
+      EXPECT_EQ(SimdHwyHash_ThreadPoolNumThreads(pool), num_threads);
+
+      // Run several batches on the same pool to check that it can be reused
+      for (size_t num_inputs : {kNumInputs, size_t{0}, size_t{1}, size_t{40}}) {
+        std::vector<uint64_t> hashes(num_inputs + 1, 0);
+        ASSERT_NE(SimdHwyHash_ParallelHash64Batch(pool, ptrs.data(),
+                                                  byte_lens.data(), num_inputs,
+                                                  kKey, hashes.data()),
+                  0);
+        for (size_t i = 0; i < num_inputs; i++) {
+          EXPECT_EQ(hashes[i], expected[i])
+              << "num_threads=" << num_threads << ", i=" << i;
+        }
+        EXPECT_EQ(hashes[num_inputs], 0u);
+      }
+
+      SimdHwyHash_ThreadPoolDestroy(pool);
+    }
+  }
+}
+
+TEST(SimdHwyHashParallelTest, TestParallelHashU64Keys64) {
+  static constexpr size_t kNumKeys = 200003;
+  std::vector<uint64_t> keys(kNumKeys);
+  for (size_t i = 0; i < kNumKeys; i++) {
+    keys[i] = i * 0x9E3779B97F4A7C15U;
+  }
+
+  std::vector<uint64_t> expected(kNumKeys);
+  SimdHwyHash_HashU64Keys64(keys.data(), kNumKeys, kKey, expected.data());
+
+  for (size_t num_threads : {size_t{1}, size_t{3}, size_t{8}}) {
+    SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(num_threads, 0);
+    ASSERT_NE(pool, nullptr);
+
+    for (size_t num_keys : {kNumKeys, size_t{0}, size_t{5}, size_t{4097}}) {
+      std::vector<uint64_t> hashes(num_keys + 1, 0);
+      ASSERT_NE(SimdHwyHash_ParallelHashU64Keys64(pool, keys.data(), num_keys,
+                                                  kKey, hashes.data()),
+                0);
+      for (size_t i = 0; i < num_keys; i++) {
+        EXPECT_EQ(hashes[i], expected[i])
+            << "num_threads=" << num_threads << ", i=" << i;
+      }
+      EXPECT_EQ(hashes[num_keys], 0u);
+    }
+
+    SimdHwyHash_ThreadPoolDestroy(pool);
+  }
+
+  SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(0, 0);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_GE(SimdHwyHash_ThreadPoolNumThreads(pool), 1u);
+  SimdHwyHash_ThreadPoolDestroy(pool);
+}
+
+static void CountTaskRuns(void* context, size_t task_index) {
+  std::atomic<int>* run_counts = static_cast<std::atomic<int>*>(context);
+  run_counts[task_index].fetch_add(1, std::memory_order_relaxed);
+}
+
+TEST(SimdHwyHashParallelTest, TestThreadPoolRun) {
+  static constexpr size_t kNumTasks = 10007;
+  for (size_t num_threads : {size_t{1}, size_t{4}}) {
+    SimdHwyHashThreadPool* pool = SimdHwyHash_ThreadPoolCreate(num_threads, 0);
+    ASSERT_NE(pool, nullptr);
+
+    for (size_t num_tasks : {size_t{0}, size_t{1}, size_t{3}, kNumTasks}) {
+      std::vector<std::atomic<int>> run_counts(kNumTasks);
+      SimdHwyHash_ThreadPoolRun(pool, num_tasks, CountTaskRuns,
+                                run_counts.data());
+      for (size_t i = 0; i < kNumTasks; i++) {
+        EXPECT_EQ(run_counts[i].load(), (i < num_tasks) ? 1 : 0)
+            << "num_tasks=" << num_tasks << ", i=" << i;
+      }
+    }
+
+    SimdHwyHash_ThreadPoolDestroy(pool);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_partition.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+TEST(SimdHwyHashPartitionTest, TestPartition) {
+  static constexpr size_t kNumKeys = 1000;
+  static constexpr uint32_t kNumPartitions = 7;
+
+  std::vector<uint64_t> keys(kNumKeys);
+  for (size_t i = 0; i < kNumKeys; i++) {
+    keys[i] = uint64_t{i} * 0x9E3779B97F4A7C15u;
+  }
+
+  std::vector<uint64_t> hashes(kNumKeys);
+  SimdHwyHash_HashU64Keys64(keys.data(), kNumKeys, kKey, hashes.data());
+
+  std::vector<uint32_t> partition_ids(kNumKeys);
+  size_t histogram[kNumPartitions];
+  ASSERT_NE(SimdHwyHash_Partition(keys.data(), kNumKeys, kKey, kNumPartitions,
+                                  partition_ids.data(), histogram),
+            0);
+
+  size_t expected_histogram[kNumPartitions] = {};
+  for (size_t i = 0; i < kNumKeys; i++) {
+    const uint32_t expected_partition_id = static_cast<uint32_t>(
+        ((hashes[i] >> 32) * kNumPartitions) >> 32);
+    EXPECT_EQ(partition_ids[i], expected_partition_id);
+    expected_histogram[expected_partition_id]++;
+  }
+
+  for (uint32_t p = 0; p < kNumPartitions; p++) {
+    EXPECT_EQ(histogram[p], expected_histogram[p]);
+    // Each partition should receive roughly kNumKeys / kNumPartitions keys
+    EXPECT_GT(histogram[p], kNumKeys / kNumPartitions / 2);
+  }
+}
+
+TEST(SimdHwyHashPartitionTest, TestPartitionZeroPartitions) {
+  static constexpr size_t kNumKeys = 3;
+  static constexpr uint64_t kKeys[kNumKeys] = {1, 2, 3};
+
+  // Neither partition_ids nor histogram may be written to
+  uint32_t partition_ids[kNumKeys] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu};
+  size_t histogram[1] = {12345};
+  EXPECT_EQ(SimdHwyHash_Partition(kKeys, kNumKeys, kKey, 0, partition_ids,
+                                  histogram),
+            0);
+  for (size_t i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(partition_ids[i], 0xFFFFFFFFu);
+  }
+  EXPECT_EQ(histogram[0], size_t{12345});
+}
+
+TEST(SimdHwyHashPartitionTest, TestPartitionScatter) {
+  for (uint32_t num_partitions : {1u, 3u, 16u, 300u}) {
+    for (size_t num_keys : {size_t{0}, size_t{5}, size_t{64}, size_t{2047}}) {
+      std::vector<uint64_t> keys(num_keys);
+      for (size_t i = 0; i < num_keys; i++) {
+        keys[i] = (uint64_t{i} << 32) | (i * 7919u);
+      }
+
+      std::vector<uint32_t> partition_ids(num_keys);
+      std::vector<size_t> histogram(num_partitions);
+      ASSERT_NE(SimdHwyHash_Partition(keys.data(), num_keys, kKey,
+                                      num_partitions, partition_ids.data(),
+                                      histogram.data()),
+                0);
+
+      std::vector<uint64_t> out(num_keys);
+      ASSERT_NE(SimdHwyHash_PartitionScatter(keys.data(), num_keys,
+                                             partition_ids.data(),
+                                             histogram.data(), num_partitions,
+                                             out.data()),
+                0);
+
+      // Each partition must be contiguous and hold its keys in input order
+      std::vector<size_t> next_offsets(num_partitions);
+      size_t start_offset = 0;
+      for (uint32_t p = 0; p < num_partitions; p++) {
+        next_offsets[p] = start_offset;
+        start_offset += histogram[p];
+      }
+      ASSERT_EQ(start_offset, num_keys);
+
+      for (size_t i = 0; i < num_keys; i++) {
+        EXPECT_EQ(out[next_offsets[partition_ids[i]]++], keys[i]);
+      }
+    }
+  }
+
+  EXPECT_EQ(SimdHwyHash_PartitionScatter(nullptr, 0, nullptr, nullptr, 0,
+                                         nullptr),
+            0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
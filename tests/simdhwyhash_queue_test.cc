@@ -0,0 +1,164 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_queue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+struct JobResult {
+  std::atomic<uint64_t> hash{0};
+  std::atomic<int> num_calls{0};
+};
+
+static void StoreJobResult(void* user_data, uint64_t hash) {
+  JobResult* result = static_cast<JobResult*>(user_data);
+  result->hash.store(hash, std::memory_order_relaxed);
+  result->num_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+TEST(SimdHwyHashQueueTest, TestSubmit) {
+  static constexpr size_t kNumSubmitters = 4;
+  static constexpr size_t kJobsPerSubmitter = 2500;
+  static constexpr size_t kNumJobs = kNumSubmitters * kJobsPerSubmitter;
+
+  std::vector<uint8_t> bytes(4096);
+  for (size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<uint8_t>((i * 131) ^ (i >> 8));
+  }
+
+  // Jobs with two different keys and a mix of short and long inputs
+  const uint64_t other_key[4] = {kKey[3], kKey[2], kKey[1], kKey[0]};
+  std::vector<size_t> offsets(kNumJobs);
+  std::vector<size_t> byte_lens(kNumJobs);
+  std::vector<const uint64_t*> keys(kNumJobs);
+  std::vector<uint64_t> expected(kNumJobs);
+  for (size_t i = 0; i < kNumJobs; i++) {
+    offsets[i] = (i * 37) % 1024;
+    byte_lens[i] = (i % 50 == 0) ? 2000 + i % 1000 : i % 70;
+    keys[i] = (i % 3 == 0) ? other_key : kKey;
+    expected[i] = SimdHwyHash_Hash64(bytes.data() + offsets[i], byte_lens[i],
+                                     keys[i]);
+  }
+
+  for (size_t num_workers : {size_t{1}, size_t{3}}) {
+    for (uint64_t max_latency_ns :
+         {uint64_t{0}, uint64_t{100000}, ~uint64_t{0}}) {
+      SimdHwyHashQueue* queue =
+          SimdHwyHash_QueueCreate(num_workers, 0, 0, max_latency_ns);
+      ASSERT_NE(queue, nullptr);
+
+      std::vector<JobResult> results(kNumJobs);
+      std::vector<std::thread> submitters;
+      for (size_t t = 0; t < kNumSubmitters; t++) {
+        submitters.emplace_back([&, t] {
+          for (size_t j = 0; j < kJobsPerSubmitter; j++) {
+            const size_t i = t * kJobsPerSubmitter + j;
+            while (!SimdHwyHash_Submit(queue, bytes.data() + offsets[i],
+                                       byte_lens[i], keys[i], StoreJobResult,
+                                       &results[i])) {
+              std::this_thread::yield();
+            }
+          }
+        });
+      }
+      for (std::thread& submitter : submitters) {
+        submitter.join();
+      }
+
+      SimdHwyHash_QueueFlush(queue);
+      for (size_t i = 0; i < kNumJobs; i++) {
+        ASSERT_EQ(results[i].num_calls.load(), 1) << "i=" << i;
+        EXPECT_EQ(results[i].hash.load(), expected[i]) << "i=" << i;
+      }
+
+      // Jobs that are still pending are completed when the queue is destroyed
+      JobResult last_result;
+      ASSERT_NE(SimdHwyHash_Submit(queue, bytes.data(), 100, kKey,
+                                   StoreJobResult, &last_result),
+                0);
+      SimdHwyHash_QueueDestroy(queue);
+      EXPECT_EQ(last_result.num_calls.load(), 1);
+      EXPECT_EQ(last_result.hash.load(),
+                SimdHwyHash_Hash64(bytes.data(), 100, kKey));
+    }
+  }
+}
+
+struct BlockingJob {
+  std::atomic<bool> entered{false};
+  std::atomic<bool> release{false};
+};
+
+static void BlockUntilReleased(void* user_data, uint64_t /*hash*/) {
+  BlockingJob* job = static_cast<BlockingJob*>(user_data);
+  job->entered.store(true);
+  while (!job->release.load()) {
+    std::this_thread::yield();
+  }
+}
+
+TEST(SimdHwyHashQueueTest, TestRingFull) {
+  SimdHwyHashQueue* queue = SimdHwyHash_QueueCreate(1, 2, 1, 0);
+  ASSERT_NE(queue, nullptr);
+
+  // Keep the worker busy so that the jobs that follow stay in the ring
+  const uint8_t bytes[16] = {};
+  BlockingJob blocking_job;
+  ASSERT_NE(SimdHwyHash_Submit(queue, bytes, sizeof(bytes), kKey,
+                               BlockUntilReleased, &blocking_job),
+            0);
+  while (!blocking_job.entered.load()) {
+    std::this_thread::yield();
+  }
+
+  JobResult results[3];
+  EXPECT_NE(SimdHwyHash_Submit(queue, bytes, 1, kKey, StoreJobResult,
+                               &results[0]),
+            0);
+  EXPECT_NE(SimdHwyHash_Submit(queue, bytes, 2, kKey, StoreJobResult,
+                               &results[1]),
+            0);
+  EXPECT_EQ(SimdHwyHash_Submit(queue, bytes, 3, kKey, StoreJobResult,
+                               &results[2]),
+            0);
+
+  blocking_job.release.store(true);
+  SimdHwyHash_QueueFlush(queue);
+  EXPECT_EQ(results[0].hash.load(), SimdHwyHash_Hash64(bytes, 1, kKey));
+  EXPECT_EQ(results[1].hash.load(), SimdHwyHash_Hash64(bytes, 2, kKey));
+  EXPECT_EQ(results[2].num_calls.load(), 0);
+
+  SimdHwyHash_QueueDestroy(queue);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,212 @@
+// Copyright 2024 John Platts. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simdhwyhash_sharding.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace simdhwyhash {
+namespace test {
+namespace {
+
+static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                     0x1716151413121110U,
+                                     0x1F1E1D1C1B1A1918U};
+
+static std::vector<std::array<uint64_t, 4>> MakeNodeKeys(size_t num_nodes) {
+  std::vector<std::array<uint64_t, 4>> node_keys(num_nodes);
+  for (size_t i = 0; i < num_nodes; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      node_keys[i][j] = kKey[j] ^ ((i + 1) * 0x9E3779B97F4A7C15U * (j + 1));
+    }
+  }
+  return node_keys;
+}
+
+static const uint64_t (*NodeKeysPtr(
+    const std::vector<std::array<uint64_t, 4>>& node_keys))[4] {
+  return reinterpret_cast<const uint64_t(*)[4]>(node_keys.data());
+}
+
+TEST(SimdHwyHashShardingTest, TestRendezvousSelect) {
+  static constexpr size_t kNumNodes = 1000;
+  const auto node_keys = MakeNodeKeys(kNumNodes);
+
+  for (size_t input_idx = 0; input_idx < 50; input_idx++) {
+    const std::string input = "request-" + std::to_string(input_idx);
+
+    // Nodes in descending order of Hash64(input, node key)
+    std::vector<std::pair<uint64_t, size_t>> expected(kNumNodes);
+    for (size_t i = 0; i < kNumNodes; i++) {
+      expected[i] = {SimdHwyHash_Hash64(input.data(), input.size(),
+                                        node_keys[i].data()),
+                     i};
+    }
+    std::sort(expected.begin(), expected.end(),
+              [](const std::pair<uint64_t, size_t>& a,
+                 const std::pair<uint64_t, size_t>& b) {
+                return a.first > b.first;
+              });
+
+    for (size_t top_k : {size_t{1}, size_t{3}, size_t{100}, size_t{2000}}) {
+      std::vector<size_t> out(top_k + 1, kNumNodes);
+      const size_t num_selected = SimdHwyHash_RendezvousSelect(
+          input.data(), input.size(), NodeKeysPtr(node_keys), kNumNodes,
+          nullptr, top_k, out.data());
+      ASSERT_EQ(num_selected, std::min(top_k, kNumNodes));
+      for (size_t i = 0; i < num_selected; i++) {
+        EXPECT_EQ(out[i], expected[i].second)
+            << "input_idx=" << input_idx << ", top_k=" << top_k;
+      }
+      EXPECT_EQ(out[num_selected], kNumNodes);
+    }
+
+    // Equal weights select the same nodes as no weights
+    std::vector<double> weights(kNumNodes, 2.5);
+    size_t out[3];
+    ASSERT_EQ(SimdHwyHash_RendezvousSelect(input.data(), input.size(),
+                                           NodeKeysPtr(node_keys), kNumNodes,
+                                           weights.data(), 3, out),
+              3u);
+    for (size_t i = 0; i < 3; i++) {
+      EXPECT_EQ(out[i], expected[i].second);
+    }
+  }
+}
+
+TEST(SimdHwyHashShardingTest, TestWeightedRendezvous) {
+  static constexpr size_t kNumNodes = 4;
+  static constexpr size_t kNumInputs = 40000;
+  const auto node_keys = MakeNodeKeys(kNumNodes);
+  const double weights[kNumNodes] = {1.0, 2.0, 0.0, 1.0};
+
+  size_t counts[kNumNodes] = {};
+  for (size_t i = 0; i < kNumInputs; i++) {
+    const uint64_t input = i;
+    size_t out[kNumNodes];
+    ASSERT_EQ(SimdHwyHash_RendezvousSelect(&input, sizeof(input),
+                                           NodeKeysPtr(node_keys), kNumNodes,
+                                           weights, kNumNodes, out),
+              3u);
+    counts[out[0]]++;
+  }
+
+  // Each node is selected in proportion to its weight, and nodes with a weight
+  // of zero are never selected
+  EXPECT_NEAR(static_cast<double>(counts[0]) / kNumInputs, 0.25, 0.02);
+  EXPECT_NEAR(static_cast<double>(counts[1]) / kNumInputs, 0.5, 0.02);
+  EXPECT_EQ(counts[2], 0u);
+  EXPECT_NEAR(static_cast<double>(counts[3]) / kNumInputs, 0.25, 0.02);
+}
+
+TEST(SimdHwyHashShardingTest, TestJumpSelect) {
+  static constexpr size_t kNumInputs = 20000;
+  static constexpr uint32_t kNumBuckets = 10;
+
+  size_t counts[kNumBuckets + 1] = {};
+  for (size_t i = 0; i < kNumInputs; i++) {
+    const uint64_t input = i;
+    EXPECT_EQ(SimdHwyHash_JumpSelect(&input, sizeof(input), kKey, 1), 0u);
+
+    const uint32_t bucket =
+        SimdHwyHash_JumpSelect(&input, sizeof(input), kKey, kNumBuckets);
+    ASSERT_LT(bucket, kNumBuckets);
+    counts[bucket]++;
+
+    // Adding a bucket only moves inputs to the new bucket
+    const uint32_t next_bucket =
+        SimdHwyHash_JumpSelect(&input, sizeof(input), kKey, kNumBuckets + 1);
+    if (next_bucket != bucket) {
+      EXPECT_EQ(next_bucket, kNumBuckets);
+    }
+  }
+
+  for (uint32_t b = 0; b < kNumBuckets; b++) {
+    EXPECT_NEAR(static_cast<double>(counts[b]) / kNumInputs, 0.1, 0.015);
+  }
+}
+
+TEST(SimdHwyHashShardingTest, TestMaglev) {
+  static constexpr size_t kNumNodes = 7;
+  static constexpr size_t kTableSize = 65537;
+
+  std::vector<std::string> names(kNumNodes);
+  std::vector<const void*> name_ptrs(kNumNodes);
+  std::vector<size_t> name_lens(kNumNodes);
+  for (size_t i = 0; i < kNumNodes; i++) {
+    names[i] = "backend-" + std::to_string(i) + ".example.com";
+    name_ptrs[i] = names[i].data();
+    name_lens[i] = names[i].size();
+  }
+
+  std::vector<uint32_t> table(kTableSize);
+  ASSERT_NE(SimdHwyHash_MaglevBuild(name_ptrs.data(), name_lens.data(),
+                                    kNumNodes, kKey, table.data(), kTableSize),
+            0);
+
+  // Every node gets the same number of entries, give or take one
+  size_t counts[kNumNodes] = {};
+  for (uint32_t node : table) {
+    ASSERT_LT(node, kNumNodes);
+    counts[node]++;
+  }
+  for (size_t i = 0; i < kNumNodes; i++) {
+    EXPECT_GE(counts[i], kTableSize / kNumNodes);
+    EXPECT_LE(counts[i], kTableSize / kNumNodes + 1);
+  }
+
+  const std::string input = "session-42";
+  const uint32_t node = SimdHwyHash_MaglevSelect(
+      table.data(), kTableSize, input.data(), input.size(), kKey);
+  EXPECT_EQ(node,
+            table[SimdHwyHash_Hash64(input.data(), input.size(), kKey) %
+                  kTableSize]);
+
+  // Removing a node moves few of the entries of the other nodes
+  std::vector<uint32_t> smaller_table(kTableSize);
+  ASSERT_NE(SimdHwyHash_MaglevBuild(name_ptrs.data(), name_lens.data(),
+                                    kNumNodes - 1, kKey, smaller_table.data(),
+                                    kTableSize),
+            0);
+  size_t num_moved = 0;
+  for (size_t i = 0; i < kTableSize; i++) {
+    if (table[i] != kNumNodes - 1 && smaller_table[i] != table[i]) {
+      num_moved++;
+    }
+  }
+  EXPECT_LT(num_moved, kTableSize / 20);
+
+  // The table size must be a prime that is not smaller than the number of
+  // nodes
+  EXPECT_EQ(SimdHwyHash_MaglevBuild(name_ptrs.data(), name_lens.data(),
+                                    kNumNodes, kKey, table.data(), 65536),
+            0);
+  EXPECT_EQ(SimdHwyHash_MaglevBuild(name_ptrs.data(), name_lens.data(),
+                                    kNumNodes, kKey, table.data(), 5),
+            0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace simdhwyhash
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -16,6 +16,12 @@
 
 #include <gtest/gtest.h>
 
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
 namespace simdhwyhash {
 namespace test {
 namespace {
@@ -226,6 +232,856 @@ TEST(SimdHwyHashTest, TestHash256) {
   }
 }
 
+static inline void ComputeExpectedXof(const void* SIMDHWYHASH_RESTRICT ptr,
+                                      size_t byte_len,
+                                      const uint64_t* SIMDHWYHASH_RESTRICT key,
+                                      uint64_t* SIMDHWYHASH_RESTRICT out,
+                                      size_t num_words) {
+  static constexpr uint64_t kXofDomainAndVersion = 0x00000001464F5853U;
+
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, key);
+  SimdHwyHash_Update(&state, ptr, byte_len);
+  for (int i = 0; i < 10; i++) {
+    PermuteAndUpdateHwyHashState(&state);
+  }
+
+  for (size_t i = 0; i < num_words; i += 4) {
+    SimdHwyHashState block_state = state;
+    UpdateHwyHashState(&block_state, i / 4, kXofDomainAndVersion, i / 4,
+                       kXofDomainAndVersion);
+    for (int j = 0; j < 4; j++) {
+      PermuteAndUpdateHwyHashState(&block_state);
+    }
+
+    uint64_t block[4];
+    HwyHashModularReduction<0>(block_state.v1[1] + block_state.mul1[1],
+                               block_state.v1[0] + block_state.mul1[0],
+                               block_state.v0[1] + block_state.mul0[1],
+                               block_state.v0[0] + block_state.mul0[0], block);
+    HwyHashModularReduction<2>(block_state.v1[3] + block_state.mul1[3],
+                               block_state.v1[2] + block_state.mul1[2],
+                               block_state.v0[3] + block_state.mul0[3],
+                               block_state.v0[2] + block_state.mul0[2], block);
+    const size_t block_len = (num_words - i < 4) ? (num_words - i) : 4;
+    memcpy(out + i, block, block_len * sizeof(uint64_t));
+  }
+}
+
+TEST(SimdHwyHashTest, TestFinalizeXof) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kMaxNumWords = 21;
+
+  uint8_t data[65];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+
+  for (size_t byte_len = 0; byte_len <= 64; byte_len++) {
+    uint64_t expected[kMaxNumWords];
+    ComputeExpectedXof(data, byte_len, kKey, expected, kMaxNumWords);
+
+    // The output for fewer words is a prefix of the output for more words,
+    // and the words past num_words are not written
+    for (size_t num_words = 0; num_words <= kMaxNumWords; num_words++) {
+      uint64_t actual[kMaxNumWords + 1];
+      memset(actual, 0xA5, sizeof(actual));
+
+      SimdHwyHashState state;
+      SimdHwyHash_Reset(&state, kKey);
+      SimdHwyHash_Update(&state, data, byte_len);
+      SimdHwyHash_FinalizeXof(&state, actual, num_words);
+      for (size_t i = 0; i < num_words; i++) {
+        EXPECT_EQ(actual[i], expected[i]) << byte_len << " " << i;
+      }
+      EXPECT_EQ(actual[num_words], 0xA5A5A5A5A5A5A5A5U);
+    }
+  }
+}
+
+TEST(SimdHwyHashTest, TestRandomFill) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kNumWords = 300;
+  static constexpr uint64_t kNonce = 0x0123456789ABCDEFu;
+
+  // The stream is the little-endian encoding of the extendable output of the
+  // nonce
+  uint8_t nonce_bytes[8];
+  for (size_t i = 0; i < 8; i++) {
+    nonce_bytes[i] = static_cast<uint8_t>(kNonce >> (i * 8));
+  }
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, kKey);
+  SimdHwyHash_Update(&state, nonce_bytes, sizeof(nonce_bytes));
+  uint64_t xof_words[kNumWords];
+  SimdHwyHash_FinalizeXof(&state, xof_words, kNumWords);
+
+  uint8_t expected[kNumWords * 8];
+  for (size_t i = 0; i < kNumWords * 8; i++) {
+    expected[i] = static_cast<uint8_t>(xof_words[i / 8] >> ((i % 8) * 8));
+  }
+
+  uint8_t actual[kNumWords * 8 + 1];
+  SimdHwyHash_RandomFill(kKey, kNonce, actual, kNumWords * 8);
+  EXPECT_EQ(memcmp(actual, expected, kNumWords * 8), 0);
+
+  // Any part of the stream can be generated on its own, and nothing past its
+  // end is written
+  for (size_t offset = 0; offset < 200; offset += 7) {
+    for (size_t byte_len = 0; offset + byte_len <= kNumWords * 8;
+         byte_len += 61) {
+      memset(actual, 0xA5, sizeof(actual));
+      SimdHwyHash_RandomFillAt(kKey, kNonce, offset, actual, byte_len);
+      EXPECT_EQ(memcmp(actual, expected + offset, byte_len), 0)
+          << offset << " " << byte_len;
+      EXPECT_EQ(actual[byte_len], 0xA5);
+    }
+  }
+
+  // Other nonces give other streams
+  SimdHwyHash_RandomFill(kKey, kNonce + 1, actual, 32);
+  EXPECT_NE(memcmp(actual, expected, 32), 0);
+}
+
+TEST(SimdHwyHashTest, TestExportImportState) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+
+  uint8_t data[200];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 89u + 7u) & 0xFFu);
+  }
+
+  for (size_t tail_len = 0; tail_len < 32; tail_len += 13) {
+    static constexpr size_t kProcessedLen = 96;
+
+    SimdHwyHashState state;
+    SimdHwyHash_Reset(&state, kKey);
+    SimdHwyHash_Update(&state, data, kProcessedLen);
+
+    uint8_t blob[SIMDHWYHASH_EXPORTED_STATE_MAX_SIZE];
+    const size_t blob_len = SimdHwyHash_ExportState(
+        &state, kProcessedLen, data + kProcessedLen, tail_len, blob,
+        sizeof(blob));
+    ASSERT_NE(blob_len, 0u);
+    EXPECT_LE(blob_len, sizeof(blob));
+    EXPECT_EQ(SimdHwyHash_ExportState(&state, kProcessedLen,
+                                      data + kProcessedLen, tail_len, blob,
+                                      blob_len - 1),
+              0u);
+
+    SimdHwyHashState resumed_state;
+    uint64_t resumed_processed_len;
+    uint8_t resumed_tail[32];
+    size_t resumed_tail_len;
+    ASSERT_EQ(SimdHwyHash_ImportState(&resumed_state, &resumed_processed_len,
+                                      resumed_tail, &resumed_tail_len, blob,
+                                      blob_len),
+              blob_len);
+    EXPECT_EQ(resumed_processed_len, kProcessedLen);
+    ASSERT_EQ(resumed_tail_len, tail_len);
+    for (size_t i = 0; i < tail_len; i++) {
+      EXPECT_EQ(resumed_tail[i], data[kProcessedLen + i]);
+    }
+
+    // Resuming from the imported state gives the same hash as hashing the
+    // entire input in one pass
+    uint8_t remaining[sizeof(data)];
+    memcpy(remaining, resumed_tail, resumed_tail_len);
+    memcpy(remaining + resumed_tail_len, data + kProcessedLen + tail_len,
+           sizeof(data) - kProcessedLen - tail_len);
+    SimdHwyHash_Update(&resumed_state, remaining,
+                       sizeof(data) - kProcessedLen);
+    EXPECT_EQ(SimdHwyHash_Finalize64(&resumed_state),
+              SimdHwyHash_Hash64(data, sizeof(data), kKey));
+
+    // Truncated or corrupted blobs are rejected
+    EXPECT_EQ(SimdHwyHash_ImportState(&resumed_state, &resumed_processed_len,
+                                      resumed_tail, &resumed_tail_len, blob,
+                                      blob_len - 1),
+              0u);
+    for (size_t i = 0; i < blob_len; i += 7) {
+      blob[i] ^= 0x10;
+      EXPECT_EQ(SimdHwyHash_ImportState(&resumed_state, &resumed_processed_len,
+                                        resumed_tail, &resumed_tail_len, blob,
+                                        blob_len),
+                0u);
+      blob[i] ^= 0x10;
+    }
+  }
+
+  // Only whole packets can be absorbed into an exported state
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, kKey);
+  uint8_t blob[SIMDHWYHASH_EXPORTED_STATE_MAX_SIZE];
+  EXPECT_EQ(SimdHwyHash_ExportState(&state, 33, data, 0, blob, sizeof(blob)),
+            0u);
+  EXPECT_EQ(SimdHwyHash_ExportState(&state, 0, data, 32, blob, sizeof(blob)),
+            0u);
+}
+
+TEST(SimdHwyHashTest, TestStatePool) {
+  static constexpr size_t kNumStreams = 21;
+
+  uint8_t data[512];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 167u + 13u) & 0xFFu);
+  }
+
+  SimdHwyHashStatePool pool;
+  ASSERT_NE(SimdHwyHash_StatePoolInit(&pool, kNumStreams), 0);
+
+  SimdHwyHashState expected_states[kNumStreams];
+  for (size_t i = 0; i < kNumStreams; i++) {
+    const uint64_t key[4] = {i, i * 3 + 1, ~uint64_t{i}, uint64_t{i} << 40};
+    SimdHwyHash_Reset(&expected_states[i], key);
+    SimdHwyHash_StatePoolReset(&pool, i, key);
+  }
+
+  size_t indices[kNumStreams];
+  const void* ptrs[kNumStreams];
+  size_t byte_lens[kNumStreams];
+
+  // Feed whole packets into every stream in reverse order
+  for (size_t j = 0; j < kNumStreams; j++) {
+    const size_t idx = kNumStreams - 1 - j;
+    indices[j] = idx;
+    ptrs[j] = data + idx;
+    byte_lens[j] = (idx % 4) * 32;
+    SimdHwyHash_Update(&expected_states[idx], ptrs[j], byte_lens[j]);
+  }
+  SimdHwyHash_StatePoolUpdateMany(&pool, indices, ptrs, byte_lens,
+                                  kNumStreams);
+
+  // Feed whole packets into the odd streams only
+  size_t num_odd_streams = 0;
+  for (size_t idx = 1; idx < kNumStreams; idx += 2) {
+    indices[num_odd_streams] = idx;
+    ptrs[num_odd_streams] = data + 100 + idx;
+    byte_lens[num_odd_streams] = 64;
+    SimdHwyHash_Update(&expected_states[idx], ptrs[num_odd_streams], 64);
+    num_odd_streams++;
+  }
+  SimdHwyHash_StatePoolUpdateMany(&pool, indices, ptrs, byte_lens,
+                                  num_odd_streams);
+
+  // Feed the final bytes, including partial packets, into every stream
+  for (size_t idx = 0; idx < kNumStreams; idx++) {
+    indices[idx] = idx;
+    ptrs[idx] = data + 200 + idx;
+    byte_lens[idx] = (idx * 7) % 70;
+    SimdHwyHash_Update(&expected_states[idx], ptrs[idx], byte_lens[idx]);
+  }
+  SimdHwyHash_StatePoolUpdateMany(&pool, indices, ptrs, byte_lens,
+                                  kNumStreams);
+
+  for (size_t idx = 0; idx < kNumStreams; idx++) {
+    SimdHwyHashState actual_state;
+    SimdHwyHash_StatePoolGet(&pool, idx, &actual_state);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(actual_state.v0[i], expected_states[idx].v0[i]);
+      EXPECT_EQ(actual_state.v1[i], expected_states[idx].v1[i]);
+      EXPECT_EQ(actual_state.mul0[i], expected_states[idx].mul0[i]);
+      EXPECT_EQ(actual_state.mul1[i], expected_states[idx].mul1[i]);
+    }
+  }
+
+  uint64_t actual_hashes[kNumStreams * 4];
+
+  SimdHwyHash_StatePoolFinalizeMany64(&pool, indices, kNumStreams,
+                                      actual_hashes);
+  for (size_t idx = 0; idx < kNumStreams; idx++) {
+    SimdHwyHashState state = expected_states[idx];
+    EXPECT_EQ(actual_hashes[idx], SimdHwyHash_Finalize64(&state));
+  }
+
+  SimdHwyHash_StatePoolFinalizeMany128(&pool, indices, kNumStreams,
+                                       actual_hashes);
+  for (size_t idx = 0; idx < kNumStreams; idx++) {
+    SimdHwyHashState state = expected_states[idx];
+    uint64_t expected_hash[2];
+    SimdHwyHash_Finalize128(&state, expected_hash);
+    EXPECT_EQ(actual_hashes[idx * 2], expected_hash[0]);
+    EXPECT_EQ(actual_hashes[idx * 2 + 1], expected_hash[1]);
+  }
+
+  SimdHwyHash_StatePoolFinalizeMany256(&pool, indices, kNumStreams,
+                                       actual_hashes);
+  for (size_t idx = 0; idx < kNumStreams; idx++) {
+    SimdHwyHashState state = expected_states[idx];
+    uint64_t expected_hash[4];
+    SimdHwyHash_Finalize256(&state, expected_hash);
+    EXPECT_EQ(actual_hashes[idx * 4], expected_hash[0]);
+    EXPECT_EQ(actual_hashes[idx * 4 + 1], expected_hash[1]);
+    EXPECT_EQ(actual_hashes[idx * 4 + 2], expected_hash[2]);
+    EXPECT_EQ(actual_hashes[idx * 4 + 3], expected_hash[3]);
+  }
+
+  SimdHwyHash_StatePoolFree(&pool);
+}
+
+TEST(SimdHwyHashTest, TestHash64Batch) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kNumInputs = 23;
+
+  uint8_t data[256];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 71u + 5u) & 0xFFu);
+  }
+
+  const void* ptrs[kNumInputs];
+  size_t byte_lens[kNumInputs];
+  for (size_t i = 0; i < kNumInputs; i++) {
+    ptrs[i] = data + i * 3;
+    byte_lens[i] = (i * 29) % 100;
+  }
+
+  uint64_t hashes[kNumInputs];
+  SimdHwyHash_Hash64Batch(ptrs, byte_lens, kNumInputs, kKey, hashes);
+  for (size_t i = 0; i < kNumInputs; i++) {
+    EXPECT_EQ(hashes[i], SimdHwyHash_Hash64(ptrs[i], byte_lens[i], kKey));
+  }
+}
+
+TEST(SimdHwyHashTest, TestHash128Batch) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kNumInputs = 23;
+
+  uint8_t data[256];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 71u + 5u) & 0xFFu);
+  }
+
+  const void* ptrs[kNumInputs];
+  size_t byte_lens[kNumInputs];
+  for (size_t i = 0; i < kNumInputs; i++) {
+    ptrs[i] = data + i * 3;
+    byte_lens[i] = (i * 29) % 100;
+  }
+
+  uint64_t hashes[kNumInputs * 2];
+  SimdHwyHash_Hash128Batch(ptrs, byte_lens, kNumInputs, kKey, hashes);
+  for (size_t i = 0; i < kNumInputs; i++) {
+    uint64_t expected[2];
+    SimdHwyHash_Hash128(ptrs[i], byte_lens[i], kKey, expected);
+    EXPECT_EQ(hashes[i * 2], expected[0]);
+    EXPECT_EQ(hashes[i * 2 + 1], expected[1]);
+  }
+}
+
+TEST(SimdHwyHashTest, TestHashU64Keys64) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kNumKeys = 37;
+
+  uint64_t keys[kNumKeys];
+  for (size_t i = 0; i < kNumKeys; i++) {
+    keys[i] = (uint64_t{i} * 0x9E3779B97F4A7C15u) ^ (uint64_t{i} << 56);
+  }
+
+  for (size_t num_keys = 0; num_keys <= kNumKeys; num_keys++) {
+    uint64_t hashes[kNumKeys + 1];
+    hashes[num_keys] = 0x0123456789ABCDEFu;
+    SimdHwyHash_HashU64Keys64(keys, num_keys, kKey, hashes);
+
+    for (size_t i = 0; i < num_keys; i++) {
+      uint8_t key_bytes[8];
+      for (size_t j = 0; j < 8; j++) {
+        key_bytes[j] = static_cast<uint8_t>(keys[i] >> (j * 8));
+      }
+      EXPECT_EQ(hashes[i], SimdHwyHash_Hash64(key_bytes, 8, kKey));
+    }
+    EXPECT_EQ(hashes[num_keys], 0x0123456789ABCDEFu);
+  }
+}
+
+TEST(SimdHwyHashTest, TestHashMultiKey64) {
+  static constexpr size_t kNumKeys = 67;
+
+  uint64_t keys[kNumKeys][4];
+  for (size_t i = 0; i < kNumKeys; i++) {
+    keys[i][0] = uint64_t{i} * 0x9E3779B97F4A7C15u;
+    keys[i][1] = ~uint64_t{i};
+    keys[i][2] = uint64_t{i} << 33;
+    keys[i][3] = uint64_t{i} * 3 + 1;
+  }
+
+  uint8_t data[100];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 53u + 29u) & 0xFFu);
+  }
+
+  for (size_t byte_len = 0; byte_len <= sizeof(data); byte_len++) {
+    for (size_t num_keys = 0; num_keys <= kNumKeys; num_keys += 3) {
+      uint64_t hashes[kNumKeys];
+      SimdHwyHash_HashMultiKey64(data, byte_len, keys, num_keys, hashes);
+      for (size_t i = 0; i < num_keys; i++) {
+        EXPECT_EQ(hashes[i], SimdHwyHash_Hash64(data, byte_len, keys[i]));
+      }
+    }
+  }
+}
+
+// Checks SimdHwyHash_HashRecords64 against splitting data one byte at a time
+// and hashing each record with SimdHwyHash_Hash64
+static void CheckHashRecords64(const std::string& data, uint8_t delimiter,
+                               unsigned flags) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  const bool csv = (flags & SIMDHWYHASH_RECORDS_CSV) != 0;
+
+  std::vector<size_t> expected_begins;
+  std::vector<size_t> expected_ends;
+  size_t record_begin = 0;
+  bool quoted = false;
+  for (size_t i = 0; i < data.size(); i++) {
+    const uint8_t c = static_cast<uint8_t>(data[i]);
+    if (csv && c == '"') {
+      quoted = !quoted;
+    } else if (!quoted && (c == delimiter || (csv && c == '\n'))) {
+      expected_begins.push_back(record_begin);
+      expected_ends.push_back(i);
+      record_begin = i + 1;
+    }
+  }
+  if (record_begin < data.size()) {
+    expected_begins.push_back(record_begin);
+    expected_ends.push_back(data.size());
+  }
+
+  const size_t num_records = expected_begins.size();
+  std::vector<uint64_t> hashes(num_records + 1);
+  std::vector<size_t> offsets((num_records + 1) * 2);
+  ASSERT_EQ(SimdHwyHash_HashRecords64(
+                data.data(), data.size(), delimiter, flags, kKey,
+                hashes.data(),
+                reinterpret_cast<size_t(*)[2]>(offsets.data()),
+                num_records + 1),
+            num_records);
+  for (size_t i = 0; i < num_records; i++) {
+    EXPECT_EQ(offsets[i * 2], expected_begins[i]) << i;
+    EXPECT_EQ(offsets[i * 2 + 1], expected_ends[i]) << i;
+    EXPECT_EQ(hashes[i],
+              SimdHwyHash_Hash64(data.data() + expected_begins[i],
+                                 expected_ends[i] - expected_begins[i], kKey))
+        << i;
+  }
+
+  // A caller that runs out of room resumes after the end of the last record,
+  // and the offsets may be omitted
+  for (size_t max_records = 1; max_records < num_records; max_records += 7) {
+    ASSERT_EQ(SimdHwyHash_HashRecords64(data.data(), data.size(), delimiter,
+                                        flags, kKey, hashes.data(), nullptr,
+                                        max_records),
+              max_records);
+    for (size_t i = 0; i < max_records; i++) {
+      EXPECT_EQ(hashes[i],
+                SimdHwyHash_Hash64(data.data() + expected_begins[i],
+                                   expected_ends[i] - expected_begins[i],
+                                   kKey));
+    }
+  }
+}
+
+TEST(SimdHwyHashTest, TestHashRecords64) {
+  // Records of many lengths, including empty records and records that are
+  // long enough to be hashed one at a time
+  std::string lines;
+  for (size_t i = 0; i < 90; i++) {
+    const size_t line_len = (i % 11 == 0) ? 0 : (i * 37) % 300;
+    for (size_t j = 0; j < line_len; j++) {
+      lines.push_back(static_cast<char>('a' + (i + j) % 26));
+    }
+    lines.push_back('\n');
+  }
+
+  CheckHashRecords64("", '\n', 0);
+  CheckHashRecords64("\n", '\n', 0);
+  CheckHashRecords64("abc", '\n', 0);
+  for (size_t len = 0; len <= 200; len++) {
+    CheckHashRecords64(lines.substr(0, len), '\n', 0);
+  }
+  CheckHashRecords64(lines, '\n', 0);
+  CheckHashRecords64(lines + "unterminated", '\n', 0);
+  CheckHashRecords64(lines, 'e', 0);
+  CheckHashRecords64(lines.substr(5), '\n', SIMDHWYHASH_RECORDS_CSV);
+
+  // Quoted fields that contain delimiters and newlines, some of which span
+  // the 64-byte blocks that the delimiters are found in
+  std::string csv;
+  for (size_t i = 0; i < 200; i++) {
+    if (i % 3 == 0) {
+      csv += '"';
+      for (size_t j = 0; j < (i * 13) % 90; j++) {
+        csv.push_back("ab,\n\"\"c"[j % 7]);
+      }
+      csv += '"';
+    } else {
+      csv += std::to_string(i * 7919);
+    }
+    csv += (i % 5 == 4) ? "\r\n" : ",";
+  }
+  for (size_t len = 0; len <= csv.size(); len += 61) {
+    CheckHashRecords64(csv.substr(0, len), ',', SIMDHWYHASH_RECORDS_CSV);
+  }
+  CheckHashRecords64(csv, ',', SIMDHWYHASH_RECORDS_CSV);
+  CheckHashRecords64(csv, ';', SIMDHWYHASH_RECORDS_CSV);
+  CheckHashRecords64(csv, ',', 0);
+}
+
+TEST(SimdHwyHashTest, TestVerifyBatch128) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kNumPackets = 37;
+
+  std::vector<std::vector<uint8_t>> packets(kNumPackets);
+  const void* ptrs[kNumPackets];
+  size_t byte_lens[kNumPackets];
+  uint64_t tags[kNumPackets][2];
+  for (size_t i = 0; i < kNumPackets; i++) {
+    packets[i].resize(i * 11);
+    for (size_t j = 0; j < packets[i].size(); j++) {
+      packets[i][j] = static_cast<uint8_t>((i * 131u + j * 7u) & 0xFFu);
+    }
+    ptrs[i] = packets[i].data();
+    byte_lens[i] = packets[i].size();
+    SimdHwyHash_Hash128(ptrs[i], byte_lens[i], kKey, tags[i]);
+  }
+
+  // Corrupt either word of the tags of some of the packets
+  for (size_t i = 0; i < kNumPackets; i += 5) {
+    tags[i][i & 1] ^= uint64_t{1} << (i % 64);
+  }
+
+  for (size_t num_packets = 0; num_packets <= kNumPackets; num_packets++) {
+    uint8_t ok_bitmap[(kNumPackets + 7) / 8 + 1];
+    memset(ok_bitmap, 0xFF, sizeof(ok_bitmap));
+
+    size_t expected_num_passed = 0;
+    for (size_t i = 0; i < num_packets; i++) {
+      expected_num_passed += (i % 5 != 0) ? 1 : 0;
+    }
+    EXPECT_EQ(SimdHwyHash_VerifyBatch128(ptrs, byte_lens, num_packets, kKey,
+                                         tags, ok_bitmap),
+              expected_num_passed);
+
+    for (size_t i = 0; i < (num_packets + 7) / 8 * 8; i++) {
+      const bool passed = ((ok_bitmap[i / 8] >> (i % 8)) & 1) != 0;
+      EXPECT_EQ(passed, i < num_packets && i % 5 != 0)
+          << "num_packets=" << num_packets << ", i=" << i;
+    }
+
+    // Bytes past the end of the bitmap are not written
+    EXPECT_EQ(ok_bitmap[(num_packets + 7) / 8], 0xFFu);
+  }
+}
+
+TEST(SimdHwyHashTest, TestPaddedInput) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+
+  uint8_t data[100 + SIMDHWYHASH_INPUT_PADDING];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>((i * 53u + 29u) & 0xFFu);
+  }
+
+  for (size_t byte_len = 0; byte_len <= 100; byte_len++) {
+    // The padding bytes must not affect the hash
+    for (size_t i = byte_len; i < sizeof(data); i++) {
+      data[i] = static_cast<uint8_t>(0xA5u ^ i);
+    }
+
+    EXPECT_EQ(SimdHwyHash_Hash64Padded(data, byte_len, kKey),
+              SimdHwyHash_Hash64(data, byte_len, kKey));
+
+    uint64_t expected[4];
+    uint64_t actual[4];
+    SimdHwyHash_Hash128(data, byte_len, kKey, expected);
+    SimdHwyHash_Hash128Padded(data, byte_len, kKey, actual);
+    EXPECT_EQ(actual[0], expected[0]);
+    EXPECT_EQ(actual[1], expected[1]);
+
+    SimdHwyHash_Hash256(data, byte_len, kKey, expected);
+    SimdHwyHash_Hash256Padded(data, byte_len, kKey, actual);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(actual[i], expected[i]);
+    }
+
+    data[byte_len] = static_cast<uint8_t>((byte_len * 53u + 29u) & 0xFFu);
+  }
+}
+
+TEST(SimdHwyHashTest, TestShortInputs) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+
+  // The one-shot hash functions hash inputs of fewer than 64 bytes with
+  // kernels that are specialized for the length class of the input, and these
+  // must give the same results as the streaming functions for every length.
+  // Each input is placed at the end of a buffer of exactly its size so that
+  // any read past the end of the input is caught by sanitizers.
+  for (size_t byte_len = 0; byte_len <= 128; byte_len++) {
+    for (size_t offset = 0; offset < 4; offset++) {
+      std::vector<uint8_t> buffer(offset + byte_len);
+      for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] = static_cast<uint8_t>((i * 71u + byte_len * 13u) & 0xFFu);
+      }
+      const uint8_t* data = buffer.data() + offset;
+
+      SimdHwyHashState expected_state;
+      SimdHwyHash_Reset(&expected_state, kKey);
+      SimdHwyHash_Update(&expected_state, data, byte_len);
+
+      SimdHwyHashState state = expected_state;
+      const uint64_t expected_hash64 = SimdHwyHash_Finalize64(&state);
+      EXPECT_EQ(SimdHwyHash_Hash64(data, byte_len, kKey), expected_hash64)
+          << "byte_len=" << byte_len << ", offset=" << offset;
+
+      uint64_t expected_hash[4];
+      uint64_t actual_hash[4];
+      state = expected_state;
+      SimdHwyHash_Finalize128(&state, expected_hash);
+      SimdHwyHash_Hash128(data, byte_len, kKey, actual_hash);
+      EXPECT_EQ(actual_hash[0], expected_hash[0]);
+      EXPECT_EQ(actual_hash[1], expected_hash[1]);
+
+      state = expected_state;
+      SimdHwyHash_Finalize256(&state, expected_hash);
+      SimdHwyHash_Hash256(data, byte_len, kKey, actual_hash);
+      for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(actual_hash[i], expected_hash[i]);
+      }
+
+      // The padded variants use the same kernels for short inputs
+      std::vector<uint8_t> padded(byte_len + SIMDHWYHASH_INPUT_PADDING, 0xA5);
+      if (byte_len != 0) {
+        memcpy(padded.data(), data, byte_len);
+      }
+      EXPECT_EQ(SimdHwyHash_Hash64Padded(padded.data(), byte_len, kKey),
+                expected_hash64);
+      SimdHwyHash_Hash256Padded(padded.data(), byte_len, kKey, actual_hash);
+      for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(actual_hash[i], expected_hash[i]);
+      }
+    }
+  }
+}
+
+TEST(SimdHwyHashTest, TestLargeInput) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kChunkLen = 4096;
+
+  // Large enough to be hashed with prefetching, with a partial final packet
+  std::vector<uint8_t> data((size_t{1} << 20) + 45);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>((i * 131u + (i >> 12)) & 0xFFu);
+  }
+
+  // Hashing the input in chunks that are below the large input threshold
+  // must give the same result as hashing it in a single update
+  SimdHwyHashState chunked_state;
+  SimdHwyHash_Reset(&chunked_state, kKey);
+  size_t offset = 0;
+  for (; data.size() - offset > kChunkLen; offset += kChunkLen) {
+    SimdHwyHash_Update(&chunked_state, data.data() + offset, kChunkLen);
+  }
+  SimdHwyHash_Update(&chunked_state, data.data() + offset,
+                     data.size() - offset);
+
+  SimdHwyHashState state = chunked_state;
+  EXPECT_EQ(SimdHwyHash_Hash64(data.data(), data.size(), kKey),
+            SimdHwyHash_Finalize64(&state));
+
+  uint64_t expected_hash[4];
+  uint64_t actual_hash[4];
+
+  state = chunked_state;
+  SimdHwyHash_Finalize128(&state, expected_hash);
+  SimdHwyHash_Hash128(data.data(), data.size(), kKey, actual_hash);
+  EXPECT_EQ(actual_hash[0], expected_hash[0]);
+  EXPECT_EQ(actual_hash[1], expected_hash[1]);
+
+  state = chunked_state;
+  SimdHwyHash_Finalize256(&state, expected_hash);
+  SimdHwyHash_Hash256(data.data(), data.size(), kKey, actual_hash);
+  EXPECT_EQ(actual_hash[0], expected_hash[0]);
+  EXPECT_EQ(actual_hash[1], expected_hash[1]);
+  EXPECT_EQ(actual_hash[2], expected_hash[2]);
+  EXPECT_EQ(actual_hash[3], expected_hash[3]);
+}
+
+TEST(SimdHwyHashTest, TestCopyAndHash) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+
+  // Large enough for the largest input to be hashed with prefetching
+  std::vector<uint8_t> src((size_t{1} << 19) + 45);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = static_cast<uint8_t>((i * 97u + (i >> 9)) & 0xFFu);
+  }
+  std::vector<uint8_t> dst(src.size() + 64);
+
+  // Destinations at every offset from a 32-byte boundary must be copied, with
+  // or without non-temporal stores
+  const size_t misalignment = reinterpret_cast<uintptr_t>(dst.data()) & 31u;
+  uint8_t* aligned_dst = dst.data() + ((32u - misalignment) & 31u);
+  for (size_t byte_len :
+       {size_t{0}, size_t{1}, size_t{31}, size_t{32}, size_t{33}, size_t{100},
+        size_t{4096}, src.size()}) {
+    for (size_t dst_offset : {size_t{0}, size_t{1}, size_t{16}, size_t{31}}) {
+      for (unsigned flags : {0u, SIMDHWYHASH_COPY_NON_TEMPORAL}) {
+        memset(dst.data(), 0, dst.size());
+        uint8_t* dst_ptr = aligned_dst + dst_offset;
+
+        EXPECT_EQ(
+            SimdHwyHash_CopyAndHash64(dst_ptr, src.data(), byte_len, kKey,
+                                      flags),
+            SimdHwyHash_Hash64(src.data(), byte_len, kKey))
+            << "byte_len=" << byte_len << ", dst_offset=" << dst_offset;
+        ASSERT_EQ(memcmp(dst_ptr, src.data(), byte_len), 0)
+            << "byte_len=" << byte_len << ", dst_offset=" << dst_offset;
+        EXPECT_EQ(dst_ptr[byte_len], 0u);
+
+        uint64_t expected[4];
+        uint64_t actual[4];
+        SimdHwyHash_Hash128(src.data(), byte_len, kKey, expected);
+        SimdHwyHash_CopyAndHash128(dst_ptr, src.data(), byte_len, kKey, flags,
+                                   actual);
+        EXPECT_EQ(actual[0], expected[0]);
+        EXPECT_EQ(actual[1], expected[1]);
+
+        SimdHwyHash_Hash256(src.data(), byte_len, kKey, expected);
+        SimdHwyHash_CopyAndHash256(dst_ptr, src.data(), byte_len, kKey, flags,
+                                   actual);
+        for (size_t i = 0; i < 4; i++) {
+          EXPECT_EQ(actual[i], expected[i]);
+        }
+      }
+    }
+  }
+
+  // Copying in chunks that are multiples of 32 bytes gives the same hash and
+  // copy as a single call
+  SimdHwyHashState state;
+  SimdHwyHash_Reset(&state, kKey);
+  size_t offset = 0;
+  for (size_t chunk_len = 32; src.size() - offset > chunk_len;
+       chunk_len += 32) {
+    SimdHwyHash_CopyAndUpdate(&state, dst.data() + offset, src.data() + offset,
+                              chunk_len, 0);
+    offset += chunk_len;
+  }
+  SimdHwyHash_CopyAndUpdate(&state, dst.data() + offset, src.data() + offset,
+                            src.size() - offset, 0);
+  EXPECT_EQ(SimdHwyHash_Finalize64(&state),
+            SimdHwyHash_Hash64(src.data(), src.size(), kKey));
+  EXPECT_EQ(memcmp(dst.data(), src.data(), src.size()), 0);
+}
+
+TEST(SimdHwyHashTest, TestAutotune) {
+  static constexpr uint64_t kKey[4] = {0x0706050403020100U, 0x0F0E0D0C0B0A0908U,
+                                       0x1716151413121110U,
+                                       0x1F1E1D1C1B1A1918U};
+  static constexpr size_t kLens[] = {0,   1,   15,  16,   17,   33,    64,
+                                     100, 255, 600, 1024, 3000, 10000, 70000};
+
+  std::vector<uint8_t> data(70000 + SIMDHWYHASH_INPUT_PADDING);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>((i * 97u + (i >> 9)) & 0xFFu);
+  }
+
+  std::vector<uint64_t> expected;
+  for (size_t byte_len : kLens) {
+    EXPECT_EQ(SimdHwyHash_AutotunedTarget(byte_len), 0);
+    uint64_t hash[4];
+    expected.push_back(SimdHwyHash_Hash64(data.data(), byte_len, kKey));
+    SimdHwyHash_Hash128(data.data(), byte_len, kKey, hash);
+    expected.insert(expected.end(), hash, hash + 2);
+    SimdHwyHash_Hash256(data.data(), byte_len, kKey, hash);
+    expected.insert(expected.end(), hash, hash + 4);
+  }
+
+  const std::string cache_path =
+      testing::TempDir() + "simdhwyhash_autotune_test.cache";
+  remove(cache_path.c_str());
+
+  // The first call measures the kernels and writes the cache, and the second
+  // call reads the same results back from the cache
+  ASSERT_EQ(SimdHwyHash_Autotune(cache_path.c_str()), 1);
+  std::vector<int64_t> tuned_targets;
+  for (size_t byte_len : kLens) {
+    const int64_t target = SimdHwyHash_AutotunedTarget(byte_len);
+    EXPECT_NE(target, 0);
+    EXPECT_EQ(target & (target - 1), 0);
+    tuned_targets.push_back(target);
+  }
+
+  ASSERT_EQ(SimdHwyHash_Autotune(cache_path.c_str()), 2);
+  for (size_t i = 0; i < sizeof(kLens) / sizeof(kLens[0]); i++) {
+    EXPECT_EQ(SimdHwyHash_AutotunedTarget(kLens[i]), tuned_targets[i]);
+  }
+
+  // The tuned kernels must give the same hashes as the default ones
+  size_t expected_idx = 0;
+  for (size_t byte_len : kLens) {
+    uint64_t hash[4];
+    EXPECT_EQ(SimdHwyHash_Hash64(data.data(), byte_len, kKey),
+              expected[expected_idx]);
+    EXPECT_EQ(SimdHwyHash_Hash64Padded(data.data(), byte_len, kKey),
+              expected[expected_idx]);
+    expected_idx++;
+
+    SimdHwyHash_Hash128(data.data(), byte_len, kKey, hash);
+    EXPECT_EQ(hash[0], expected[expected_idx]);
+    EXPECT_EQ(hash[1], expected[expected_idx + 1]);
+    SimdHwyHash_Hash128Padded(data.data(), byte_len, kKey, hash);
+    EXPECT_EQ(hash[0], expected[expected_idx]);
+    EXPECT_EQ(hash[1], expected[expected_idx + 1]);
+    expected_idx += 2;
+
+    SimdHwyHash_Hash256(data.data(), byte_len, kKey, hash);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(hash[i], expected[expected_idx + i]);
+    }
+    SimdHwyHash_Hash256Padded(data.data(), byte_len, kKey, hash);
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(hash[i], expected[expected_idx + i]);
+    }
+    expected_idx += 4;
+  }
+
+  // A cache that is not valid is measured again
+  FILE* file = fopen(cache_path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  fputs("simdhwyhash-autotune 1 0\n", file);
+  fclose(file);
+  EXPECT_EQ(SimdHwyHash_Autotune(cache_path.c_str()), 1);
+  EXPECT_EQ(SimdHwyHash_Autotune(nullptr), 1);
+  remove(cache_path.c_str());
+
+  SimdHwyHash_AutotuneReset();
+  for (size_t byte_len : kLens) {
+    EXPECT_EQ(SimdHwyHash_AutotunedTarget(byte_len), 0);
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace simdhwyhash